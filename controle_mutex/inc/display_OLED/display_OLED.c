@@ -3,49 +3,39 @@
 // Estrutura do display OLED
 ssd1306_t ssd;
 
-// Buffer do OLED
-uint8_t ssd_buffer[ssd1306_buffer_length];
-struct render_area frame_area = {
-    .start_column = 0,
-    .end_column = ssd1306_width - 1,
-    .start_page = 0,
-    .end_page = ssd1306_n_pages - 1};
-
 // Display de mensagem no OLED
 void display_mensagem(const char *linha1, const char *linha2, const char *linha3, bool limpar)
 {
     if (limpar)
     {
-        memset(ssd_buffer, 0, ssd1306_buffer_length);
+        ssd1306_clear(&ssd);
     }
 
     int pos_x = 0; // Iniciar o texto desde o começo da tela
 
-    ssd1306_draw_string(ssd_buffer, pos_x, 0, (char *)linha1);
-    ssd1306_draw_string(ssd_buffer, pos_x, 8, (char *)linha2);
-    ssd1306_draw_string(ssd_buffer, pos_x, 16, (char *)linha3);
-    // ssd1306_draw_string(ssd_buffer, pos_x, 24, (char *)linha4);
-    // ssd1306_draw_string(ssd_buffer, pos_x, 32, (char *)linha5);
-    // ssd1306_draw_string(ssd_buffer, pos_x, 40, (char *)linha6);
-    // ssd1306_draw_string(ssd_buffer, pos_x, 48, (char *)linha7);
-    // ssd1306_draw_string(ssd_buffer, pos_x, 56, (char *)linha8);
-
-    render_on_display(ssd_buffer, &frame_area);
+    ssd1306_draw_string(&ssd, pos_x, 0, 1, linha1);
+    ssd1306_draw_string(&ssd, pos_x, 8, 1, linha2);
+    ssd1306_draw_string(&ssd, pos_x, 16, 1, linha3);
+    // ssd1306_draw_string(&ssd, pos_x, 24, 1, linha4);
+    // ssd1306_draw_string(&ssd, pos_x, 32, 1, linha5);
+    // ssd1306_draw_string(&ssd, pos_x, 40, 1, linha6);
+    // ssd1306_draw_string(&ssd, pos_x, 48, 1, linha7);
+    // ssd1306_draw_string(&ssd, pos_x, 56, 1, linha8);
+
+    // Envia apenas as colunas que mudaram desde o último envio
+    ssd1306_show(&ssd);
 }
 
 // Inicialização do display OLED
 void inicializacao_display()
 {
-    i2c_init(i2c1, ssd1306_i2c_clock * 5000);
+    i2c_init(i2c1, 400 * 5000);
     gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
     gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
     gpio_pull_up(I2C_SDA);
     gpio_pull_up(I2C_SCL);
-    ssd1306_init();
+    ssd1306_init(&ssd, DISPLAY_OLED_LARGURA, DISPLAY_OLED_ALTURA, DISPLAY_OLED_ENDERECO, i2c1);
 
-    // Calcular a área de renderização
-    calculate_render_area_buffer_length(&frame_area);
-
-    memset(ssd_buffer, 0, ssd1306_buffer_length);
-    render_on_display(ssd_buffer, &frame_area);
-}
\ No newline at end of file
+    ssd1306_clear(&ssd);
+    ssd1306_show(&ssd);
+}
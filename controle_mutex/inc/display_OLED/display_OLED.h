@@ -6,18 +6,19 @@
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
-#include "inc/display_OLED/ssd1306.h"
+#include "ssd1306.h"
 
 // Definição do pino SDA e SCL do display OLED
 #define I2C_SDA 14
 #define I2C_SCL 15
 
-// Estrutura do display OLED
-extern ssd1306_t ssd;
+// Endereço I2C e dimensões do display OLED
+#define DISPLAY_OLED_ENDERECO 0x3C
+#define DISPLAY_OLED_LARGURA 128
+#define DISPLAY_OLED_ALTURA 64
 
-// Buffer do OLED
-extern uint8_t ssd_buffer[];
-extern struct render_area frame_area;
+// Estrutura do display OLED, com o buffer e a área alterada desde o último envio
+extern ssd1306_t ssd;
 
 // Display de mensagem no OLED
 void display_mensagem(const char *linha1, const char *linha2, const char *linha3, bool limpar);
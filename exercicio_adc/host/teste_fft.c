@@ -0,0 +1,82 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils/fft/fft.h"
+
+/*
+    Teste da FFT em ponto fixo no computador: compara fft_q15 com uma DFT em ponto flutuante,
+    dividida pelo tamanho como a saída da FFT, para sinais conhecidos e ruído.
+    A cada estágio a FFT trunca o resultado em até 1 LSB, então o erro tolerado cresce com o
+    número de estágios: TOLERANCIA_LSB por estágio.
+*/
+
+#define TOLERANCIA_LSB 1.0
+
+static int16_t real[FFT_TAMANHO_MAX], imag[FFT_TAMANHO_MAX];
+static double ref_real[FFT_TAMANHO_MAX], ref_imag[FFT_TAMANHO_MAX];
+
+// Função para calcular a DFT de referência da entrada atual, dividida pelo tamanho
+static void dft_referencia(uint16_t tamanho) {
+    for (uint16_t k = 0; k < tamanho; k++) {
+        double soma_real = 0, soma_imag = 0;
+        for (uint16_t n = 0; n < tamanho; n++) {
+            double angulo = -2.0 * M_PI * k * n / tamanho;
+            soma_real += real[n] * cos(angulo) - imag[n] * sin(angulo);
+            soma_imag += real[n] * sin(angulo) + imag[n] * cos(angulo);
+        }
+        ref_real[k] = soma_real / tamanho;
+        ref_imag[k] = soma_imag / tamanho;
+    }
+}
+
+// Função para comparar a FFT da entrada atual com a referência, retorna 1 se passou
+static int comparar(const char *nome, uint8_t log2_tamanho) {
+    uint16_t tamanho = 1u << log2_tamanho;
+    dft_referencia(tamanho);
+    fft_q15(real, imag, log2_tamanho);
+
+    double erro_max = 0;
+    for (uint16_t k = 0; k < tamanho; k++) {
+        double erro = fmax(fabs(real[k] - ref_real[k]), fabs(imag[k] - ref_imag[k]));
+        if (erro > erro_max) erro_max = erro;
+    }
+    double tolerancia = TOLERANCIA_LSB * log2_tamanho;
+    int passou = erro_max <= tolerancia;
+    printf("%-8s N=%3u: erro máximo %.2f LSB (tolerância %.0f) %s\n",
+           nome, tamanho, erro_max, tolerancia, passou ? "ok" : "FALHOU");
+    return passou;
+}
+
+int main() {
+    fft_inicializar();
+    int falhas = 0;
+    srand(1);
+
+    for (uint8_t log2_tamanho = 3; (1u << log2_tamanho) <= FFT_TAMANHO_MAX; log2_tamanho++) {
+        uint16_t tamanho = 1u << log2_tamanho;
+
+        // Senoide de amplitude quase máxima no bin 3, com nível contínuo
+        for (uint16_t n = 0; n < tamanho; n++) {
+            real[n] = (int16_t)lround(20000.0 * sin(2.0 * M_PI * 3 * n / tamanho) + 4000.0);
+            imag[n] = 0;
+        }
+        falhas += !comparar("senoide", log2_tamanho);
+
+        // Impulso: espectro plano
+        for (uint16_t n = 0; n < tamanho; n++) {
+            real[n] = n ? 0 : 32767;
+            imag[n] = 0;
+        }
+        falhas += !comparar("impulso", log2_tamanho);
+
+        // Ruído em toda a faixa, parte real e imaginária
+        for (uint16_t n = 0; n < tamanho; n++) {
+            real[n] = (int16_t)(rand() % 65536 - 32768);
+            imag[n] = (int16_t)(rand() % 65536 - 32768);
+        }
+        falhas += !comparar("ruido", log2_tamanho);
+    }
+
+    printf("%s\n", falhas ? "FFT fora da tolerância" : "FFT dentro da tolerância");
+    return falhas ? 1 : 0;
+}
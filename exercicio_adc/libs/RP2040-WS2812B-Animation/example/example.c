@@ -10,8 +10,8 @@
 #include "spritesheet_beachball_8x8.h"
 #include "spritesheet_bird_8x8.h"
 #include "spritesheet_dancer_8x8.h"
-#include "spritesheet_flame_8x8.h"
-#include "spritesheet_ghost_8x8.h"
+#include "spritesheet_flame_8x8_packed.h"
+#include "spritesheet_ghost_8x8_packed.h"
 #include "spritesheet_heart_8x8.h"
 #include "spritesheet_ripple_8x8.h"
 #include "spritesheet_tribal_8x8.h"
@@ -150,8 +150,17 @@ int main() {
     // Remove the mask
     ws2812b_clear_mask();
 
+    // FX_FIRE, FX_PLASMA and FX_NOISE are generated on the fly, using the colors
+    // as a gradient. The last parameter is the duration of a loop in steps.
+    FX_t* animation_fire = ws2812b_animate(0, NUM_PIXELS-1, FX_FIRE, colors_fire, 2, 0);
+    while (animation_fire->running){ sleep_ms(10); }
+
+    FX_t* animation_plasma = ws2812b_animate(0, NUM_PIXELS-1, FX_PLASMA, colors_rainbow, 1, 0);
+    while (animation_plasma->running){ sleep_ms(10); }
+
     ws2812b_config_set_fps(50);
-    // You can run up to four concurrent animations. Don't cross the streams
+    // You can run as many concurrent animations as memory allows.
+    // Each one draws into its own layer, composited in z order.
     uint16_t seg_len = NUM_PIXELS/4;
     FX_t* segment_1 = ws2812b_animate(seg_len, 0, FX_SCAN, colors_cyan_black, 16, false);
     FX_t* segment_2 = ws2812b_animate(seg_len+1, seg_len*2, FX_WIPE, colors_yellow_black, 16, false);
@@ -159,9 +168,14 @@ int main() {
     FX_t* segment_4 = ws2812b_animate(seg_len*3+1, NUM_PIXELS-1, FX_RANDOM, colors_cmyk, 8, 12);
     // Each segment can have its own framerate:
     ws2812b_set_fps(segment_4, 40);
+    // Overlapping segments are blended by z order and blend mode.
+    // This one is drawn on top of the first three, at half opacity:
+    FX_t* overlay = ws2812b_animate(0, NUM_PIXELS-1, FX_CHASER, colors_rgb, 16, 3);
+    ws2812b_set_z(overlay, 1);
+    ws2812b_set_blend(overlay, FX_BLEND_ALPHA, 128);
 
     while (segment_1->running || segment_2->running || segment_3->running
-                              || segment_4->running ){ sleep_ms(10); }
+                              || segment_4->running || overlay->running ){ sleep_ms(10); }
 
     // Simple typing, one character at a time.
     // Many languages are supported, check the documentation for CP0-EU.
@@ -209,14 +223,16 @@ int main() {
     while (bird_animation->running){ sleep_ms(10); }
 
     // The third parameter is the delay between frames in ms. Smaller delay means faster animations.
-    FX_t* flame_animation = ws2812b_spritesheet(SPRITESHEET_FLAME_8X8, 4, 100, 8);
+    // Packed spritesheets (see tools/img2grb.py --sheet) take a fraction of the flash
+    // and carry their own number of frames.
+    FX_t* flame_animation = ws2812b_spritesheet_packed(&SHEET_FLAME_8X8, 100, 8);
     while (flame_animation->running){ sleep_ms(10); }
 
     // The last parameter is the number of loops.
     FX_t* dancer_animation = ws2812b_spritesheet(SPRITESHEET_DANCER_8X8, 4, 200, 3);
     while (dancer_animation->running){ sleep_ms(10); }
 
-    FX_t* ghost_animation = ws2812b_spritesheet(SPRITESHEET_GHOST_8X8, 6, 200, 3);
+    FX_t* ghost_animation = ws2812b_spritesheet_packed(&SHEET_GHOST_8X8, 200, 3);
     while (ghost_animation->running){ sleep_ms(10); }
 
     FX_t* heart_animation = ws2812b_spritesheet(SPRITESHEET_HEART_8X8, 3, 200, 3);
@@ -0,0 +1,11 @@
+/**
+ * @file clocks.h
+ * @brief Host build: nothing is needed from the clocks.
+ */
+
+#ifndef WS2812B_HOST_HARDWARE_CLOCKS_H
+#define WS2812B_HOST_HARDWARE_CLOCKS_H
+
+#include "pico.h"
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * @file pio.h
+ * @brief Host build: the PIO state machine feeding the strip, captured by ws2812b_host.c.
+ */
+
+#ifndef WS2812B_HOST_HARDWARE_PIO_H
+#define WS2812B_HOST_HARDWARE_PIO_H
+
+#include "pico.h"
+
+typedef struct pio_hw { int index; } pio_hw_t;
+typedef pio_hw_t *PIO;
+typedef struct pio_program { int unused; } pio_program_t;
+
+extern pio_hw_t ws2812b_host_pio[2];
+#define pio0 (&ws2812b_host_pio[0])
+#define pio1 (&ws2812b_host_pio[1])
+
+int pio_claim_unused_sm(PIO pio, bool required);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file pico.h
+ * @brief Host build: the few Pico SDK definitions used by the library.
+ */
+
+#ifndef WS2812B_HOST_PICO_H
+#define WS2812B_HOST_PICO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PICO_ON_DEVICE 0
+
+typedef unsigned int uint;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+static inline void tight_loop_contents(void) {}
+
+#endif
@@ -0,0 +1,14 @@
+/**
+ * @file stdlib.h
+ * @brief Host build: standard Pico SDK includes.
+ */
+
+#ifndef WS2812B_HOST_PICO_STDLIB_H
+#define WS2812B_HOST_PICO_STDLIB_H
+
+#include "pico.h"
+#include "pico/time.h"
+
+static inline bool stdio_init_all(void) { return true; }
+
+#endif
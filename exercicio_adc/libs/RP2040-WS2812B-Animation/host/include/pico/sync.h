@@ -0,0 +1,22 @@
+/**
+ * @file sync.h
+ * @brief Host build: a single core, and alarms never preempt the main code,
+ *        so critical sections are empty.
+ */
+
+#ifndef WS2812B_HOST_PICO_SYNC_H
+#define WS2812B_HOST_PICO_SYNC_H
+
+#include "pico.h"
+
+typedef struct {
+    int unused;
+} critical_section_t;
+
+static inline uint get_core_num(void) { return 0; }
+
+static inline void critical_section_init(critical_section_t *crit_sec) { (void)crit_sec; }
+static inline void critical_section_enter_blocking(critical_section_t *crit_sec) { (void)crit_sec; }
+static inline void critical_section_exit(critical_section_t *crit_sec) { (void)crit_sec; }
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file time.h
+ * @brief Host build: alarms and time, driven by the virtual clock of ws2812b_host.c.
+ */
+
+#ifndef WS2812B_HOST_PICO_TIME_H
+#define WS2812B_HOST_PICO_TIME_H
+
+#include "pico.h"
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+#endif
@@ -0,0 +1,15 @@
+/**
+ * @file ws2812.pio.h
+ * @brief Host build: stands in for the header generated from ws2812.pio.
+ */
+
+#ifndef WS2812B_HOST_WS2812_PIO_H
+#define WS2812B_HOST_WS2812_PIO_H
+
+#include "hardware/pio.h"
+
+extern const pio_program_t ws2812_program;
+
+void ws2812_program_init(PIO pio, uint sm, uint offset, uint pin, float freq, bool rgbw);
+
+#endif
@@ -0,0 +1,429 @@
+/**
+ * @file ws2812b_bench.c
+ * @brief Time hot paths of the library on the host against the code they replaced,
+ * and check that both give the same results.
+ *
+ * Usage: ws2812b_bench [section...] [-n iterations]
+ *   -n  Number of times each benchmark runs (default 1000)
+ * Effects are compared with the spritesheet frame copy they stand in for.
+ * Without a section, all of them run. The program exits with 1 if the new code
+ * disagrees with the old one. The library is included as a source file to reach
+ * its static functions, so it must not be linked in as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <uchar.h>
+#include "ws2812b_animation.c"
+#include "ws2812b_host.h"
+#include "spritesheet_ghost_8x8.h"
+#include "spritesheet_ghost_8x8_packed.h"
+#include "spritesheet_flame_8x8.h"
+#include "spritesheet_flame_8x8_packed.h"
+
+/**
+ * @brief Benchmark section.
+ */
+typedef struct {
+    const char *name;
+    bool (*run)(uint32_t iterations);
+} section_t;
+
+/**
+ * @brief Keeps the compiler from dropping the benchmarked work.
+ */
+static volatile uint32_t bench_sink;
+
+static uint64_t bench_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Print the time per operation of the old and the new code.
+ * @param what Name of the operation.
+ * @param old_ns Total time of the old code in nanoseconds.
+ * @param new_ns Total time of the new code in nanoseconds.
+ * @param operations Number of operations timed.
+ */
+static void bench_report(const char *what, uint64_t old_ns, uint64_t new_ns, uint64_t operations) {
+    printf("  %-28s old %9.2f ns  new %9.2f ns  %6.1fx\n", what,
+           (double)old_ns / operations, (double)new_ns / operations,
+           new_ns ? (double)old_ns / new_ns : 0.0);
+}
+
+/* Glyph lookup */
+
+/**
+ * @brief get_CP0_EU_index before the page table: a linear scan of the character map.
+ */
+static uint16_t old_get_CP0_EU_index(uint32_t codepoint) {
+    uint16_t index = 0;
+    while (index < 256 && CHARMAP_CP0_EU[index] != codepoint) ++index;
+    if(index > 255) index = 215;
+    return index;
+}
+
+/**
+ * @brief Text mixing the scripts of the font, some symbols and a few missing glyphs (Cyrillic).
+ */
+static const char32_t mixed_text[] =
+    U"Olá, WS2812B! Ζωή Ελληνικά Łódź Świętokrzyskie Ærøskøbing Œuvre ¿Qué? 25°C €9… Привет • ÿ";
+
+static bool bench_glyphs(uint32_t iterations) {
+    bool ok = true;
+    for(uint32_t codepoint = 0; codepoint < 0x30000; codepoint++) {
+        if(get_CP0_EU_index(codepoint) != old_get_CP0_EU_index(codepoint)) {
+            printf("  U+%04X: glyph %u, was %u\n", codepoint,
+                   get_CP0_EU_index(codepoint), old_get_CP0_EU_index(codepoint));
+            ok = false;
+        }
+    }
+
+    const size_t length = count_of(mixed_text) - 1;
+    uint32_t sum = 0;
+    uint64_t start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(size_t c = 0; c < length; c++) sum += old_get_CP0_EU_index(mixed_text[c]);
+    }
+    uint64_t old_ns = bench_ns() - start;
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(size_t c = 0; c < length; c++) sum += get_CP0_EU_index(mixed_text[c]);
+    }
+    uint64_t new_ns = bench_ns() - start;
+    bench_sink = sum;
+    bench_report("mixed-script glyph lookup", old_ns, new_ns, (uint64_t)iterations * length);
+    return ok;
+}
+
+/* Packed spritesheets */
+
+/**
+ * @brief Time the decoding of a packed sheet against copying its unpacked frames.
+ * @param name Name of the sheet.
+ * @param frames Unpacked frames.
+ * @param sheet The same frames, packed.
+ * @param iterations Number of times the whole sheet is drawn.
+ * @return true if every decoded frame matches the unpacked one.
+ */
+static bool bench_sheet(const char *name, const uGRB32_t **frames, const FX_sheet_t *sheet, uint32_t iterations) {
+    FX_t *FX = ws2812b_spritesheet_packed(sheet, 1000, 0);
+    uGRB32_t expected[64];
+    bool ok = true;
+
+    // Frames are decoded in order, delta frames build on the previous one
+    for(uint8_t frame = 0; frame < sheet->frames; frame++) {
+        fx_sprite(FX, frames[frame]);
+        memcpy(expected, FX->layer, sizeof(expected));
+        if(frame) fx_sprite(FX, frames[frame - 1]);
+        fx_decode_frame(FX, sheet->palette, sheet->data + sheet->offsets[frame], 64, 8);
+        if(memcmp(expected, FX->layer, sizeof(expected))) {
+            printf("  %s: frame %u differs from the unpacked one\n", name, frame);
+            ok = false;
+        }
+    }
+
+    uint64_t start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint8_t frame = 0; frame < sheet->frames; frame++) fx_sprite(FX, frames[frame]);
+    }
+    uint64_t old_ns = bench_ns() - start;
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint8_t frame = 0; frame < sheet->frames; frame++) {
+            fx_decode_frame(FX, sheet->palette, sheet->data + sheet->offsets[frame], 64, 8);
+        }
+    }
+    uint64_t new_ns = bench_ns() - start;
+    ws2812b_cancel(FX);
+    ws2812b_host_run_until(ws2812b_host_now() + 1000);
+
+    char what[64];
+    snprintf(what, sizeof(what), "%s sheet, per frame", name);
+    bench_report(what, old_ns, new_ns, (uint64_t)iterations * sheet->frames);
+    return ok;
+}
+
+static bool bench_sheets(uint32_t iterations) {
+    bool ok = bench_sheet("ghost", SPRITESHEET_GHOST_8X8, &SHEET_GHOST_8X8, iterations);
+    return bench_sheet("flame", SPRITESHEET_FLAME_8X8, &SHEET_FLAME_8X8, iterations) && ok;
+}
+
+/* Color math */
+
+/**
+ * @brief ws2812b_hsv before the fixed-point kernel.
+ */
+static uGRB32_t old_hsv(float _h, float _s, float _v) {
+    float r, g, b;
+    float h = _h / 360;
+    float s = _s / 100;
+    float v = _v / 100;
+    int i   = h * 6;
+    float f = h * 6 - i;
+    float p = v * (1 - s);
+    float q = v * (1 - f * s);
+    float t = v * (1 - (1 - f) * s);
+    switch (i % 6) {
+        case 0: r = v, g = t, b = p; break;
+        case 1: r = q, g = v, b = p; break;
+        case 2: r = p, g = v, b = t; break;
+        case 3: r = p, g = q, b = v; break;
+        case 4: r = t, g = p, b = v; break;
+        default: r = v, g = p, b = q; break;
+    }
+    return ((uint32_t)(r * 255) << 8) | ((uint32_t)(g * 255) << 16) | (uint32_t)(b * 255);
+}
+
+/**
+ * @brief The alpha blend before ws2812b_lerp, one channel at a time.
+ */
+static uGRB32_t old_lerp(uGRB32_t dst, uGRB32_t src, uint8_t alpha) {
+    uGRB32_t out = 0;
+    for(uint8_t shift = 0; shift <= 16; shift += 8) {
+        int32_t d = (dst >> shift) & 0xffu;
+        int32_t c = d + (((int32_t)((src >> shift) & 0xffu) - d) * alpha) / 255;
+        out |= (uint32_t)c << shift;
+    }
+    return out;
+}
+
+/**
+ * @brief Brightness scaling before ws2812b_scale, one channel at a time.
+ */
+static uGRB32_t old_scale(uGRB32_t grb, uint8_t scale) {
+    uint8_t g = (grb >> 16u) & 0xffu;
+    uint8_t r = (grb >> 8u) & 0xffu;
+    uint8_t b = grb & 0xffu;
+    return ws2812b_rgb(r * scale / 255, g * scale / 255, b * scale / 255);
+}
+
+/**
+ * @brief ws2812b_random_color before xorshift.
+ */
+static uGRB32_t old_random_color(float value) {
+    float h = (rand() % 360);
+    return old_hsv(h, 100.0f, value);
+}
+
+/**
+ * @brief Largest difference between the channels of two colors.
+ */
+static uint32_t channel_error(uGRB32_t a, uGRB32_t b) {
+    uint32_t error = 0;
+    for(uint8_t shift = 0; shift <= 16; shift += 8) {
+        int32_t d = (int32_t)((a >> shift) & 0xffu) - (int32_t)((b >> shift) & 0xffu);
+        if((uint32_t)abs(d) > error) error = abs(d);
+    }
+    return error;
+}
+
+/**
+ * @brief Exact interpolation between two colors, rounded to the nearest value.
+ */
+static uGRB32_t exact_lerp(uGRB32_t a, uGRB32_t b, uint8_t t) {
+    uGRB32_t out = 0;
+    for(uint8_t shift = 0; shift <= 16; shift += 8) {
+        double c = ((a >> shift) & 0xffu) + (((double)((b >> shift) & 0xffu) - ((a >> shift) & 0xffu)) * t) / 255.0;
+        out |= (uint32_t)(c + 0.5) << shift;
+    }
+    return out;
+}
+
+static bool bench_colors(uint32_t iterations) {
+    static const float levels[] = { 0.0f, 12.5f, 37.0f, 50.0f, 80.0f, 100.0f };
+    static const uGRB32_t samples[] = { 0x000000, 0xffffff, 0x00ff00, 0x123456, 0xa0f00f, 0x7f8081, 0xff00ff, 0x010203 };
+    uint32_t hsv_error = 0, lerp_error = 0, lerp_exact_error = 0, scale_error = 0, scale_exact_error = 0;
+    uint32_t sum = 0;
+
+    for(uint16_t h = 0; h < 360; h++) {
+        for(size_t s = 0; s < count_of(levels); s++) {
+            for(size_t v = 0; v < count_of(levels); v++) {
+                uint32_t error = channel_error(ws2812b_hsv(h, levels[s], levels[v]), old_hsv(h, levels[s], levels[v]));
+                if(error > hsv_error) hsv_error = error;
+            }
+        }
+    }
+    for(size_t a = 0; a < count_of(samples); a++) {
+        for(uint32_t t = 0; t < 256; t++) {
+            for(size_t b = 0; b < count_of(samples); b++) {
+                uGRB32_t grb = ws2812b_lerp(samples[a], samples[b], t);
+                uint32_t error = channel_error(grb, old_lerp(samples[a], samples[b], t));
+                if(error > lerp_error) lerp_error = error;
+                error = channel_error(grb, exact_lerp(samples[a], samples[b], t));
+                if(error > lerp_exact_error) lerp_exact_error = error;
+            }
+            uGRB32_t grb = ws2812b_scale(samples[a], t);
+            uint32_t error = channel_error(grb, old_scale(samples[a], t));
+            if(error > scale_error) scale_error = error;
+            error = channel_error(grb, exact_lerp(0, samples[a], t));
+            if(error > scale_exact_error) scale_exact_error = error;
+        }
+    }
+    // The old code truncated towards zero, so it was off by one too, downwards when fading in
+    // and upwards when fading out: new and old may differ by 2 where both are within 1 of exact.
+    printf("  largest error per channel against the old code: hsv %u, lerp %u, scale %u\n",
+           hsv_error, lerp_error, scale_error);
+    printf("  largest error per channel against exact math: lerp %u, scale %u\n",
+           lerp_exact_error, scale_exact_error);
+
+    uint64_t start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint16_t h = 0; h < 360; h++) sum += old_hsv(h, 100.0f, 50.0f);
+    }
+    uint64_t old_ns = bench_ns() - start;
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint16_t h = 0; h < 360; h++) sum += ws2812b_hsv(h, 100.0f, 50.0f);
+    }
+    uint64_t new_ns = bench_ns() - start;
+    bench_report("hsv (float arguments)", old_ns, new_ns, iterations * 360ull);
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint16_t h = 0; h < 360; h++) sum += ws2812b_hsv_int(h, 100, 50);
+    }
+    new_ns = bench_ns() - start;
+    bench_report("hsv_int", old_ns, new_ns, iterations * 360ull);
+
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint32_t t = 0; t < 256; t++) sum += old_lerp(samples[i & 7], samples[t & 7], t);
+    }
+    old_ns = bench_ns() - start;
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint32_t t = 0; t < 256; t++) sum += ws2812b_lerp(samples[i & 7], samples[t & 7], t);
+    }
+    new_ns = bench_ns() - start;
+    bench_report("lerp", old_ns, new_ns, iterations * 256ull);
+
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint32_t t = 0; t < 256; t++) sum += old_scale(samples[t & 7], t);
+    }
+    old_ns = bench_ns() - start;
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        for(uint32_t t = 0; t < 256; t++) sum += ws2812b_scale(samples[t & 7], t);
+    }
+    new_ns = bench_ns() - start;
+    bench_report("scale", old_ns, new_ns, iterations * 256ull);
+
+    srand(1);
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations * 256; i++) sum += old_random_color(50.0f);
+    old_ns = bench_ns() - start;
+    start = bench_ns();
+    for(uint32_t i = 0; i < iterations * 256; i++) sum += ws2812b_random_color(50.0f);
+    new_ns = bench_ns() - start;
+    bench_report("random_color", old_ns, new_ns, iterations * 256ull);
+
+    bench_sink = sum;
+    return hsv_error <= 2 && lerp_exact_error <= 1 && scale_exact_error <= 1;
+}
+
+/* Generated effects */
+
+static bool bench_effects(uint32_t iterations) {
+    static const struct {
+        const char *name;
+        FX_mode_t mode;
+        const uGRB32_t *colors;
+    } effects[] = {
+        { "fire frame", FX_FIRE, colors_fire },
+        { "plasma frame", FX_PLASMA, colors_rainbow },
+        { "noise frame", FX_NOISE, colors_rainbow },
+    };
+    bool ok = true;
+
+    // Lattice points hold their hash, and cells join smoothly in between
+    uint32_t jump = 0;
+    for(uint32_t y = 0; y < 8 * 256; y += 37) {
+        for(uint32_t x = 0; x < 8 * 256; x++) {
+            if(!(x & 0xffu) && !(y & 0xffu) && ws2812b_noise(x, y, 3 * 256) != noise_lattice(x >> 8, y >> 8, 3)) {
+                printf("  noise at lattice point (%u, %u) is not its hash\n", x >> 8, y >> 8);
+                ok = false;
+            }
+            uint32_t step = abs((int32_t)ws2812b_noise(x + 1, y, 200) - (int32_t)ws2812b_noise(x, y, 200));
+            if(step > jump) jump = step;
+        }
+    }
+    uint32_t sine_error = 0;
+    for(uint32_t angle = 0; angle < 256; angle++) {
+        uint32_t error = abs((int32_t)sin8(angle) - (int32_t)lround(128.0 + 127.0 * sin(angle * M_PI / 128.0)));
+        if(error > sine_error) sine_error = error;
+    }
+    printf("  largest noise step between neighbouring samples %u, sin8 error %u\n", jump, sine_error);
+    ok = ok && jump <= 4 && sine_error <= 8;
+
+    // The effects replace spritesheets such as the flame: compare a frame with copying one
+    FX_t *FX = ws2812b_spritesheet(SPRITESHEET_FLAME_8X8, count_of(SPRITESHEET_FLAME_8X8), 1000, 0);
+    uint64_t start = bench_ns();
+    for(uint32_t i = 0; i < iterations; i++) fx_sprite(FX, SPRITESHEET_FLAME_8X8[i % count_of(SPRITESHEET_FLAME_8X8)]);
+    uint64_t sprite_ns = bench_ns() - start;
+    ws2812b_cancel(FX);
+    ws2812b_host_run_until(ws2812b_host_now() + 1000);
+
+    for(size_t e = 0; e < count_of(effects); e++) {
+        FX = ws2812b_animate(0, 63, effects[e].mode, effects[e].colors, 0, 0);
+        start = bench_ns();
+        for(uint32_t i = 0; i < iterations; i++) {
+            FX->cursor = i & 0xffu;
+            FX->fx_function(FX, 0);
+        }
+        uint64_t effect_ns = bench_ns() - start;
+        ws2812b_cancel(FX);
+        ws2812b_host_run_until(ws2812b_host_now() + 1000);
+        bench_report(effects[e].name, sprite_ns, effect_ns, iterations);
+    }
+    return ok;
+}
+
+static const section_t sections[] = {
+    { "glyphs", bench_glyphs },
+    { "sheets", bench_sheets },
+    { "colors", bench_colors },
+    { "effects", bench_effects },
+};
+
+static void usage(const char *program) {
+    printf("Usage: %s [section...] [-n iterations]\nSections:", program);
+    for(size_t i = 0; i < count_of(sections); i++) printf(" %s", sections[i].name);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    uint32_t iterations = 1000;
+    bool selected[count_of(sections)] = { false };
+    bool any = false;
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+            continue;
+        }
+        size_t s = 0;
+        while(s < count_of(sections) && strcmp(argv[i], sections[s].name)) s++;
+        if(s == count_of(sections)) {
+            usage(argv[0]);
+            return 2;
+        }
+        selected[s] = any = true;
+    }
+
+    ws2812b_init(pio0, 2, 64);
+    uint32_t failed = 0;
+    for(size_t s = 0; s < count_of(sections); s++) {
+        if(any && !selected[s]) continue;
+        printf("%s:\n", sections[s].name);
+        if(!sections[s].run(iterations)) {
+            printf("%s: the new code disagrees with the old one\n", sections[s].name);
+            failed++;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,497 @@
+/**
+ * @file ws2812b_host.c
+ * @brief Host backend of RP2040-WS2812B-Animation.
+ * The Pico SDK functions used by the library are implemented over a virtual clock:
+ * alarms fire in order when the clock is advanced (ws2812b_host_run_until, sleep_ms),
+ * and the words pushed to the PIO update a model of the strip, latched when the
+ * line goes idle, i.e. when the alarm returns or the clock moves. Each word pushed
+ * takes the time the PIO would need to shift it out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "ws2812.pio.h"
+#include "ws2812b_host.h"
+
+/**
+ * @def WS2812B_HOST_ALARMS
+ * @brief Maximum number of pending alarms.
+ */
+#define WS2812B_HOST_ALARMS 16
+
+/**
+ * @def WS2812B_HOST_PIXEL_US
+ * @brief Virtual time taken by pio_sm_put_blocking: 24 bits at 800 kHz, the FIFO is ignored.
+ * Makes the alarms pay for the transmission, as on the Pico.
+ */
+#define WS2812B_HOST_PIXEL_US 30
+
+pio_hw_t ws2812b_host_pio[2] = {{0}, {1}};
+const pio_program_t ws2812_program = {0};
+
+/**
+ * @brief Pending alarm.
+ */
+typedef struct {
+    alarm_id_t id;          // 0 when the slot is free
+    uint64_t at_us;
+    alarm_callback_t callback;
+    void *user_data;
+} host_alarm_t;
+
+static host_alarm_t alarms[WS2812B_HOST_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+static uint64_t now_us;
+
+static uGRB32_t *strip;            // Last transmitted color of each pixel
+static uint16_t strip_len;         // Number of pixels transmitted so far
+static uint16_t strip_capacity;
+static uint16_t transmit_pos;      // Next pixel of the frame being transmitted
+static bool transmitting;
+
+static ws2812b_host_sink_t sink;
+static void *sink_user_data;
+static struct ws2812b_host_stats stats;
+
+/**
+ * @brief End the frame being transmitted, as the strip does after a reset pulse.
+ */
+static void latch() {
+    if(!transmitting) return;
+    transmitting = false;
+    transmit_pos = 0;
+    stats.frames++;
+    if(sink) sink(strip, strip_len, now_us, sink_user_data);
+}
+
+/**
+ * @brief Get a monotonic time for the CPU statistics.
+ * @return Time in nanoseconds.
+ */
+static uint64_t host_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Pico SDK functions */
+
+uint64_t time_us_64(void) {
+    return now_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)now_us;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    for(uint8_t i = 0; i < WS2812B_HOST_ALARMS; i++) {
+        if(alarms[i].id) continue;
+        alarms[i].id = next_alarm_id++;
+        alarms[i].at_us = now_us + us;
+        alarms[i].callback = callback;
+        alarms[i].user_data = user_data;
+        return alarms[i].id;
+    }
+    return -1; // Same as the SDK when no alarm slot is left
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us(ms * 1000ull, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    for(uint8_t i = 0; i < WS2812B_HOST_ALARMS; i++) {
+        if(alarms[i].id == id) {
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void sleep_us(uint64_t us) {
+    ws2812b_host_run_until(now_us + us);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us(ms * 1000ull);
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    return 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    return 0;
+}
+
+void ws2812_program_init(PIO pio, uint sm, uint offset, uint pin, float freq, bool rgbw) {
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    if(transmit_pos >= strip_capacity) {
+        uint16_t capacity = strip_capacity ? strip_capacity * 2 : 64;
+        uGRB32_t *grown = realloc(strip, capacity * sizeof(uGRB32_t));
+        if(!grown) return; // Lost, like pixels past the end of a real strip
+        memset(grown + strip_capacity, 0, (capacity - strip_capacity) * sizeof(uGRB32_t));
+        strip = grown;
+        strip_capacity = capacity;
+    }
+    transmitting = true;
+    now_us += WS2812B_HOST_PIXEL_US;
+    strip[transmit_pos++] = data >> 8u; // The library shifts GRB values to the top of the word
+    if(transmit_pos > strip_len) strip_len = transmit_pos;
+}
+
+/* Host API */
+
+/**
+ * @brief Set the function receiving each transmitted frame.
+ * @param sink Frame sink, NULL to stop capturing.
+ * @param user_data Passed to the sink.
+ */
+void ws2812b_host_set_sink(ws2812b_host_sink_t _sink, void *user_data) {
+    sink = _sink;
+    sink_user_data = user_data;
+}
+
+/**
+ * @brief Get the virtual time.
+ * @return Time in microseconds since the start of the program.
+ */
+uint64_t ws2812b_host_now() {
+    return now_us;
+}
+
+/**
+ * @brief Advance the virtual clock, firing every alarm that is due on the way.
+ * As with the SDK, a callback returning a positive value is rescheduled that many
+ * microseconds after it returns, a negative one relative to the time it was due.
+ * @param at_us Time to stop at, in microseconds.
+ */
+void ws2812b_host_run_until(uint64_t at_us) {
+    latch(); // Anything transmitted by the main code so far
+    while(true) {
+        host_alarm_t *next = NULL;
+        for(uint8_t i = 0; i < WS2812B_HOST_ALARMS; i++) {
+            if(alarms[i].id && alarms[i].at_us <= at_us && (!next || alarms[i].at_us < next->at_us)) {
+                next = &alarms[i];
+            }
+        }
+        if(!next) break;
+        if(next->at_us > now_us) now_us = next->at_us;
+
+        alarm_id_t id = next->id;
+        uint64_t start_ns = host_ns();
+        int64_t delay_us = next->callback(id, next->user_data);
+        uint64_t busy_ns = host_ns() - start_ns;
+        stats.wakeups++;
+        stats.busy_ns += busy_ns;
+        if(busy_ns > stats.max_ns) stats.max_ns = busy_ns;
+        latch();
+
+        if(next->id != id) continue; // Canceled by its own callback
+        if(delay_us > 0) next->at_us = now_us + delay_us;
+        else if(delay_us < 0) next->at_us -= delay_us;
+        else next->id = 0;
+    }
+    if(at_us > now_us) now_us = at_us;
+}
+
+/**
+ * @brief Get the current state of the strip.
+ * @param length Set to the number of pixels transmitted so far.
+ * @return Color of each pixel.
+ */
+const uGRB32_t* ws2812b_host_strip(uint16_t *length) {
+    *length = strip_len;
+    return strip;
+}
+
+/**
+ * @brief Get the CPU time statistics since the start or the last reset.
+ * @param _stats Filled with the statistics.
+ */
+void ws2812b_host_get_stats(struct ws2812b_host_stats *_stats) {
+    *_stats = stats;
+}
+
+/**
+ * @brief Reset the CPU time statistics.
+ */
+void ws2812b_host_reset_stats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief Render the strip as RGB rows, laid out with the geometry of the library.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @param width Set to the width of the image.
+ * @param height Set to the height of the image.
+ * @return Image data, to be freed, NULL if out of memory.
+ */
+static uint8_t* rasterize(const uGRB32_t *_strip, uint16_t length, uint8_t scale,
+                          uint32_t *width, uint32_t *height) {
+    if(!scale) scale = 1;
+    *width = ws2812b_width() * scale;
+    *height = ws2812b_height() * scale;
+    uint8_t *rgb = calloc((size_t)*width * *height, 3);
+    if(!rgb) return NULL;
+    for(uint32_t y = 0; y < *height; y++) {
+        for(uint32_t x = 0; x < *width; x++) {
+            uint16_t pixel = ws2812b_xy(x / scale, y / scale);
+            if(pixel == WS2812B_NO_PIXEL || pixel >= length) continue;
+            uGRB32_t grb = _strip[pixel];
+            uint8_t *out = rgb + ((size_t)y * *width + x) * 3;
+            out[0] = (grb >> 8u) & 0xffu;
+            out[1] = (grb >> 16u) & 0xffu;
+            out[2] = grb & 0xffu;
+        }
+    }
+    return rgb;
+}
+
+/**
+ * @brief Append the strip to a file as a binary PPM image.
+ * @param file File opened for binary writing.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return true on success, false if the image can't be written.
+ */
+bool ws2812b_host_write_ppm_file(FILE *file, const uGRB32_t *_strip, uint16_t length, uint8_t scale) {
+    uint32_t width, height;
+    uint8_t *rgb = rasterize(_strip, length, scale, &width, &height);
+    if(!rgb) return false;
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    bool ok = fwrite(rgb, 3, (size_t)width * height, file) == (size_t)width * height;
+    free(rgb);
+    return ok;
+}
+
+/**
+ * @brief Write the strip as a binary PPM image, laid out with the geometry of the library.
+ * @param path Path of the image.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return true on success, false if the file can't be written.
+ */
+bool ws2812b_host_write_ppm(const char *path, const uGRB32_t *_strip, uint16_t length, uint8_t scale) {
+    FILE *file = fopen(path, "wb");
+    if(!file) return false;
+    bool ok = ws2812b_host_write_ppm_file(file, _strip, length, scale);
+    return (fclose(file) == 0) && ok;
+}
+
+/**
+ * @brief Compare the strip with the next PPM image of a file.
+ * @param file File opened for binary reading.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return Number of pixels that differ, -1 if no image is left or it has another size.
+ */
+int32_t ws2812b_host_compare_ppm_file(FILE *file, const uGRB32_t *_strip, uint16_t length, uint8_t scale) {
+    uint32_t width, height, file_width, file_height, depth;
+    if(fscanf(file, " P6 %u %u %u", &file_width, &file_height, &depth) != 3 || fgetc(file) == EOF) {
+        return -1;
+    }
+    uint8_t *rgb = rasterize(_strip, length, scale, &width, &height);
+    uint8_t *golden = malloc((size_t)file_width * file_height * 3);
+    int32_t differences = -1;
+    // Read the image whatever its size, so that the next one can still be compared
+    bool read = golden && fread(golden, 3, (size_t)file_width * file_height, file) == (size_t)file_width * file_height;
+    if(rgb && read && file_width == width && file_height == height && depth == 255) {
+        differences = 0;
+        for(size_t i = 0; i < (size_t)width * height; i++) {
+            if(memcmp(rgb + i * 3, golden + i * 3, 3)) differences++;
+        }
+    }
+    free(rgb);
+    free(golden);
+    return differences;
+}
+
+/**
+ * @brief Compare the strip with a PPM image written by ws2812b_host_write_ppm.
+ * @param path Path of the image.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return Number of pixels that differ, -1 if the image can't be read or has another size.
+ */
+int32_t ws2812b_host_compare_ppm(const char *path, const uGRB32_t *_strip, uint16_t length, uint8_t scale) {
+    FILE *file = fopen(path, "rb");
+    if(!file) return -1;
+    int32_t differences = ws2812b_host_compare_ppm_file(file, _strip, length, scale);
+    fclose(file);
+    return differences;
+}
+
+/* Animated GIF */
+
+/**
+ * @brief GIF data sub-blocks being filled with LZW codes.
+ */
+typedef struct {
+    FILE *file;
+    uint8_t block[255];
+    uint8_t block_len;
+    uint32_t bits;
+    uint8_t bit_count;
+} gif_codes_t;
+
+static void gif_flush_block(gif_codes_t *codes) {
+    if(!codes->block_len) return;
+    fputc(codes->block_len, codes->file);
+    fwrite(codes->block, 1, codes->block_len, codes->file);
+    codes->block_len = 0;
+}
+
+static void gif_put_code(gif_codes_t *codes, uint16_t code) {
+    codes->bits |= (uint32_t)code << codes->bit_count;
+    codes->bit_count += 9;
+    while(codes->bit_count >= 8) {
+        codes->block[codes->block_len++] = codes->bits & 0xffu;
+        codes->bits >>= 8;
+        codes->bit_count -= 8;
+        if(codes->block_len == sizeof(codes->block)) gif_flush_block(codes);
+    }
+}
+
+static void put_u16(FILE *file, uint16_t value) {
+    fputc(value & 0xffu, file);
+    fputc(value >> 8u, file);
+}
+
+/**
+ * @brief Write one frame of a GIF.
+ * The pixels are stored as literal 9-bit LZW codes, with a clear code before the
+ * decoder's table would need 10 bits: larger than compressed data, but short to write.
+ * @param gif GIF
+ * @param delay_us Time the frame lasts
+ */
+static void gif_write_frame(ws2812b_host_gif_t *gif, uint64_t delay_us) {
+    FILE *file = gif->file;
+    uint64_t delay_cs = (delay_us + 5000) / 10000;
+    if(delay_cs < 2) delay_cs = 2; // Shorter delays are slowed down by most viewers
+    if(delay_cs > 0xffff) delay_cs = 0xffff;
+
+    fputc(0x21, file); // Graphic control extension
+    fputc(0xf9, file);
+    fputc(4, file);
+    fputc(0, file);
+    put_u16(file, delay_cs);
+    fputc(0, file);
+    fputc(0, file);
+
+    fputc(0x2c, file); // Image descriptor, the whole screen with the global palette
+    put_u16(file, 0);
+    put_u16(file, 0);
+    put_u16(file, gif->width);
+    put_u16(file, gif->height);
+    fputc(0, file);
+
+    fputc(8, file); // Minimum code size
+    gif_codes_t codes = { .file = file };
+    size_t pixels = (size_t)gif->width * gif->height;
+    for(size_t i = 0; i < pixels; i++) {
+        if(i % 254 == 0) gif_put_code(&codes, 256); // Clear
+        gif_put_code(&codes, gif->pending[i]);
+    }
+    gif_put_code(&codes, 257); // End of information
+    if(codes.bit_count) codes.block[codes.block_len++] = codes.bits & 0xffu;
+    gif_flush_block(&codes);
+    fputc(0, file); // Block terminator
+}
+
+/**
+ * @brief Create an animated GIF, laid out with the geometry of the library.
+ * Colors are reduced to a fixed 3-3-2 bits palette.
+ * @param gif GIF to set up.
+ * @param path Path of the image.
+ * @param scale Size of each pixel in the image.
+ * @return true on success, false if the file can't be created.
+ */
+bool ws2812b_host_gif_open(ws2812b_host_gif_t *gif, const char *path, uint8_t scale) {
+    memset(gif, 0, sizeof(*gif));
+    gif->scale = scale ? scale : 1;
+    gif->width = ws2812b_width() * gif->scale;
+    gif->height = ws2812b_height() * gif->scale;
+    gif->pending_us = UINT64_MAX;
+    gif->pending = malloc((size_t)gif->width * gif->height);
+    gif->file = gif->pending ? fopen(path, "wb") : NULL;
+    if(!gif->file) {
+        free(gif->pending);
+        return false;
+    }
+
+    FILE *file = gif->file;
+    fputs("GIF89a", file);
+    put_u16(file, gif->width);
+    put_u16(file, gif->height);
+    fputc(0xf7, file); // Global palette of 256 colors
+    fputc(0, file);
+    fputc(0, file);
+    for(uint16_t i = 0; i < 256; i++) {
+        fputc((i >> 5u) * 255u / 7u, file);
+        fputc(((i >> 2u) & 7u) * 255u / 7u, file);
+        fputc((i & 3u) * 255u / 3u, file);
+    }
+    fputc(0x21, file); // Loop forever
+    fputc(0xff, file);
+    fputc(11, file);
+    fputs("NETSCAPE2.0", file);
+    fputc(3, file);
+    fputc(1, file);
+    put_u16(file, 0);
+    fputc(0, file);
+    return true;
+}
+
+/**
+ * @brief Add a frame to an animated GIF.
+ * @param gif GIF opened by ws2812b_host_gif_open.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param now_us Time of the frame in microseconds, the previous frame lasts until then.
+ * @return true on success, false if the file can't be written.
+ */
+bool ws2812b_host_gif_frame(ws2812b_host_gif_t *gif, const uGRB32_t *_strip, uint16_t length, uint64_t now_us) {
+    uint32_t width, height;
+    uint8_t *rgb = rasterize(_strip, length, gif->scale, &width, &height);
+    if(!rgb) return false;
+    if(gif->pending_us != UINT64_MAX) gif_write_frame(gif, now_us - gif->pending_us);
+    for(size_t i = 0; i < (size_t)width * height; i++) {
+        const uint8_t *c = rgb + i * 3;
+        gif->pending[i] = (c[0] & 0xe0u) | ((c[1] >> 3u) & 0x1cu) | (c[2] >> 6u);
+    }
+    gif->pending_us = now_us;
+    free(rgb);
+    return !ferror(gif->file);
+}
+
+/**
+ * @brief Write the last frame and close an animated GIF.
+ * @param gif GIF opened by ws2812b_host_gif_open.
+ * @param now_us Time at which the last frame ends, in microseconds.
+ * @return true on success, false if the file can't be written.
+ */
+bool ws2812b_host_gif_close(ws2812b_host_gif_t *gif, uint64_t now_us) {
+    if(gif->pending_us != UINT64_MAX) gif_write_frame(gif, now_us - gif->pending_us);
+    fputc(0x3b, gif->file); // Trailer
+    bool ok = !ferror(gif->file);
+    ok = (fclose(gif->file) == 0) && ok;
+    free(gif->pending);
+    gif->file = NULL;
+    gif->pending = NULL;
+    return ok;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file ws2812b_host.h
+ * @brief Host backend of RP2040-WS2812B-Animation: a virtual clock in place of the
+ * hardware alarms and a frame sink in place of the PIO, to run effects on a PC.
+ */
+
+#ifndef WS2812B_HOST_H
+#define WS2812B_HOST_H
+
+#include <stdio.h>
+#include "ws2812b_animation.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function called with the state of the strip after each transmitted frame.
+ * @param strip Color of each pixel, as last transmitted.
+ * @param length Number of pixels transmitted so far.
+ * @param now_us Virtual time of the frame in microseconds.
+ * @param user_data User data given to ws2812b_host_set_sink.
+ */
+typedef void (*ws2812b_host_sink_t)(const uGRB32_t *strip, uint16_t length, uint64_t now_us, void *user_data);
+
+/**
+ * @struct ws2812b_host_stats
+ * @brief CPU time spent by the library in its alarm, measured on the host.
+ */
+struct ws2812b_host_stats {
+    /**
+     * @brief Number of frames transmitted.
+     */
+    uint32_t frames;
+
+    /**
+     * @brief Number of times the alarm fired.
+     */
+    uint32_t wakeups;
+
+    /**
+     * @brief Total time spent in the alarm, in nanoseconds.
+     */
+    uint64_t busy_ns;
+
+    /**
+     * @brief Longest time spent in a single alarm, in nanoseconds.
+     */
+    uint64_t max_ns;
+};
+
+/**
+ * @brief Set the function receiving each transmitted frame.
+ * @param sink Frame sink, NULL to stop capturing.
+ * @param user_data Passed to the sink.
+ */
+void ws2812b_host_set_sink(ws2812b_host_sink_t sink, void *user_data);
+
+/**
+ * @brief Get the virtual time.
+ * @return Time in microseconds since the start of the program.
+ */
+uint64_t ws2812b_host_now();
+
+/**
+ * @brief Advance the virtual clock, firing every alarm that is due on the way.
+ * @param at_us Time to stop at, in microseconds.
+ */
+void ws2812b_host_run_until(uint64_t at_us);
+
+/**
+ * @brief Get the current state of the strip.
+ * @param length Set to the number of pixels transmitted so far.
+ * @return Color of each pixel.
+ */
+const uGRB32_t* ws2812b_host_strip(uint16_t *length);
+
+/**
+ * @brief Get the CPU time statistics since the start or the last reset.
+ * @param stats Filled with the statistics.
+ */
+void ws2812b_host_get_stats(struct ws2812b_host_stats *stats);
+
+/**
+ * @brief Reset the CPU time statistics.
+ */
+void ws2812b_host_reset_stats();
+
+/**
+ * @brief Write the strip as a binary PPM image, laid out with the geometry of the library.
+ * @param path Path of the image.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return true on success, false if the file can't be written.
+ */
+bool ws2812b_host_write_ppm(const char *path, const uGRB32_t *strip, uint16_t length, uint8_t scale);
+
+/**
+ * @brief Compare the strip with a PPM image written by ws2812b_host_write_ppm.
+ * @param path Path of the image.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return Number of pixels that differ, -1 if the image can't be read or has another size.
+ */
+int32_t ws2812b_host_compare_ppm(const char *path, const uGRB32_t *strip, uint16_t length, uint8_t scale);
+
+/**
+ * @brief Append the strip to a file as a binary PPM image. A file can hold several
+ * images one after the other, e.g. all the frames of a run.
+ * @param file File opened for binary writing.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return true on success, false if the image can't be written.
+ */
+bool ws2812b_host_write_ppm_file(FILE *file, const uGRB32_t *strip, uint16_t length, uint8_t scale);
+
+/**
+ * @brief Compare the strip with the next PPM image of a file.
+ * @param file File opened for binary reading.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param scale Size of each pixel in the image.
+ * @return Number of pixels that differ, -1 if no image is left or it has another size.
+ */
+int32_t ws2812b_host_compare_ppm_file(FILE *file, const uGRB32_t *strip, uint16_t length, uint8_t scale);
+
+/**
+ * @struct ws2812b_host_gif
+ * @brief Animated GIF being written. Each frame is held until the next one, to know how long it lasts.
+ */
+typedef struct ws2812b_host_gif {
+    FILE *file;
+    uint8_t scale;
+    uint32_t width;
+    uint32_t height;
+    uint8_t *pending;       // Palette index of each pixel of the held frame
+    uint64_t pending_us;    // Time of the held frame, UINT64_MAX if none
+} ws2812b_host_gif_t;
+
+/**
+ * @brief Create an animated GIF, laid out with the geometry of the library.
+ * Colors are reduced to a fixed 3-3-2 bits palette.
+ * @param gif GIF to set up.
+ * @param path Path of the image.
+ * @param scale Size of each pixel in the image.
+ * @return true on success, false if the file can't be created.
+ */
+bool ws2812b_host_gif_open(ws2812b_host_gif_t *gif, const char *path, uint8_t scale);
+
+/**
+ * @brief Add a frame to an animated GIF.
+ * @param gif GIF opened by ws2812b_host_gif_open.
+ * @param strip Color of each pixel.
+ * @param length Number of pixels, missing ones are black.
+ * @param now_us Time of the frame in microseconds, the previous frame lasts until then.
+ * @return true on success, false if the file can't be written.
+ */
+bool ws2812b_host_gif_frame(ws2812b_host_gif_t *gif, const uGRB32_t *strip, uint16_t length, uint64_t now_us);
+
+/**
+ * @brief Write the last frame and close an animated GIF.
+ * @param gif GIF opened by ws2812b_host_gif_open.
+ * @param now_us Time at which the last frame ends, in microseconds.
+ * @return true on success, false if the file can't be written.
+ */
+bool ws2812b_host_gif_close(ws2812b_host_gif_t *gif, uint64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
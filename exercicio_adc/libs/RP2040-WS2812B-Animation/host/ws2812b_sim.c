@@ -0,0 +1,215 @@
+/**
+ * @file ws2812b_sim.c
+ * @brief Run an effect on the host backend, dump its frames and compare them with golden ones.
+ *
+ * Usage: ws2812b_sim [scenario] [-t ms] [-s scale] [-o dir] [-w file] [-g file] [-a file]
+ *   -t  Virtual time to run for, in milliseconds
+ *   -s  Size of each LED in the images (default 1)
+ *   -o  Write each frame to dir/[scenario]_NNNNN.ppm
+ *   -w  Write all the frames to a single PPM file, one image after the other
+ *   -g  Compare each frame with the matching image of a file written with -w,
+ *       exit with 1 on any difference
+ *   -a  Write the frames to an animated GIF, each one lasting until the next
+ * The virtual clock starts at 0 on every run, so the frames of a scenario are reproducible:
+ * the golden directory holds the frames of each scenario, checked by the host tests.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ws2812b_animation.h"
+#include "ws2812b_host.h"
+#include "sprites_8x8.h"
+#include "spritesheet_ghost_8x8_packed.h"
+
+#define NUM_PIXELS 64
+
+/**
+ * @brief Built-in scenario.
+ */
+typedef struct {
+    const char *name;
+    void (*start)();
+    uint32_t duration_ms;
+} scenario_t;
+
+static void start_scan() {
+    ws2812b_animate(0, NUM_PIXELS - 1, FX_SCAN, colors_cmyk, 2, true);
+}
+
+static void start_fire() {
+    ws2812b_animate(0, NUM_PIXELS - 1, FX_FIRE, colors_fire, 1, 0);
+}
+
+static void start_plasma() {
+    ws2812b_animate(0, NUM_PIXELS - 1, FX_PLASMA, colors_rainbow, 1, 0);
+}
+
+static void start_text() {
+    ws2812b_text_scroll("Olá, WS2812B!", GRB_CYAN, 60);
+}
+
+static void start_sheet() {
+    ws2812b_spritesheet_packed(&SHEET_GHOST_8X8, 100, 2);
+}
+
+static FX_reader_t file_reader, memory_reader;
+
+static void play_from_memory(void *user_data) {
+    (void)user_data;
+    ws2812b_stream(&memory_reader, 100, 1);
+}
+
+// The same stream, twice from its file then once from memory, on a serpentine panel
+static void start_stream() {
+    static uint8_t data[4096];
+    FILE *file = fopen(STREAM_FILE, "rb");
+    size_t size = file ? fread(data, 1, sizeof(data), file) : 0;
+    if(file) fclose(file);
+    if(!size || !ws2812b_reader_file(&file_reader, STREAM_FILE)) {
+        fprintf(stderr, "Can't read %s\n", STREAM_FILE);
+        return;
+    }
+    ws2812b_reader_memory(&memory_reader, data);
+    ws2812b_set_geometry(&(struct ws2812b_geometry){
+        .width = 8, .height = 8, .wiring = WS2812B_WIRING_SERPENTINE
+    });
+    ws2812b_set_callback(ws2812b_stream(&file_reader, 100, 2), play_from_memory);
+}
+
+static void start_layers() {
+    ws2812b_sprite_tint(SMILEY_HAPPY_8X8, GRB_RED);
+    FX_t *wipe = ws2812b_animate(0, NUM_PIXELS - 1, FX_WIPE, colors_cmyk, 1, 0);
+    ws2812b_set_z(wipe, 1);
+    ws2812b_set_blend(wipe, FX_BLEND_ALPHA, 128);
+}
+
+static const scenario_t scenarios[] = {
+    { "scan",   start_scan,   3000 },
+    { "fire",   start_fire,   5000 },
+    { "plasma", start_plasma, 5000 },
+    { "text",   start_text,   7000 },
+    { "sheet",  start_sheet,  3000 },
+    { "layers", start_layers, 2000 },
+    { "stream", start_stream, 2000 },
+};
+
+/**
+ * @brief Frame sink state.
+ */
+typedef struct {
+    const char *name;
+    const char *out_dir;
+    FILE *out_file;
+    FILE *golden_file;
+    ws2812b_host_gif_t *gif;
+    uint8_t scale;
+    uint32_t frame;
+    uint32_t failed;
+} capture_t;
+
+static void capture_frame(const uGRB32_t *strip, uint16_t length, uint64_t now_us, void *user_data) {
+    capture_t *capture = user_data;
+    char path[512];
+    if(capture->out_dir) {
+        snprintf(path, sizeof(path), "%s/%s_%05u.ppm", capture->out_dir, capture->name, capture->frame);
+        if(!ws2812b_host_write_ppm(path, strip, length, capture->scale)) {
+            fprintf(stderr, "Can't write %s\n", path);
+        }
+    }
+    if(capture->out_file && !ws2812b_host_write_ppm_file(capture->out_file, strip, length, capture->scale)) {
+        fprintf(stderr, "Can't write frame %u\n", capture->frame);
+    }
+    if(capture->gif && !ws2812b_host_gif_frame(capture->gif, strip, length, now_us)) {
+        fprintf(stderr, "Can't write frame %u to the GIF\n", capture->frame);
+    }
+    if(capture->golden_file) {
+        int32_t differences = ws2812b_host_compare_ppm_file(capture->golden_file, strip, length, capture->scale);
+        if(differences) {
+            capture->failed++;
+            if(differences < 0) printf("frame %u at %llu us: no golden frame\n",
+                                       capture->frame, (unsigned long long)now_us);
+            else printf("frame %u at %llu us: %d pixels differ from the golden frame\n",
+                        capture->frame, (unsigned long long)now_us, differences);
+        }
+    }
+    capture->frame++;
+}
+
+static void usage(const char *program) {
+    printf("Usage: %s [scenario] [-t ms] [-s scale] [-o dir] [-w file] [-g file] [-a file]\nScenarios:", program);
+    for(size_t i = 0; i < count_of(scenarios); i++) printf(" %s", scenarios[i].name);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    if(argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const scenario_t *scenario = NULL;
+    for(size_t i = 0; i < count_of(scenarios); i++) {
+        if(!strcmp(argv[1], scenarios[i].name)) scenario = &scenarios[i];
+    }
+    if(!scenario) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    capture_t capture = { .name = scenario->name, .scale = 1 };
+    uint32_t duration_ms = scenario->duration_ms;
+    const char *out_path = NULL, *golden_path = NULL, *gif_path = NULL;
+    for(int i = 2; i + 1 < argc; i += 2) {
+        if(!strcmp(argv[i], "-t")) duration_ms = atoi(argv[i + 1]);
+        else if(!strcmp(argv[i], "-s")) capture.scale = atoi(argv[i + 1]);
+        else if(!strcmp(argv[i], "-o")) capture.out_dir = argv[i + 1];
+        else if(!strcmp(argv[i], "-w")) out_path = argv[i + 1];
+        else if(!strcmp(argv[i], "-g")) golden_path = argv[i + 1];
+        else if(!strcmp(argv[i], "-a")) gif_path = argv[i + 1];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(out_path && !(capture.out_file = fopen(out_path, "wb"))) {
+        fprintf(stderr, "Can't write %s\n", out_path);
+        return 2;
+    }
+    if(golden_path && !(capture.golden_file = fopen(golden_path, "rb"))) {
+        fprintf(stderr, "Can't read %s\n", golden_path);
+        return 2;
+    }
+
+    ws2812b_init(pio0, 2, NUM_PIXELS);
+    ws2812b_host_gif_t gif;
+    if(gif_path) {
+        if(!ws2812b_host_gif_open(&gif, gif_path, capture.scale)) {
+            fprintf(stderr, "Can't write %s\n", gif_path);
+            return 2;
+        }
+        capture.gif = &gif;
+    }
+    ws2812b_host_set_sink(capture_frame, &capture);
+    ws2812b_host_reset_stats();
+    scenario->start();
+    ws2812b_host_run_until(ws2812b_host_now() + duration_ms * 1000ull);
+
+    struct ws2812b_host_stats stats;
+    ws2812b_host_get_stats(&stats);
+    printf("%s: %u frames in %u ms, %u wake-ups, %.1f us per wake-up on average, %.1f us at most\n",
+           scenario->name, stats.frames, duration_ms, stats.wakeups,
+           stats.wakeups ? stats.busy_ns / 1000.0 / stats.wakeups : 0.0, stats.max_ns / 1000.0);
+    if(capture.gif) ws2812b_host_gif_close(capture.gif, ws2812b_host_now());
+    if(capture.out_file) fclose(capture.out_file);
+    if(capture.golden_file) {
+        // Frames missing from this run count as differences too
+        if(fgetc(capture.golden_file) != EOF) {
+            printf("%s: the golden file has more frames than this run\n", scenario->name);
+            capture.failed++;
+        }
+        fclose(capture.golden_file);
+        printf("%s: %u of %u frames differ from the golden ones\n", scenario->name, capture.failed, capture.frame);
+    }
+    return capture.failed ? 1 : 0;
+}
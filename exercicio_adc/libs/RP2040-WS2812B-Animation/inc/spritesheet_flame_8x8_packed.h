@@ -0,0 +1,21 @@
+static const uGRB32_t SHEET_FLAME_8X8_PALETTE[]={
+    0x00000000, 0x0000ff00, 0x0080ff00, 0x00ffff00, 0x00ffffff,
+};
+
+static const uint16_t SHEET_FLAME_8X8_OFFSETS[]={
+    0, 32, 65, 98,
+};
+
+static const uint8_t SHEET_FLAME_8X8_DATA[]={
+    0x00, 0xa0, 0x01, 0x50, 0x01, 0x02, 0x40, 0x41, 0x10, 0x11, 0x02, 0x03, 0x01, 0x02, 0x01, 0x00, 0x01, 0x02, 0x13, 0x02, 0x41, 0x02, 0x14, 0x03, 0x02, 0x10, 0x01, 0x03, 0x14, 0x03, 0x01, 0x00,
+    0x02, 0x00, 0x10, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x01, 0x11, 0x00, 0x10, 0x11, 0x11, 0x02, 0x10, 0x11, 0x23, 0x22, 0x21, 0x11, 0x33, 0x43, 0x11, 0x12, 0x24, 0x42, 0x21, 0x01, 0x34, 0x33, 0x10,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x10, 0x00, 0x11, 0x02, 0x10, 0x00, 0x11, 0x10, 0x00, 0x11, 0x12, 0x10, 0x10, 0x11, 0x33, 0x21, 0x10, 0x11, 0x24, 0x42, 0x11, 0x01, 0x34, 0x33, 0x21,
+    0x02, 0x00, 0x00, 0x00, 0x10, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x12, 0x11, 0x00, 0x01, 0x11, 0x11, 0x10, 0x11, 0x23, 0x21, 0x10, 0x11, 0x23, 0x32, 0x11, 0x01, 0x13, 0x43, 0x10,
+};
+
+static const FX_sheet_t SHEET_FLAME_8X8 = {
+    .palette = SHEET_FLAME_8X8_PALETTE,
+    .offsets = SHEET_FLAME_8X8_OFFSETS,
+    .data = SHEET_FLAME_8X8_DATA,
+    .frames = 4,
+};
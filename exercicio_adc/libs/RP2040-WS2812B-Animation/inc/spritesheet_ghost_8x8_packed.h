@@ -0,0 +1,23 @@
+static const uGRB32_t SHEET_GHOST_8X8_PALETTE[]={
+    0x00000000, 0x000000ff, 0x008000ff, 0x00ffffff,
+};
+
+static const uint16_t SHEET_GHOST_8X8_OFFSETS[]={
+    0, 32, 44, 63, 76, 88,
+};
+
+static const uint8_t SHEET_GHOST_8X8_DATA[]={
+    0x00, 0x90, 0x01, 0x22, 0x20, 0x01, 0x42, 0x00, 0x01, 0x02, 0x13, 0x02, 0x13, 0x02, 0x01, 0x02, 0x03, 0x00, 0x02, 0x03, 0x00, 0x02, 0x01, 0x62, 0x01, 0x62, 0x00, 0x12, 0x00, 0x12, 0x00, 0x02,
+    0x01, 0x38, 0x01, 0x01, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02, 0x01,
+    0x01, 0x22, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03, 0x12, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02, 0x01, 0x00,
+    0x01, 0x38, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02,
+    0x01, 0x38, 0x01, 0x01, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02, 0x01,
+    0x01, 0x22, 0x03, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x12, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02, 0x01, 0x00,
+};
+
+static const FX_sheet_t SHEET_GHOST_8X8 = {
+    .palette = SHEET_GHOST_8X8_PALETTE,
+    .offsets = SHEET_GHOST_8X8_OFFSETS,
+    .data = SHEET_GHOST_8X8_DATA,
+    .frames = 6,
+};
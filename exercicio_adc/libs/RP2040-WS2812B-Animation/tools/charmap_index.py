@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+
+import sys
+import os
+import re
+
+# Generate a two-level page table mapping Unicode code points to glyph
+# indices, from the character map of a font header (e.g. CHARMAP_CP0_EU).
+# Code points are split in blocks of 64: the page table holds one block
+# number per block of code points, each block holds one glyph index per
+# code point. Blocks without any glyph are not stored.
+
+BLOCK_BITS = 6
+BLOCK_SIZE = 1 << BLOCK_BITS
+MISSING = 0xffff
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        print ("Usage: %s [font header] [charmap name]" % (sys.argv[0],))
+        sys.exit(1)
+
+    source = open(sys.argv[1]).read()
+    name = sys.argv[2]
+    match = re.search(r"%s\[\d*\]\s*=\s*\{([^}]*)\}" % re.escape(name), source)
+    if not match:
+        print ("Character map %s not found" % name)
+        sys.exit(1)
+    charmap = [int(v, 0) for v in re.findall(r"0x[0-9a-fA-F]+|\d+", match.group(1))]
+
+    # The first glyph mapped to a code point wins, as with a linear scan
+    glyphs = {}
+    for index, codepoint in enumerate(charmap):
+        glyphs.setdefault(codepoint, index)
+
+    pages = (max(glyphs) >> BLOCK_BITS) + 1
+    blocks = []
+    page_table = []
+    for page in range(pages):
+        block = [glyphs.get((page << BLOCK_BITS) + i, MISSING) for i in range(BLOCK_SIZE)]
+        if all(v == MISSING for v in block):
+            page_table.append(0xff)
+        else:
+            page_table.append(len(blocks))
+            blocks.append(block)
+    if len(blocks) >= 0xff:
+        print ("Too many blocks for an 8-bit page table")
+        sys.exit(1)
+
+    prefix = name.replace("CHARMAP_", "")
+    guard = "%s_INDEX_H" % prefix
+    filename = os.path.join(os.path.dirname(sys.argv[1]), "%s_index.h" % prefix)
+    print ("Writing file: %s" % filename)
+    f = open(filename, "w+")
+    f.write("/**\n")
+    f.write(" * @file %s_index.h\n" % prefix)
+    f.write(" * @brief Code point to glyph index lookup for %s.\n" % name)
+    f.write(" * @details Generated by tools/charmap_index.py, do not edit.\n")
+    f.write(" */\n\n")
+    f.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+    f.write("#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n")
+    f.write("#define %s_BLOCK_BITS %d\n" % (prefix, BLOCK_BITS))
+    f.write("#define %s_PAGES %d\n" % (prefix, pages))
+    f.write("#define %s_EMPTY_PAGE 0xff\n" % prefix)
+    f.write("#define %s_MISSING 0x%04x\n\n" % (prefix, MISSING))
+
+    f.write("/**\n * @brief Block number for each block of %d code points, %s_EMPTY_PAGE if none is mapped.\n */\n"
+            % (BLOCK_SIZE, prefix))
+    f.write("static const uint8_t %s_PAGE_TABLE[%s_PAGES] = {\n" % (prefix, prefix))
+    for i in range(0, pages, 16):
+        f.write("    " + " ".join("0x%02x," % v for v in page_table[i:i + 16]) + "\n")
+    f.write("};\n\n")
+
+    f.write("/**\n * @brief Glyph index for each code point of a block, %s_MISSING if not mapped.\n */\n"
+            % prefix)
+    f.write("static const uint16_t %s_BLOCKS[%d][1 << %s_BLOCK_BITS] = {\n" % (prefix, len(blocks), prefix))
+    for n, block in enumerate(blocks):
+        first = page_table.index(n) << BLOCK_BITS
+        f.write("    { // U+%04x\n" % first)
+        for i in range(0, BLOCK_SIZE, 8):
+            f.write("        " + " ".join("0x%04x," % v for v in block[i:i + 8]) + "\n")
+        f.write("    },\n")
+    f.write("};\n\n")
+    f.write("#ifdef __cplusplus\n}\n#endif\n#endif //%s\n" % guard)
+    f.close()
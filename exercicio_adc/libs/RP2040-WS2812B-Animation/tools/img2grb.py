@@ -2,16 +2,198 @@
 
 import sys
 import os
-from PIL import Image
+import re
+import struct
 
 # Convert images to uRGB32_t arrays for use with
 # RP2040-WS2812B-Animation library.
+#
+# With --sheet, convert a sequence of 8x8 frames to a packed spritesheet
+# (FX_sheet_t) for use with ws2812b_spritesheet_packed. Frames can be
+# images, or an existing uGRB32_t spritesheet header.
+#
+# With --stream, write the same encoding to a binary animation container
+# of any length and size, for use with ws2812b_stream.
+
+PIXELS = 64
+
+# Frame types, see FX_sheet_t in ws2812b_animation.h
+FRAME_RLE = 0
+FRAME_DELTA = 1
+FRAME_RAW = 2
+
+def load_image(path):
+    from PIL import Image
+    image = Image.open(path).convert("RGBA")
+    bitmap = image.load()
+    frame = []
+    for y in range(0, image.size[1]):
+        for x in range(0, image.size[0]):
+            r, g, b, a = bitmap[x, y]
+            frame.append((g << 16) | (r << 8) | b)
+    return frame, image.size[0]
+
+def load_header(path):
+    source = open(path).read()
+    frames = []
+    for body in re.findall(r"uGRB32_t\s+\w+\[\]\s*=\s*\{([^}]*)\}", source):
+        frames.append([int(v, 16) & 0xffffff for v in re.findall(r"0x[0-9a-fA-F]+", body)])
+    return frames
+
+def runs(indices, start, end):
+    # Split indices[start:end] in runs of up to 16 equal values
+    tokens = []
+    i = start
+    while i < end:
+        n = 1
+        while i + n < end and n < 16 and indices[i + n] == indices[i]:
+            n += 1
+        tokens.append(((n - 1) << 4) | indices[i])
+        i += n
+    return tokens
+
+def encode_rle(indices):
+    return [FRAME_RLE] + runs(indices, 0, len(indices))
+
+def encode_delta(indices, previous):
+    pixels = len(indices)
+    data = [FRAME_DELTA]
+    i = 0
+    while i < pixels:
+        skip = 0
+        while i < pixels and indices[i] == previous[i] and skip < 255:
+            skip += 1
+            i += 1
+        data.append(skip)
+        if i >= pixels:
+            break
+        if indices[i] == previous[i]: # Skip count is a byte, repeat an unchanged pixel
+            data.append(indices[i])
+            i += 1
+            continue
+        n = 1
+        while i + n < pixels and n < 16 and indices[i + n] == indices[i] and indices[i + n] != previous[i + n]:
+            n += 1
+        data.append(((n - 1) << 4) | indices[i])
+        i += n
+    return data
+
+def encode_raw(indices):
+    padded = indices + [0] * (len(indices) % 2)
+    return [FRAME_RAW] + [(padded[i] << 4) | padded[i + 1] for i in range(0, len(padded), 2)]
+
+def make_palette(frames):
+    palette = []
+    for frame in frames:
+        if len(frame) != len(frames[0]):
+            print ("All frames must have the same size")
+            sys.exit(1)
+        for grb in frame:
+            if grb not in palette:
+                palette.append(grb)
+    if len(palette) > 16:
+        print ("Too many colors for a packed spritesheet: %d (16 max)" % len(palette))
+        sys.exit(1)
+    return palette
+
+def encode_frames(frames, palette):
+    encoded = []
+    previous = None
+    for frame in frames:
+        indices = [palette.index(grb) for grb in frame]
+        candidates = [encode_rle(indices), encode_raw(indices)]
+        if previous is not None: # The first frame must not depend on the last one
+            candidates.append(encode_delta(indices, previous))
+        encoded.append(min(candidates, key=len))
+        previous = indices
+    return encoded
+
+def write_sheet(name, frames):
+    if len(frames[0]) != PIXELS:
+        print ("Frames must be 8x8 pixels")
+        sys.exit(1)
+    palette = make_palette(frames)
+
+    data = []
+    offsets = []
+    for encoded in encode_frames(frames, palette):
+        offsets.append(len(data))
+        data += encoded
+
+    filename = "spritesheet_%s_8x8_packed" % name.lower()
+    symbol = "SHEET_%s_8X8" % name.upper()
+    print ("Writing file: %s.h (%d bytes, was %d)" %
+           (filename, len(data) + 2 * len(offsets) + 4 * len(palette), 4 * PIXELS * len(frames)))
+    f = open(filename + ".h", "w+")
+    f.write("static const uGRB32_t %s_PALETTE[]={\n    " % symbol)
+    f.write(" ".join("0x%08x," % grb for grb in palette))
+    f.write("\n};\n\n")
+    f.write("static const uint16_t %s_OFFSETS[]={\n    " % symbol)
+    f.write(" ".join("%d," % offset for offset in offsets))
+    f.write("\n};\n\n")
+    f.write("static const uint8_t %s_DATA[]={\n" % symbol)
+    for n, offset in enumerate(offsets):
+        end = offsets[n + 1] if n + 1 < len(offsets) else len(data)
+        f.write("    " + " ".join("0x%02x," % v for v in data[offset:end]) + "\n")
+    f.write("};\n\n")
+    f.write("static const FX_sheet_t %s = {\n" % symbol)
+    f.write("    .palette = %s_PALETTE,\n" % symbol)
+    f.write("    .offsets = %s_OFFSETS,\n" % symbol)
+    f.write("    .data = %s_DATA,\n" % symbol)
+    f.write("    .frames = %d,\n" % len(frames))
+    f.write("};\n")
+    f.close()
+
+def write_stream(filename, frames, width):
+    # Container layout, little endian, see stream_open in ws2812b_animation.c:
+    # "WSA1", frames (u32), width (u16), height (u16), largest record (u16),
+    # size of the first frame (u16), colors (u8), 3 reserved bytes, palette (u32 each),
+    # then one record per frame: encoded frame, size of the next frame (u16).
+    palette = make_palette(frames)
+    height = len(frames[0]) // width
+    encoded = encode_frames(frames, palette)
+    records = b""
+    for n, data in enumerate(encoded):
+        following = len(encoded[(n + 1) % len(encoded)])
+        records += bytes(data) + struct.pack("<H", following)
+    largest = max(len(data) for data in encoded) + 2
+    header = b"WSA1" + struct.pack("<IHHHHB3x", len(frames), width, height, largest,
+                                   len(encoded[0]), len(palette))
+    header += b"".join(struct.pack("<I", grb) for grb in palette)
+    print ("Writing file: %s (%d bytes, %d frames of %dx%d pixels)" %
+           (filename, len(header) + len(records), len(frames), width, height))
+    f = open(filename, "wb")
+    f.write(header + records)
+    f.close()
+
+def load_frames(paths):
+    # Frames and their width, spritesheet headers hold 8x8 frames
+    frames = []
+    width = 8
+    for path in paths:
+        if path.endswith(".h"):
+            frames += load_header(path)
+        else:
+            frame, width = load_image(path)
+            frames.append(frame)
+    return frames, width
 
 if __name__ == "__main__":
+    if len(sys.argv) >= 4 and sys.argv[1] == "--sheet":
+        write_sheet(sys.argv[2], load_frames(sys.argv[3:])[0])
+        sys.exit(0)
+
+    if len(sys.argv) >= 4 and sys.argv[1] == "--stream":
+        write_stream(sys.argv[2], *load_frames(sys.argv[3:]))
+        sys.exit(0)
+
     if len(sys.argv) != 2:
         print ("Usage: %s [image]" % (sys.argv[0],))
+        print ("       %s --sheet [name] [images or spritesheet header...]" % (sys.argv[0],))
+        print ("       %s --stream [file.wsa] [images or spritesheet header...]" % (sys.argv[0],))
         sys.exit(1)
 
+    from PIL import Image
     image = Image.open(sys.argv[1])
     bitmap = image.load()
 
@@ -31,4 +213,4 @@ if __name__ == "__main__":
         f.write("\n")
 
     f.write("};\n")
-    f.close()
\ No newline at end of file
+    f.close()
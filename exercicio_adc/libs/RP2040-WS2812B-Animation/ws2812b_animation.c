@@ -9,90 +9,748 @@
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
+#include "pico/sync.h"
+#if PICO_ON_DEVICE
+#include "hardware/dma.h"
+#endif
 #include "ws2812b_animation.h"
 #include "ws2812.pio.h"
 #include "CP0_EU_8x8.h" // https://github.com/TuriSc/CP0-EU
+#include "CP0_EU_index.h" // Generated by tools/charmap_index.py
 #include "utf-8.h"      // https://github.com/adrianwk94/utf8-iterator
 
 /**
- * @brief UTF-8 iterator for text rendering.
+ * @brief Range of pixel indices, from and to included.
  */
-static utf8_iter ITER;
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+} ws2812b_range_t;
 
 /**
- * @brief Buffer to store pixel data.
+ * @struct ws2812b
+ * @brief State of a strip. Everything in it is protected by its lock, which the public
+ * functions take on entry and the scheduler takes for each tick.
  */
-static uGRB32_t *ws2812b_buffer;
+struct ws2812b {
+    /**
+     * @brief Configuration structure for WS2812B LED strip.
+     */
+    struct ws2812b_config config;
+
+    /**
+     * @brief Spin lock of the strip, held with interrupts disabled.
+     */
+    critical_section_t lock;
+
+    /**
+     * @brief Core holding the lock plus one, 0 when free. Makes the lock reentrant.
+     */
+    volatile uint8_t lock_owner;
+
+    /**
+     * @brief Number of nested acquisitions of the lock by its owner.
+     */
+    uint8_t lock_depth;
+
+    /**
+     * @brief Flag set when the application calls ws2812b_tick itself instead of the alarm.
+     */
+    bool manual_tick;
+
+    /**
+     * @brief Buffer to store pixel data.
+     */
+    uGRB32_t *ws2812b_buffer;
+
+    /**
+     * @brief Text effect structure.
+     */
+    FX_t FX_text;
+
+    /**
+     * @brief Pool of effect structures, grown on demand by get_available_segment.
+     */
+    FX_t **fxs;
+
+    /**
+     * @brief Number of effect structures in the pool.
+     */
+    uint16_t fxs_size;
+
+    /**
+     * @brief Running effects in compositing order (ascending z), including FX_text.
+     */
+    FX_t **draw_order;
+
+    /**
+     * @brief Number of effects in draw_order.
+     */
+    uint16_t draw_count;
+
+    /**
+     * @brief Flag to request a rebuild of draw_order before the next composition.
+     */
+    bool draw_order_dirty;
+
+    /**
+     * @brief Composited frame: ws2812b_buffer with all effect layers blended on top.
+     */
+    uGRB32_t *ws2812b_frame;
+
+    /**
+     * @brief Pixel data as last transmitted to the strip (after inversion, dimming and masking).
+     */
+    uGRB32_t *ws2812b_shown;
+
+    /**
+     * @brief Disjoint ranges of pixels modified since the last render, in no particular order.
+     */
+    ws2812b_range_t dirty[WS2812B_DIRTY_RANGES];
+
+    /**
+     * @brief Number of ranges in dirty, 0 when nothing was drawn.
+     */
+    uint8_t dirty_count;
+
+    /**
+     * @brief Alarm ID of the scheduler, 0 when nothing is animating.
+     */
+    alarm_id_t scheduler_alarm;
+
+    /**
+     * @brief Time at which the scheduler alarm fires.
+     */
+    uint64_t scheduler_wake_us;
+
+    /**
+     * @brief Flag set while ws2812b_tick runs, the tick computes its own next wake-up.
+     */
+    bool in_tick;
+
+    /**
+     * @brief Time of the tick being run, effects are evaluated at this time.
+     */
+    uint64_t tick_us;
+
+    /**
+     * @brief Time of the last transmission, used to cap the framerate.
+     */
+    uint64_t last_render_us;
+
+    /**
+     * @brief Flag to request rendering.
+     */
+    bool request_render;
+
+    /**
+     * @brief UTF-8 iterator for text rendering.
+     */
+    utf8_iter ITER;
+
+    /**
+     * @brief Character being rendered.
+     */
+    const char* Character;
+
+    /**
+     * @brief Flag used by the typing effect to 'blink' between characters.
+     */
+    bool is_gap;
+
+    /**
+     * @brief Scrolling text rasterized as columns, bit y of each byte is row y.
+     */
+    uint8_t *text_columns;
+
+    /**
+     * @brief Number of columns in text_columns.
+     */
+    uint32_t text_columns_len;
+
+    /**
+     * @brief No mask for WS2812B LED strip.
+     */
+    uint8_t *no_mask;
+};
 
 /**
- * @brief Text effect structure.
+ * @brief Strip set up by ws2812b_init.
  */
-static FX_t FX_text;
+static ws2812b_t default_strip;
 
 /**
- * @brief Array of effect structures.
+ * @brief Strip used by the public functions, for each core.
  */
-static FX_t fxs[MAX_EFFECTS];
+static ws2812b_t *selected_strip[2] = { &default_strip, &default_strip };
 
 /**
- * @brief Timer ID for frame-by-frame rendering.
+ * @brief Take the lock of a strip. Reentrant: the core holding it can take it again.
+ * @param ws Strip.
+ * @return The same strip.
  */
-static alarm_id_t frame_by_frame_timer;
+static ws2812b_t* strip_lock(ws2812b_t *ws) {
+    uint8_t core = get_core_num() + 1;
+    if(ws->lock_owner == core) { // Interrupts are off while we hold it, no race here
+        ws->lock_depth++;
+        return ws;
+    }
+    critical_section_enter_blocking(&ws->lock);
+    ws->lock_owner = core;
+    ws->lock_depth = 1;
+    return ws;
+}
+
+/**
+ * @brief Release the lock of a strip.
+ * @param ws Strip.
+ */
+static void strip_unlock(ws2812b_t *ws) {
+    if(--ws->lock_depth) return;
+    ws->lock_owner = 0;
+    critical_section_exit(&ws->lock);
+}
+
+/**
+ * @brief Get the strip selected by the calling core and take its lock.
+ * @return Selected strip.
+ */
+static ws2812b_t* strip_enter() {
+    return strip_lock(selected_strip[get_core_num()]);
+}
+
+/**
+ * @brief Add a range of pixels to the dirty ranges, merging it with the ones it touches.
+ * When all ranges are taken, it is merged with the closest one instead.
+ * @param ws Strip.
+ * @param from Start pixel index.
+ * @param to End pixel index, not lower than from.
+ */
+static void add_dirty(ws2812b_t *ws, uint32_t from, uint32_t to) {
+    uint8_t n = 0;
+    while(n < ws->dirty_count) {
+        ws2812b_range_t *r = &ws->dirty[n];
+        if(from <= r->to + 1 && r->from <= to + 1) { // Overlapping or adjacent: take it out and merge
+            if(r->from < from) from = r->from;
+            if(r->to > to) to = r->to;
+            *r = ws->dirty[--ws->dirty_count];
+            n = 0; // The merged range may now touch one checked already
+            continue;
+        }
+        n++;
+    }
+    if(ws->dirty_count == WS2812B_DIRTY_RANGES) {
+        uint8_t closest = 0;
+        uint32_t closest_gap = UINT32_MAX;
+        for(n = 0; n < ws->dirty_count; n++) {
+            ws2812b_range_t *r = &ws->dirty[n];
+            uint32_t gap = (r->from > to) ? r->from - to : from - r->to;
+            if(gap < closest_gap) {
+                closest_gap = gap;
+                closest = n;
+            }
+        }
+        ws2812b_range_t *r = &ws->dirty[closest];
+        if(r->from < from) from = r->from;
+        if(r->to > to) to = r->to;
+        *r = ws->dirty[--ws->dirty_count];
+        add_dirty(ws, from, to); // Merged with the closest, may span others now
+        return;
+    }
+    ws->dirty[ws->dirty_count].from = from;
+    ws->dirty[ws->dirty_count].to = to;
+    ws->dirty_count++;
+}
+
+/**
+ * @brief Mark a range of pixels as modified since the last render.
+ * @param ws Strip.
+ * @param from Start pixel index.
+ * @param to End pixel index.
+ */
+static inline void mark_dirty(ws2812b_t *ws, uint32_t from, uint32_t to) {
+    if(from > to) {
+        uint32_t temp = from;
+        from = to;
+        to = temp;
+    }
+    for(uint8_t n = 0; n < ws->dirty_count; n++) { // Most calls draw inside a range marked already
+        if(ws->dirty[n].from <= from && to <= ws->dirty[n].to) return;
+    }
+    add_dirty(ws, from, to);
+}
+
+/**
+ * @brief Fill consecutive 32-bit words with a value, four stores per iteration.
+ * @param dst First word.
+ * @param value Value to store.
+ * @param count Number of words.
+ */
+static inline void fill_words(uint32_t *dst, uint32_t value, uint32_t count) {
+    uint32_t *end = dst + count;
+    while(end - dst >= 4) {
+        dst[0] = value;
+        dst[1] = value;
+        dst[2] = value;
+        dst[3] = value;
+        dst += 4;
+    }
+    while(dst < end) *dst++ = value;
+}
+
+/**
+ * @brief Memory that starting an effect may need, allocated without the lock by
+ * strip_reserve. What the effect does not take, and what it replaces, is freed by
+ * fx_spare_free once the lock is released.
+ */
+typedef struct {
+    FX_t *FX;           // New segment, when the pool has no idle one
+    FX_t **pool;        // Pool and draw order with room for it
+    FX_t **order;
+    uint16_t fxs_size;  // Size of the pool they were allocated for
+    uGRB32_t *layer;    // Layer of layer_len pixels
+    uint32_t layer_len;
+    uGRB32_t *palette;  // Gradient palette
+} fx_spare_t;
+
+/**
+ * @brief What starting an effect needs, see strip_reserve.
+ */
+typedef struct {
+    bool segment;       // A segment of the pool, FX_text otherwise
+    uint32_t from;      // Range of the layer...
+    uint32_t to;
+    uint16_t width;     // ...or a block from the top left corner when set, clamped to the display
+    uint16_t height;
+    bool palette;       // A gradient palette
+} fx_needs_t;
+
+/**
+ * @brief Free what an effect start did not take. The lock must not be held.
+ * @param spare Memory reserved by strip_reserve
+ */
+static void fx_spare_free(fx_spare_t *spare) {
+    free(spare->FX);
+    free(spare->pool);
+    free(spare->order);
+    free(spare->layer);
+    free(spare->palette);
+}
+
+/**
+ * @brief Get the first idle segment of the pool. The lock must be held.
+ * @param ws Strip
+ * @return Idle effect structure, NULL if all are busy.
+ */
+static FX_t* idle_segment(ws2812b_t *ws) {
+    for (uint16_t i = 0; i < ws->fxs_size; i++) {
+        if (!ws->fxs[i]->running) { return ws->fxs[i]; }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Get an available segment for an effect, growing the pool if all are busy.
+ * The lock must be held.
+ * @param ws Strip
+ * @param spare Memory reserved by strip_reserve, takes the replaced arrays
+ * @return Available effect structure, NULL if out of memory.
+ */
+static FX_t* get_available_segment(ws2812b_t *ws, fx_spare_t *spare) {
+    FX_t *FX = idle_segment(ws);
+    if (FX) { return FX; }
+    if (!spare->FX || !spare->pool || !spare->order || spare->fxs_size != ws->fxs_size) { return NULL; }
+
+    FX = spare->FX;
+    FX_t **pool = spare->pool;
+    FX_t **order = spare->order;
+    for (uint16_t i = 0; i < ws->fxs_size; i++) { pool[i] = ws->fxs[i]; }
+    pool[ws->fxs_size] = FX;
+    FX->strip = ws;
+
+    // The compositor walks both arrays, swap them while holding the lock
+    for (uint16_t i = 0; i < ws->draw_count; i++) { order[i] = ws->draw_order[i]; }
+    spare->FX = NULL;
+    spare->pool = ws->fxs; // Freed once the lock is released
+    spare->order = ws->draw_order;
+    ws->fxs = pool;
+    ws->draw_order = order;
+    ws->fxs_size++;
+    return FX;
+}
+
+/**
+ * @brief Layer functions.
+ */
+
+/**
+ * @brief Order and clamp the range of a layer.
+ * @param ws Strip
+ * @param from Start pixel index, updated
+ * @param to End pixel index, updated
+ * @return Number of pixels in the layer
+ */
+static uint32_t layer_range(ws2812b_t *ws, uint32_t *from, uint32_t *to) {
+    if(*from > *to) {
+        uint32_t temp = *from;
+        *from = *to;
+        *to = temp;
+    }
+    if(*to >= ws->config.num_pixels) *to = ws->config.num_pixels - 1;
+    return *to - *from + 1;
+}
+
+/**
+ * @brief Attach the layer of an effect and make it fully transparent.
+ * It is taken from spare when its size changes. The lock must be held.
+ * @param FX Effect descriptor, must not be running.
+ * @param from Start pixel index.
+ * @param to End pixel index.
+ * @param spare Memory reserved by strip_reserve, takes the replaced layer
+ * @return True on success, false if out of memory.
+ */
+static bool fx_attach_layer(FX_t *FX, uint32_t from, uint32_t to, fx_spare_t *spare) {
+    uint32_t len = layer_range(FX->strip, &from, &to);
+    if(len != FX->layer_len) {
+        if(!spare->layer || spare->layer_len != len) return false;
+        uGRB32_t *layer = FX->layer;
+        FX->layer = spare->layer;
+        FX->layer_len = len;
+        spare->layer = layer; // Freed once the lock is released
+        spare->layer_len = 0;
+    }
+    FX->layer_from = from;
+    memset(FX->layer, 0, len * sizeof(uGRB32_t));
+    return true;
+}
+
+/**
+ * @brief Set a pixel in the layer of an effect.
+ * @param FX Effect descriptor
+ * @param pixel Absolute pixel index, ignored if outside of the layer
+ * @param grb 24-bit GRB color value
+ */
+static inline void fx_put(FX_t *FX, uint32_t pixel, uGRB32_t grb) {
+    ws2812b_t *ws = FX->strip;
+    uint32_t i = pixel - FX->layer_from;
+    if(i >= FX->layer_len) return;
+    FX->layer[i] = grb | WS2812B_OPAQUE;
+    mark_dirty(ws, pixel, pixel);
+}
+
+/**
+ * @brief Get the strip index of a pixel, without the public API overhead.
+ * @param ws Strip
+ * @param x Column
+ * @param y Row
+ * @return Pixel index, WS2812B_NO_PIXEL if outside of the display
+ */
+static inline uint16_t lookup_xy(ws2812b_t *ws, uint16_t x, uint16_t y) {
+    if(x >= ws->config.width || y >= ws->config.height) return WS2812B_NO_PIXEL;
+    return ws->config.xy_lut[y * ws->config.width + x];
+}
+
+/**
+ * @brief Set a pixel in the layer of an effect by its coordinates.
+ * @param FX Effect descriptor
+ * @param x Column
+ * @param y Row
+ * @param grb 24-bit GRB color value
+ */
+static inline void fx_put_xy(FX_t *FX, uint16_t x, uint16_t y, uGRB32_t grb) {
+    ws2812b_t *ws = FX->strip;
+    uint16_t pixel = lookup_xy(ws, x, y);
+    if(pixel != WS2812B_NO_PIXEL) fx_put(FX, pixel, grb);
+}
+
+/**
+ * @brief Fill the 8x8 block used by text and sprites in the layer of an effect.
+ * @param FX Effect descriptor
+ * @param grb 24-bit GRB color value
+ */
+static void fx_fill_block(FX_t *FX, uGRB32_t grb) {
+    for(uint8_t y = 0; y < 8; y++) {
+        for(uint8_t x = 0; x < 8; x++) {
+            fx_put_xy(FX, x, y, grb);
+        }
+    }
+}
+
+/**
+ * @brief Get the range of pixels covered by a block from the top left corner.
+ * @param ws Strip
+ * @param width Width of the block, clamped to the display
+ * @param height Height of the block, clamped to the display
+ * @param from Start pixel index
+ * @param to End pixel index
+ */
+static void block_range(ws2812b_t *ws, uint16_t width, uint16_t height, uint32_t *from, uint32_t *to) {
+    if(width > ws->config.width) width = ws->config.width;
+    if(height > ws->config.height) height = ws->config.height;
+    *from = UINT16_MAX;
+    *to = 0;
+    for(uint16_t y = 0; y < height; y++) {
+        for(uint16_t x = 0; x < width; x++) {
+            uint16_t pixel = lookup_xy(ws, x, y);
+            if(pixel == WS2812B_NO_PIXEL) continue;
+            if(pixel < *from) *from = pixel;
+            if(pixel > *to) *to = pixel;
+        }
+    }
+    if(*from > *to) *from = *to = 0; // No pixel in the block
+}
+
+/**
+ * @brief Attach a layer covering a block of pixels from the top left corner.
+ * @param FX Effect descriptor, must not be running.
+ * @param width Width of the block
+ * @param height Height of the block
+ * @param spare Memory reserved by strip_reserve
+ * @return True on success, false if out of memory.
+ */
+static bool fx_attach_block(FX_t *FX, uint16_t width, uint16_t height, fx_spare_t *spare) {
+    uint32_t from, to;
+    block_range(FX->strip, width, height, &from, &to);
+    return fx_attach_layer(FX, from, to, spare);
+}
+
+/**
+ * @brief Allocate what starting an effect needs, then take the lock of a strip.
+ * What is missing is checked under the lock and allocated without it, again until
+ * nothing is, as another core may start an effect or change the geometry meanwhile.
+ * The start then only takes from spare, without using the heap.
+ * @param ws Strip
+ * @param needs What the effect needs
+ * @param spare Filled by this function, pass it to fx_spare_free after unlocking
+ * @return The same strip, locked. When out of memory, the start fails under the lock.
+ */
+static ws2812b_t* strip_reserve(ws2812b_t *ws, const fx_needs_t *needs, fx_spare_t *spare) {
+    *spare = (fx_spare_t){0};
+    while(true) {
+        strip_lock(ws);
+        FX_t *FX = (needs->segment ? idle_segment(ws) : &ws->FX_text);
+        uint16_t size = ws->fxs_size;
+        uint32_t from = needs->from;
+        uint32_t to = needs->to;
+        if(needs->width) block_range(ws, needs->width, needs->height, &from, &to);
+        uint32_t len = layer_range(ws, &from, &to);
+        bool grow = !FX && !(spare->FX && spare->fxs_size == size);
+        bool layer = !(FX && FX->layer_len == len) && spare->layer_len != len;
+        bool palette = needs->palette && !(FX && FX->palette) && !spare->palette;
+        if(!grow && !layer && !palette) return ws;
+        strip_unlock(ws);
+
+        if(grow) {
+            free(spare->FX);
+            free(spare->pool);
+            free(spare->order);
+            spare->FX = calloc(1, sizeof(FX_t));
+            spare->pool = malloc((size + 1) * sizeof(FX_t*));
+            spare->order = malloc((size + 2) * sizeof(FX_t*)); // One more for FX_text
+            spare->fxs_size = size;
+        }
+        if(layer) {
+            free(spare->layer);
+            spare->layer = malloc(len * sizeof(uGRB32_t));
+            spare->layer_len = (spare->layer ? len : 0);
+        }
+        if(palette) spare->palette = malloc(256 * sizeof(uGRB32_t));
+        if((grow && (!spare->FX || !spare->pool || !spare->order)) ||
+           (layer && !spare->layer) || (palette && !spare->palette)) {
+            return strip_lock(ws);
+        }
+    }
+}
+
+/**
+ * @brief Allocate what starting an effect needs, then take the lock of the selected strip.
+ * @param needs What the effect needs
+ * @param spare Filled by this function, pass it to fx_spare_free after unlocking
+ * @return Selected strip, locked.
+ */
+static ws2812b_t* strip_enter_reserved(const fx_needs_t *needs, fx_spare_t *spare) {
+    return strip_reserve(selected_strip[get_core_num()], needs, spare);
+}
 
 /**
- * @brief Timer ID for rendering.
+ * @brief Fill a range of pixels in the layer of an effect.
+ * @param FX Effect descriptor
+ * @param from Start pixel index
+ * @param to End pixel index
+ * @param grb 24-bit GRB color value
  */
-static repeating_timer_t rendering_timer;
+static void fx_fill(FX_t *FX, uint32_t from, uint32_t to, uGRB32_t grb) {
+    ws2812b_t *ws = FX->strip;
+    if(from > to) {
+        uint32_t temp = from;
+        from = to;
+        to = temp;
+    }
+    if(from < FX->layer_from) from = FX->layer_from;
+    if(to >= FX->layer_from + FX->layer_len) to = FX->layer_from + FX->layer_len - 1;
+    if(from > to) return;
+    for(uint32_t i = from; i <= to; i++) {
+        FX->layer[i - FX->layer_from] = grb | WS2812B_OPAQUE;
+    }
+    mark_dirty(ws, from, to);
+}
 
 /**
- * @brief Array of timer IDs for animation effects.
+ * @brief Divide by 255, exact for any product of two 8-bit values.
+ * @param x Dividend (0-65535)
+ * @return x / 255
  */
-static alarm_id_t animation_timers[MAX_EFFECTS];
+static inline uint32_t div255(uint32_t x) {
+    return (x + 1u + (x >> 8u)) >> 8u;
+}
 
 /**
- * @brief Flag to request rendering.
+ * @brief Interpolate between two colors, all channels at once.
+ * @param a 24-bit GRB color value at t = 0
+ * @param b 24-bit GRB color value at t = 256
+ * @param t Position between the two colors (0-256)
+ * @return Interpolated 24-bit GRB color value
  */
-static bool request_render;
+static inline uGRB32_t lerp256(uGRB32_t a, uGRB32_t b, uint32_t t) {
+    // Green and blue are 16 bits apart and interpolated together, red on its own
+    uint32_t gb = a & 0xff00ffu;
+    uint32_t r = a & 0x00ff00u;
+    gb = (gb + ((((b & 0xff00ffu) - gb) * t) >> 8u)) & 0xff00ffu;
+    r = (r + ((((b & 0x00ff00u) - r) * t) >> 8u)) & 0x00ff00u;
+    return gb | r;
+}
 
 /**
- * @brief Character being rendered.
+ * @brief Blend two pixels.
+ * @param dst Underlying 24-bit GRB color value
+ * @param src Layer 24-bit GRB color value
+ * @param blend Blend mode
+ * @param alpha Opacity for FX_BLEND_ALPHA (0-255)
+ * @return Blended 24-bit GRB color value
  */
-static const char* Character;
+static inline uGRB32_t blend_pixel(uGRB32_t dst, uGRB32_t src, FX_blend_t blend, uint8_t alpha) {
+    uGRB32_t out = 0;
+    switch(blend) {
+        case FX_BLEND_ADD:
+            for(uint8_t shift = 0; shift <= 16; shift += 8) {
+                uint32_t c = ((dst >> shift) & 0xffu) + ((src >> shift) & 0xffu);
+                out |= (c > 0xff ? 0xff : c) << shift;
+            }
+            return out;
+        case FX_BLEND_ALPHA:
+            return lerp256(dst, src & 0x00ffffffu, alpha + (alpha >> 7u));
+        case FX_BLEND_REPLACE:
+        default:
+            return src & 0x00ffffffu;
+    }
+}
 
 /**
- * @brief Double buffer for text rendering.
+ * @brief Blend the layer of an effect into a buffer, limited to a range of pixels.
+ * @param FX Effect descriptor
+ * @param dst Buffer of config.num_pixels pixels
+ * @param from Start pixel index
+ * @param to End pixel index
  */
-static int double_buffer[8][16];
+static void blend_layer(FX_t *FX, uGRB32_t *dst, uint32_t from, uint32_t to) {
+    if(from < FX->layer_from) from = FX->layer_from;
+    if(to >= FX->layer_from + FX->layer_len) to = FX->layer_from + FX->layer_len - 1;
+    for(uint32_t i = from; i <= to; i++) {
+        uGRB32_t src = FX->layer[i - FX->layer_from];
+        if(!(src & WS2812B_OPAQUE)) continue; // Transparent
+        dst[i] = blend_pixel(dst[i], src, FX->blend, FX->alpha);
+    }
+}
 
 /**
- * @brief Configuration structure for WS2812B LED strip.
+ * @brief Stop compositing an effect layer.
+ * @param FX Effect descriptor
+ * @param bake Merge the layer into ws2812b_buffer first, so its content stays visible
  */
-static struct ws2812b_config config;
+static void fx_detach(FX_t *FX, bool bake) {
+    ws2812b_t *ws = FX->strip;
+    if(bake && FX->layer_len) {
+        blend_layer(FX, ws->ws2812b_buffer, FX->layer_from, FX->layer_from + FX->layer_len - 1);
+    }
+    FX->running = false;
+    ws->draw_order_dirty = true;
+    if(FX->layer_len) mark_dirty(ws, FX->layer_from, FX->layer_from + FX->layer_len - 1);
+}
 
 /**
- * @brief No mask for WS2812B LED strip.
+ * @brief Rebuild the list of running effects, sorted by z (insertion order on ties).
+ * @param ws Strip
  */
-static uint8_t *no_mask;
+static void update_draw_order(ws2812b_t *ws) {
+    ws->draw_order_dirty = false;
+    ws->draw_count = 0;
+    for (uint16_t i = 0; i < ws->fxs_size; i++) {
+        if (ws->fxs[i]->running && ws->fxs[i]->layer_len) { ws->draw_order[ws->draw_count++] = ws->fxs[i]; }
+    }
+    if (ws->FX_text.running && ws->FX_text.layer_len) { ws->draw_order[ws->draw_count++] = &ws->FX_text; }
+    for (uint16_t i = 1; i < ws->draw_count; i++) {
+        FX_t *FX = ws->draw_order[i];
+        uint16_t j = i;
+        while (j > 0 && ws->draw_order[j - 1]->z > FX->z) {
+            ws->draw_order[j] = ws->draw_order[j - 1];
+            j--;
+        }
+        ws->draw_order[j] = FX;
+    }
+}
 
 /**
- * @brief Get an available segment for an effect.
- * @return Available segment index.
+ * @brief Compose a range of the frame: ws2812b_buffer, then each running layer by ascending z.
+ * @param ws Strip
+ * @param from Start pixel index
+ * @param to End pixel index
  */
-static uint8_t get_available_segment() {
-    for (uint8_t i = 0; i < MAX_EFFECTS; i++) {
-        if (!fxs[i].running) { return i; }
+static void composite(ws2812b_t *ws, uint32_t from, uint32_t to) {
+    memcpy(&ws->ws2812b_frame[from], &ws->ws2812b_buffer[from], (to - from + 1) * sizeof(uGRB32_t));
+    if(ws->draw_order_dirty) update_draw_order(ws);
+    for(uint16_t n = 0; n < ws->draw_count; n++) {
+        FX_t *FX = ws->draw_order[n];
+        if(!FX->running) continue; // Stopped since the last rebuild
+        blend_layer(FX, ws->ws2812b_frame, from, to);
     }
-    return MAX_EFFECTS - 1; // Fallback
 }
 
 /**
  * @brief Initialize random number generator.
+ * @param ws Strip
+ */
+static void init_random(ws2812b_t *ws) {
+    if(!ws->config.random_seeded) {
+        uint64_t seed = time_us_64();
+        ws->config.random_state = (uint32_t)(seed ^ (seed >> 32)) | 1u; // Xorshift state must not be 0
+        ws->config.random_seeded = true;
+    }
+}
+
+/**
+ * @brief Convert a hue to a color.
+ * @param h Hue (0-1535), 256 steps for each sixth of the color wheel
+ * @param s Saturation (0-255)
+ * @param v Value (0-255)
+ * @return 24-bit GRB color value
  */
-static void init_random() {
-    if(!config.random_seeded) {
-        srand(time_us_64());
-        config.random_seeded = true;
+static uGRB32_t hsv_to_grb(uint32_t h, uint32_t s, uint32_t v) {
+    uint32_t f = h & 0xffu;
+    uint32_t p = div255(v * (255u - s));
+    uint32_t q = div255(v * (255u - div255(s * f)));
+    uint32_t t = div255(v * (255u - div255(s * (255u - f))));
+    uint32_t r, g, b;
+
+    switch((h >> 8u) % 6u) {
+        case 0: r = v, g = t, b = p; break;
+        case 1: r = q, g = v, b = p; break;
+        case 2: r = p, g = v, b = t; break;
+        case 3: r = p, g = q, b = v; break;
+        case 4: r = t, g = p, b = v; break;
+        default: r = v, g = p, b = q; break;
     }
+
+    return (r << 8) | (g << 16) | b;
 }
 
 /**
@@ -130,34 +788,192 @@ uGRB32_t ws2812b_hex(uint32_t hex) {
 
 /**
  * @brief Create a 24-bit color from HSV values.
+ * The conversion itself is done in fixed point, see ws2812b_hsv_int.
  * @param _h Hue (0.0-360.0).
  * @param _s Saturation (0.0-100.0).
  * @param _v Value (0.0-100.0).
  * @return 24-bit color value.
  */
 uGRB32_t ws2812b_hsv(float _h, float _s, float _v) {
-    float r, g, b;
-	
-	float h = _h / 360;
-	float s = _s / 100;
-	float v = _v / 100;
-	
-	int i   = h * 6;
-	float f = h * 6 - i;
-	float p = v * (1 - s);
-	float q = v * (1 - f * s);
-	float t = v * (1 - (1 - f) * s);
-	
-	switch (i % 6) {
-		case 0: r = v, g = t, b = p; break;
-		case 1: r = q, g = v, b = p; break;
-		case 2: r = p, g = v, b = t; break;
-		case 3: r = p, g = q, b = v; break;
-		case 4: r = t, g = p, b = v; break;
-		case 5: r = v, g = p, b = q; break;
-	}
-
-    return ((uint32_t)(r * 255) << 8) | ((uint32_t)(g * 255) << 16) | (uint32_t)(b * 255);
+    int32_t h = (int32_t)(_h * (1536.0f / 360.0f)) % 1536;
+    if(h < 0) h += 1536;
+    uint32_t s = (_s <= 0.0f) ? 0 : (_s >= 100.0f) ? 255 : (uint32_t)(_s * 2.55f);
+    uint32_t v = (_v <= 0.0f) ? 0 : (_v >= 100.0f) ? 255 : (uint32_t)(_v * 2.55f);
+    return hsv_to_grb((uint32_t)h, s, v);
+}
+
+/**
+ * @brief Create a 24-bit color from integer HSV values, without floating point math.
+ * @param h Hue in degrees (0-359, larger values wrap around).
+ * @param s Saturation (0-100).
+ * @param v Value (0-100).
+ * @return 24-bit color value.
+ */
+uGRB32_t ws2812b_hsv_int(uint16_t h, uint8_t s, uint8_t v) {
+    uint32_t hue = (h % 360u) * 64u / 15u; // 360 degrees to 1536 steps
+    return hsv_to_grb(hue, (s >= 100) ? 255 : s * 255u / 100u, (v >= 100) ? 255 : v * 255u / 100u);
+}
+
+/**
+ * @brief Convert a 24-bit color to integer HSV values.
+ * @param grb 24-bit color value.
+ * @param h Hue in degrees (0-359), 0 for grays.
+ * @param s Saturation (0-100).
+ * @param v Value (0-100).
+ */
+void ws2812b_to_hsv(uGRB32_t grb, uint16_t *h, uint8_t *s, uint8_t *v) {
+    int32_t g = (grb >> 16u) & 0xffu;
+    int32_t r = (grb >> 8u) & 0xffu;
+    int32_t b = grb & 0xffu;
+    int32_t max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    int32_t min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    int32_t delta = max - min;
+    int32_t hue = 0;
+
+    if(delta) {
+        if(max == r) hue = (60 * (g - b) + delta / 2) / delta;
+        else if(max == g) hue = 120 + (60 * (b - r) + delta / 2) / delta;
+        else hue = 240 + (60 * (r - g) + delta / 2) / delta;
+        if(hue < 0) hue += 360;
+        if(hue >= 360) hue -= 360;
+    }
+
+    *h = (uint16_t)hue;
+    *s = max ? (uint8_t)((delta * 100 + max / 2) / max) : 0;
+    *v = (uint8_t)((max * 100 + 127) / 255);
+}
+
+/**
+ * @brief Interpolate between two colors.
+ * @param a 24-bit color value at t = 0.
+ * @param b 24-bit color value at t = 255.
+ * @param t Position between the two colors (0-255).
+ * @return 24-bit color value.
+ */
+uGRB32_t ws2812b_lerp(uGRB32_t a, uGRB32_t b, uint8_t t) {
+    return lerp256(a, b, t + (t >> 7u)); // 255 maps to 256, so b is reached exactly
+}
+
+/**
+ * @brief Scale the brightness of a color.
+ * @param grb 24-bit color value.
+ * @param scale Brightness (0-255, 255 leaves the color unchanged).
+ * @return 24-bit color value.
+ */
+uGRB32_t ws2812b_scale(uGRB32_t grb, uint8_t scale) {
+    uint32_t n = scale + 1u;
+    return (((grb & 0xff00ffu) * n >> 8u) & 0xff00ffu) | (((grb & 0x00ff00u) * n >> 8u) & 0x00ff00u);
+}
+
+/**
+ * @brief Build a 256-entry gradient palette from evenly spaced color stops.
+ * @param palette Destination palette.
+ * @param stops Array of 24-bit color values.
+ * @param count Number of stops (at least 2).
+ */
+void ws2812b_palette(uGRB32_t palette[256], const uGRB32_t *stops, uint8_t count) {
+    if(count < 2) count = 2;
+    for(uint32_t i = 0; i < 256; i++) {
+        uint32_t pos = i * (count - 1u); // Position along the stops, 255 per segment
+        uint32_t segment = pos / 255u;
+        if(segment >= count - 1u) {
+            palette[i] = stops[count - 1] & 0x00ffffffu;
+        } else {
+            palette[i] = ws2812b_lerp(stops[segment], stops[segment + 1], pos - segment * 255u);
+        }
+    }
+}
+
+/**
+ * @brief Hash a noise lattice point.
+ * @param x Lattice column
+ * @param y Lattice row
+ * @param z Lattice depth
+ * @return Pseudo-random value (0-255), always the same for the same point
+ */
+static inline uint32_t noise_lattice(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t h = (x * 0x8da6b343u) ^ (y * 0xd8163841u) ^ (z * 0xcb1ab31fu);
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h >> 24;
+}
+
+/**
+ * @brief Smoothstep a noise cell fraction, so cells join without creases.
+ * @param f Fraction (0-255)
+ * @return Eased fraction (0-255)
+ */
+static inline uint32_t noise_fade(uint32_t f) {
+    return (f * f * (768u - 2u * f)) >> 16;
+}
+
+/**
+ * @brief Interpolate between two noise values.
+ * @param a Value at f = 0
+ * @param b Value at f = 256
+ * @param f Fraction (0-255)
+ * @return Interpolated value
+ */
+static inline uint32_t noise_lerp(uint32_t a, uint32_t b, uint32_t f) {
+    return (uint32_t)((int32_t)a + ((((int32_t)b - (int32_t)a) * (int32_t)f) >> 8));
+}
+
+/**
+ * @brief Bilinear value noise on one plane of the lattice.
+ * @param xi Lattice column
+ * @param yi Lattice row
+ * @param zi Lattice depth
+ * @param fx Eased horizontal fraction (0-255)
+ * @param fy Eased vertical fraction (0-255)
+ * @return Noise value (0-255)
+ */
+static inline uint32_t noise_plane(uint32_t xi, uint32_t yi, uint32_t zi, uint32_t fx, uint32_t fy) {
+    uint32_t top = noise_lerp(noise_lattice(xi, yi, zi), noise_lattice(xi + 1, yi, zi), fx);
+    uint32_t bottom = noise_lerp(noise_lattice(xi, yi + 1, zi), noise_lattice(xi + 1, yi + 1, zi), fx);
+    return noise_lerp(top, bottom, fy);
+}
+
+/**
+ * @brief Sample 3D value noise, in fixed point.
+ * 2D samples (z multiple of 256) hash 4 lattice points, 3D ones 8.
+ * @param x Horizontal coordinate, 8.8 fixed point (256 is one noise cell).
+ * @param y Vertical coordinate, 8.8 fixed point.
+ * @param z Depth or time coordinate, 8.8 fixed point. Keep it a multiple of 256 for 2D noise.
+ * @return Smooth noise value (0-255).
+ */
+uint8_t ws2812b_noise(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t fx = noise_fade(x & 0xffu);
+    uint32_t fy = noise_fade(y & 0xffu);
+    uint32_t near = noise_plane(x >> 8, y >> 8, z >> 8, fx, fy);
+    if(!(z & 0xffu)) return near;
+    uint32_t far = noise_plane(x >> 8, y >> 8, (z >> 8) + 1, fx, fy);
+    return noise_lerp(near, far, noise_fade(z & 0xffu));
+}
+
+/**
+ * @brief Get a pseudo-random number from the xorshift generator of a strip.
+ * @param ws Strip.
+ * @return 32-bit pseudo-random number.
+ */
+static uint32_t strip_random(ws2812b_t *ws) {
+    init_random(ws);
+    uint32_t x = ws->config.random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    ws->config.random_state = x;
+    return x;
+}
+
+/**
+ * @brief Get a pseudo-random number from the library's xorshift generator.
+ * Works before ws2812b_init, so the generator is not locked: two cores
+ * calling it at once may get the same number.
+ * @return 32-bit pseudo-random number.
+ */
+uint32_t ws2812b_random() {
+    return strip_random(selected_strip[get_core_num()]);
 }
 
 /**
@@ -166,9 +982,9 @@ uGRB32_t ws2812b_hsv(float _h, float _s, float _v) {
  * @return 24-bit color value.
  */
 uGRB32_t ws2812b_random_color(float value) {
-    init_random();
-    float h = (rand() % 360);
-    return ws2812b_hsv(h, 100.0f, value);
+    uint32_t v = (value <= 0.0f) ? 0 : (value >= 100.0f) ? 255 : (uint32_t)(value * 2.55f);
+    uint32_t h = ((ws2812b_random() >> 16) * 1536u) >> 16; // Full color wheel, no modulo bias
+    return hsv_to_grb(h, 255, v);
 }
 
 /**
@@ -177,476 +993,1758 @@ uGRB32_t ws2812b_random_color(float value) {
 
 /**
  * @brief Write a pixel to the LED strip in blocking mode.
+ * @param ws Strip.
  * @param pixel_grb 24-bit color value.
  */
-static inline void ws2812b_write_blocking(uGRB32_t pixel_grb) {
-    pio_sm_put_blocking(config.pio, config.pio_sm, pixel_grb << 8u);
+static inline void ws2812b_write_blocking(ws2812b_t *ws, uGRB32_t pixel_grb) {
+    pio_sm_put_blocking(ws->config.pio, ws->config.pio_sm, pixel_grb << 8u);
+}
+
+/**
+ * @brief Compute the value of a pixel as it will be sent to the strip.
+ * @param ws Strip.
+ * @param i Pixel index.
+ * @return 24-bit color value after inversion, dimming and masking.
+ */
+static inline uGRB32_t output_pixel(ws2812b_t *ws, uint32_t i) {
+    uGRB32_t p = ws->ws2812b_frame[i];
+    uint8_t g = ((p >> 16u) & 0xffu);
+    uint8_t r = ((p >> 8u) & 0xffu);
+    uint8_t b = (p & 0xffu);
+    // Invert colors
+    if(ws->config.inverted) {
+        g = 255 - g;
+        r = 255 - r;
+        b = 255 - b;
+    }
+    // Apply global dimming
+    g >>= ws->config.global_dimming;
+    r >>= ws->config.global_dimming;
+    b >>= ws->config.global_dimming;
+    p = ws2812b_rgb(r, g, b);
+    // Apply mask
+    return p * ws->config.global_mask[i];
 }
 
 /**
- * @brief Render the LED strip.
- * @return True if rendering was successful, false otherwise.
+ * @brief Prepare the next frame of the LED strip. The lock must be held.
+ * Only the dirty range is composited and compared with the last transmitted frame.
+ * A frame with no visible change is skipped. Otherwise, since WS2812B pixels latch
+ * the first 24 bits they receive and pass the rest down the chain, only the pixels
+ * up to the last changed one are retransmitted; the tail keeps its current state.
+ * @param ws Strip
+ * @param now_us Current time in microseconds
+ * @return Number of pixels of ws2812b_shown to transmit, 0 if none
  */
-static bool render() {
-    if(request_render) {
-        request_render = false;
-        for(uint32_t i=0; i<config.num_pixels; i++) {
-            uGRB32_t p = ws2812b_buffer[i];
-            uint8_t g = ((p >> 16u) & 0xffu);
-            uint8_t r = ((p >> 8u) & 0xffu);
-            uint8_t b = (p & 0xffu);
-            // Invert colors
-            if(config.inverted) {
-            g = 255 - g;
-            r = 255 - r;
-            b = 255 - b;
+static uint32_t prepare_frame(ws2812b_t *ws, uint64_t now_us) {
+    if(!ws->request_render) return 0;
+    ws->request_render = false;
+    if(!ws->dirty_count) return 0; // Nothing was drawn since the last frame
+
+    // Each range is composited on its own, effects far apart don't pull the pixels between them
+    int32_t last_changed = -1;
+    for(uint8_t n = 0; n < ws->dirty_count; n++) {
+        uint32_t from = ws->dirty[n].from;
+        uint32_t to = ws->dirty[n].to;
+        if(from >= ws->config.num_pixels) continue;
+        if(to >= ws->config.num_pixels) to = ws->config.num_pixels - 1;
+        composite(ws, from, to);
+        for(uint32_t i=from; i<=to; i++) {
+            uGRB32_t p = output_pixel(ws, i);
+            if(p != ws->ws2812b_shown[i]) {
+                ws->ws2812b_shown[i] = p;
+                if((int32_t)i > last_changed) last_changed = i;
             }
-            // Apply global dimming
-            g >>= config.global_dimming;
-            r >>= config.global_dimming;
-            b >>= config.global_dimming;
-            p = ws2812b_rgb(r, g, b);
-            // Apply mask
-            p *= config.global_mask[i];//mask(p, i, config.global_mask);
-            ws2812b_write_blocking(p);
         }
     }
+    ws->dirty_count = 0;
+    if(last_changed < 0) return 0; // Identical to the last transmitted frame
+
+    ws->last_render_us = now_us;
+    return last_changed + 1;
 }
 
 /**
- * @brief Initialize the state machine.
- * @param pio PIO instance.
- * @param gpio GPIO pin.
- * @param num_pixels Number of pixels in the LED strip.
+ * @brief Transmit the start of the frame prepared by prepare_frame, without the lock.
+ * Only the tick changes ws2812b_shown, and a strip runs one tick at a time.
+ * @param ws Strip
+ * @param count Number of pixels to transmit
  */
-void ws2812b_init(PIO _pio, uint8_t gpio, uint16_t _num_pixels) {
-    config.animation_step_ms = 20; // 20ms = 50fps animations
-    config.num_pixels = _num_pixels;
-    config.pio = _pio;
-    config.pio_sm = pio_claim_unused_sm(_pio, true);
-    uint offset = pio_add_program(_pio, &ws2812_program);
-    ws2812_program_init(_pio, config.pio_sm, offset, gpio, WS2812B_FREQ_HZ, WS2812B_IS_RGBW);
-    
-    // Allocate memory to store pixel data
-    ws2812b_buffer = malloc(_num_pixels * sizeof(ws2812b_buffer));
-    for (uint32_t i = 0; i < _num_pixels; i++) {
-        ws2812b_buffer[i] = 0;
+static void transmit(ws2812b_t *ws, uint32_t count) {
+    for(uint32_t i=0; i<count; i++) {
+        ws2812b_write_blocking(ws, ws->ws2812b_shown[i]);
+    }
+}
+
+/**
+ * @brief Scheduler functions.
+ */
+
+/**
+ * @brief Advance an effect to the current time, running every step that is due.
+ * @param FX Effect descriptor
+ * @param now_us Current time in microseconds
+ */
+static void fx_advance(FX_t *FX, uint64_t now_us) {
+    for(uint8_t n = 1; FX->running && FX->due_us <= now_us; n++) {
+        int64_t delay_us = FX->step(FX);
+        if(delay_us <= 0) return; // The effect has ended
+        FX->due_us += delay_us;
+        if(n == WS2812B_MAX_CATCHUP_STEPS && FX->due_us <= now_us) {
+            FX->due_us = now_us + delay_us; // Too far behind, drop the missed steps
+        }
+    }
+}
+
+/**
+ * @brief Advance all running effects of a strip and prepare a frame if one is due.
+ * The lock must be held.
+ * @param ws Strip
+ * @param now_us Current time in microseconds
+ * @return Number of pixels to transmit, 0 if none
+ */
+static uint32_t strip_advance(ws2812b_t *ws, uint64_t now_us) {
+    ws->tick_us = now_us;
+    for(uint16_t i = 0; i < ws->fxs_size; i++) {
+        fx_advance(ws->fxs[i], now_us);
+    }
+    fx_advance(&ws->FX_text, now_us);
+
+    if(!ws->request_render || now_us < ws->last_render_us + WS2812B_FRAME_US) return 0;
+    return prepare_frame(ws, now_us);
+}
+
+/**
+ * @brief Compute when a strip has to be ticked again. The lock must be held.
+ * @param ws Strip
+ * @param now_us Time of the tick in microseconds
+ * @return Time of the next frame in microseconds, 0 if nothing is left to do
+ */
+static uint64_t strip_next(ws2812b_t *ws, uint64_t now_us) {
+    uint64_t next = UINT64_MAX;
+    if(ws->request_render) next = ws->last_render_us + WS2812B_FRAME_US; // Framerate cap
+    for(uint16_t i = 0; i < ws->fxs_size; i++) {
+        if(ws->fxs[i]->running && ws->fxs[i]->due_us < next) next = ws->fxs[i]->due_us;
+    }
+    if(ws->FX_text.running && ws->FX_text.due_us < next) next = ws->FX_text.due_us;
+    if(next == UINT64_MAX) return 0;
+
+    // Align to the frame grid, so that effects due in the same frame share one render
+    next = ((next + WS2812B_FRAME_US - 1) / WS2812B_FRAME_US) * WS2812B_FRAME_US;
+    return (next > now_us) ? next : now_us + WS2812B_FRAME_US;
+}
+
+/**
+ * @brief Run the callbacks of the effects that ended, without the lock.
+ * Each one is taken under the lock, so the pool can grow meanwhile.
+ * @param ws Strip
+ */
+static void run_callbacks(ws2812b_t *ws) {
+    while(true) {
+        strip_lock(ws);
+        FX_t *FX = NULL;
+        for(uint16_t i = 0; i < ws->fxs_size && !FX; i++) {
+            if(ws->fxs[i]->pending_callback) FX = ws->fxs[i];
+        }
+        if(!FX && ws->FX_text.pending_callback) FX = &ws->FX_text;
+        void (*callback)(void *user_data) = NULL;
+        if(FX) {
+            callback = FX->pending_callback;
+            FX->pending_callback = NULL;
+        }
+        strip_unlock(ws);
+        if(!callback) return;
+        callback(FX);
     }
+}
+
+/**
+ * @brief Run a tick of a strip. Takes the lock and returns with it held.
+ * Effects are advanced and the frame is composited with the lock, the frame is then
+ * transmitted and the callbacks of ended effects run without it: interrupts stay
+ * enabled while the PIO drains, and callbacks may block or print. In the meantime
+ * scheduler_wake leaves the next wake-up to the end of the tick.
+ * The strip is selected on this core during the tick, so the callbacks of its effects
+ * draw on it.
+ * @param ws Strip
+ * @param now_us Current time in microseconds
+ * @return Time of the next frame in microseconds, 0 if nothing is left to do
+ */
+static uint64_t run_tick(ws2812b_t *ws, uint64_t now_us) {
+    strip_lock(ws);
+    if(ws->in_tick) return now_us + WS2812B_FRAME_US; // Being ticked by the other core
+
+    ws->in_tick = true;
+    uint core = get_core_num();
+    ws2812b_t *previous = selected_strip[core];
+    selected_strip[core] = ws;
+    uint32_t count = strip_advance(ws, now_us);
+    strip_unlock(ws);
+
+    transmit(ws, count);
+    run_callbacks(ws);
+
+    strip_lock(ws);
+    selected_strip[core] = previous;
+    uint64_t next = strip_next(ws, now_us);
+    ws->in_tick = false;
+    return next;
+}
 
-    // Initialize masks
-    config.global_mask = malloc(_num_pixels * sizeof(uint8_t));
-    no_mask = malloc(_num_pixels * sizeof(uint8_t));
-    memset(no_mask, 1, _num_pixels);
-    ws2812b_clear_mask();
+/**
+ * @brief Advance all running effects of the selected strip, then render once.
+ * Only needed with ws2812b_set_manual_tick, the alarm calls it otherwise.
+ * @param now_us Current time in microseconds
+ * @return Time of the next frame in microseconds, 0 if nothing is left to do
+ */
+uint64_t ws2812b_tick(uint64_t now_us) {
+    ws2812b_t *ws = selected_strip[get_core_num()];
+    uint64_t next = run_tick(ws, now_us);
+    strip_unlock(ws);
+    return next;
+}
+
+/**
+ * @brief Alarm callback driving the scheduler.
+ * @param id Alarm ID
+ * @param user_data Strip
+ * @return Negated time from the previous wake-up to the next frame in microseconds,
+ * 0 to sleep until woken up
+ */
+static int64_t scheduler_callback(alarm_id_t id, void *user_data) {
+    ws2812b_t *ws = user_data;
+    uint64_t next = run_tick(ws, time_us_64());
+    if(!next || ws->manual_tick) {
+        ws->scheduler_alarm = 0;
+        strip_unlock(ws);
+        return 0;
+    }
+    // A negative delay is relative to the previous wake-up instead of the return of this
+    // callback, so the frame grid does not drift by the time the tick takes
+    int64_t delay_us = (int64_t)(next - ws->scheduler_wake_us);
+    ws->scheduler_wake_us = next;
+    strip_unlock(ws);
+    return -delay_us;
+}
+
+/**
+ * @brief Make sure the scheduler runs no later than a given time. The lock must be held.
+ * @param ws Strip
+ * @param at Time in microseconds
+ */
+static void scheduler_wake(ws2812b_t *ws, uint64_t at) {
+    if(ws->in_tick || ws->manual_tick) return;
+    if(ws->scheduler_alarm) {
+        if(ws->scheduler_wake_us <= at) return;
+        cancel_alarm(ws->scheduler_alarm);
+    }
+    uint64_t now = time_us_64();
+    if(at < now) at = now;
+    ws->scheduler_wake_us = at;
+    ws->scheduler_alarm = add_alarm_in_us(at - now, scheduler_callback, ws, true);
+}
+
+/**
+ * @brief Start running an effect on the scheduler.
+ * @param FX Effect descriptor
+ * @param step Step function, returns the time until the next step in microseconds or 0 when done
+ * @param delay_ms Time until the first step in milliseconds
+ */
+static void fx_schedule(FX_t *FX, int64_t (*step)(FX_t *FX), uint32_t delay_ms) {
+    FX->step = step;
+    FX->due_us = time_us_64() + delay_ms * 1000ull;
+    FX->running = true;
+    FX->strip->draw_order_dirty = true;
+    scheduler_wake(FX->strip, FX->due_us);
+}
+
+static uint16_t* build_xy_lut(uint16_t num_pixels, const struct ws2812b_geometry *geometry,
+                              uint16_t *width, uint16_t *height);
+static void strip_clear_mask(ws2812b_t *ws);
+
+/**
+ * @brief Initialize a strip and its state machine.
+ * @param ws Strip, zeroed.
+ * @param pio PIO instance.
+ * @param gpio GPIO pin.
+ * @param num_pixels Number of pixels in the LED strip.
+ * @return True on success, false if out of memory.
+ */
+static bool strip_init(ws2812b_t *ws, PIO _pio, uint8_t gpio, uint16_t _num_pixels) {
+    ws->config.animation_step_ms = 20; // 20ms = 50fps animations
+    ws->config.num_pixels = _num_pixels;
+
+    // Allocate memory to store pixel data and masks
+    ws->ws2812b_buffer = malloc(_num_pixels * sizeof(uGRB32_t));
+    ws->ws2812b_frame = malloc(_num_pixels * sizeof(uGRB32_t));
+    ws->ws2812b_shown = malloc(_num_pixels * sizeof(uGRB32_t));
+    ws->draw_order = malloc(sizeof(FX_t*));
+    ws->no_mask = malloc(_num_pixels * sizeof(uint8_t));
+    ws->config.xy_lut = build_xy_lut(_num_pixels, &(struct ws2812b_geometry){
+        .width = 8, .height = (_num_pixels + 7) / 8, .wiring = WS2812B_WIRING_PROGRESSIVE
+    }, &ws->config.width, &ws->config.height);
+    if(!ws->ws2812b_buffer || !ws->ws2812b_frame || !ws->ws2812b_shown ||
+       !ws->draw_order || !ws->no_mask || !ws->config.xy_lut) {
+        free(ws->ws2812b_buffer);
+        free(ws->ws2812b_frame);
+        free(ws->ws2812b_shown);
+        free(ws->draw_order);
+        free(ws->no_mask);
+        free(ws->config.xy_lut);
+        return false;
+    }
+    for (uint32_t i = 0; i < _num_pixels; i++) {
+        ws->ws2812b_buffer[i] = 0;
+        ws->ws2812b_shown[i] = UINT32_MAX; // Not a valid output, forces the first transmission
+    }
+    mark_dirty(ws, 0, _num_pixels - 1);
+    memset(ws->no_mask, 1, _num_pixels);
+    strip_clear_mask(ws);
+
+    critical_section_init(&ws->lock);
+
+    // Text and spritesheets share a single 8x8 layer
+    ws->FX_text.strip = ws;
+    ws->FX_text.blend = FX_BLEND_REPLACE;
+    ws->FX_text.alpha = 255;
+    fx_spare_t spare;
+    strip_reserve(ws, &(fx_needs_t){ .width = 8, .height = 8 }, &spare);
+    fx_attach_block(&ws->FX_text, 8, 8, &spare);
+    strip_unlock(ws);
+    fx_spare_free(&spare);
+
+    ws->config.pio = _pio;
+    ws->config.pio_sm = pio_claim_unused_sm(_pio, true);
+    uint offset = pio_add_program(_pio, &ws2812_program);
+    ws2812_program_init(_pio, ws->config.pio_sm, offset, gpio, WS2812B_FREQ_HZ, WS2812B_IS_RGBW);
+    return true;
+}
+
+/**
+ * @brief Initialize the state machine.
+ * @param pio PIO instance.
+ * @param gpio GPIO pin.
+ * @param num_pixels Number of pixels in the LED strip.
+ */
+void ws2812b_init(PIO _pio, uint8_t gpio, uint16_t _num_pixels) {
+    strip_init(&default_strip, _pio, gpio, _num_pixels);
+}
+
+/**
+ * @brief Create an additional strip, with its own buffers, effects and scheduler
+ * Functions act on the strip selected by the calling core, see ws2812b_select.
+ * @param pio PIO instance.
+ * @param gpio GPIO pin.
+ * @param num_pixels Number of pixels in the LED strip.
+ * @return Strip, NULL if out of memory.
+ */
+ws2812b_t* ws2812b_create(PIO _pio, uint8_t gpio, uint16_t _num_pixels) {
+    ws2812b_t *ws = calloc(1, sizeof(ws2812b_t));
+    if(!ws) return NULL;
+    if(!strip_init(ws, _pio, gpio, _num_pixels)) {
+        free(ws);
+        return NULL;
+    }
+    return ws;
+}
+
+/**
+ * @brief Select the strip used by the functions called from this core
+ * Each core has its own selection, so two cores can draw on two strips without
+ * passing handles around. Effect callbacks run with the strip of the effect selected.
+ * @param strip Strip returned by ws2812b_create, NULL for the one set up by ws2812b_init.
+ * @return Previously selected strip.
+ */
+ws2812b_t* ws2812b_select(ws2812b_t *strip) {
+    uint core = get_core_num();
+    ws2812b_t *previous = selected_strip[core];
+    selected_strip[core] = (strip ? strip : &default_strip);
+    return previous;
+}
+
+/**
+ * @brief Drive the selected strip from ws2812b_tick instead of the alarm
+ * E.g. from a loop on the second core, which keeps rendering out of the interrupts of the first one.
+ * @param manual True to call ws2812b_tick from the application, false to go back to the alarm.
+ */
+void ws2812b_set_manual_tick(bool manual) {
+    ws2812b_t *ws = strip_enter();
+    ws->manual_tick = manual;
+    if(manual && ws->scheduler_alarm) {
+        cancel_alarm(ws->scheduler_alarm);
+        ws->scheduler_alarm = 0;
+    }
+    if(!manual) scheduler_wake(ws, time_us_64()); // Pick up whatever is running
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Request a render of a strip. The lock must be held.
+ * @param ws Strip
+ */
+static void strip_render(ws2812b_t *ws) {
+    ws->request_render = true;
+    scheduler_wake(ws, ws->last_render_us + WS2812B_FRAME_US);
+}
+
+/**
+ * @brief Request a render of the current buffer state
+ * There is no periodic timer: the scheduler alarm is woken up on request,
+ * no earlier than WS2812B_FRAME_US after the previous transmission.
+ */
+void ws2812b_render() {
+    ws2812b_t *ws = strip_enter();
+    strip_render(ws);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Clear the WS2812B buffer and request a render
+ */
+void ws2812b_clear() {
+    ws2812b_t *ws = strip_enter();
+    fill_words(ws->ws2812b_buffer, 0, ws->config.num_pixels);
+    mark_dirty(ws, 0, ws->config.num_pixels - 1);
+    strip_render(ws);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set a single pixel in the buffer of a strip. The lock must be held.
+ * @param ws Strip
+ * @param pixel Pixel index
+ * @param grb 24-bit GRB color value
+ */
+static void strip_put(ws2812b_t *ws, uint16_t pixel, uGRB32_t grb) {
+    ws->ws2812b_buffer[pixel] = grb;
+    mark_dirty(ws, pixel, pixel);
+}
+
+/**
+ * @brief Set a single pixel in the WS2812B buffer
+ * @param pixel Pixel index
+ * @param grb 24-bit GRB color value
+ */
+void ws2812b_put(uint16_t pixel, uGRB32_t grb) {
+    ws2812b_t *ws = strip_enter();
+    strip_put(ws, pixel, grb);
+    strip_unlock(ws);
+}
+
+/* Geometry functions */
+
+/**
+ * @brief Get the strip index of a pixel on a panel, following its wiring
+ * @param geometry Matrix geometry
+ * @param x Column on the panel, as wired
+ * @param y Row on the panel, as wired
+ * @return Index of the pixel from the start of the panel
+ */
+static uint32_t panel_index(const struct ws2812b_geometry *geometry, uint16_t x, uint16_t y) {
+    if(geometry->wiring == WS2812B_WIRING_SERPENTINE && (y & 1)) {
+        x = geometry->width - 1 - x;
+    }
+    return y * geometry->width + x;
+}
+
+/**
+ * @brief Build the XY lookup table of a geometry.
+ * @param num_pixels Number of pixels in the strip, coordinates past it map to no pixel
+ * @param geometry Matrix geometry
+ * @param width Width of the display
+ * @param height Height of the display
+ * @return Lookup table, NULL if out of memory
+ */
+static uint16_t* build_xy_lut(uint16_t num_pixels, const struct ws2812b_geometry *geometry,
+                              uint16_t *width, uint16_t *height) {
+    struct ws2812b_geometry g = *geometry;
+    if(!g.tiles_x) g.tiles_x = 1;
+    if(!g.tiles_y) g.tiles_y = 1;
+    bool turned = g.rotation & 1;
+    uint16_t panel_w = (turned ? g.height : g.width); // Panel size, as displayed
+    uint16_t panel_h = (turned ? g.width : g.height);
+    *width = panel_w * g.tiles_x;
+    *height = panel_h * g.tiles_y;
+
+    uint16_t *lut = malloc(*width * *height * sizeof(uint16_t));
+    if(!lut) return NULL;
+    for(uint16_t y = 0; y < *height; y++) {
+        for(uint16_t x = 0; x < *width; x++) {
+            uint16_t tile = (y / panel_h) * g.tiles_x + (x / panel_w);
+            uint16_t tx = x % panel_w;
+            uint16_t ty = y % panel_h;
+            uint16_t px, py; // Coordinates on the panel, as wired
+            switch(g.rotation & 3) {
+                case 1:  px = g.width - 1 - ty; py = tx; break;
+                case 2:  px = g.width - 1 - tx; py = g.height - 1 - ty; break;
+                case 3:  px = ty; py = g.height - 1 - tx; break;
+                default: px = tx; py = ty; break;
+            }
+            uint32_t pixel = (uint32_t)tile * g.width * g.height + panel_index(&g, px, py);
+            lut[y * *width + x] = (pixel < num_pixels ? pixel : WS2812B_NO_PIXEL);
+        }
+    }
+    return lut;
+}
+
+/**
+ * @brief Set the layout of the pixels
+ * The XY lookup table is built here once, so every 2D drawing call costs a
+ * single table read per pixel. It is built without the lock, which is only
+ * held to swap it in.
+ * @param geometry Matrix geometry
+ * @return true on success, false if out of memory
+ */
+bool ws2812b_set_geometry(const struct ws2812b_geometry *geometry) {
+    ws2812b_t *ws = selected_strip[get_core_num()];
+    uint16_t width, height;
+    uint16_t *lut = build_xy_lut(ws->config.num_pixels, geometry, &width, &height); // Fixed at initialization
+    if(!lut) return false;
+
+    strip_lock(ws);
+    uint16_t *old = ws->config.xy_lut;
+    ws->config.xy_lut = lut;
+    ws->config.width = width;
+    ws->config.height = height;
+    strip_unlock(ws);
+    free(old);
+    return true;
+}
+
+/**
+ * @brief Get the width of the display
+ * @return Width in pixels
+ */
+uint16_t ws2812b_width() {
+    return selected_strip[get_core_num()]->config.width;
+}
+
+/**
+ * @brief Get the height of the display
+ * @return Height in pixels
+ */
+uint16_t ws2812b_height() {
+    return selected_strip[get_core_num()]->config.height;
+}
+
+/**
+ * @brief Get the strip index of a pixel
+ * @param x Column, from the left
+ * @param y Row, from the top
+ * @return Pixel index, WS2812B_NO_PIXEL if outside of the display
+ */
+uint16_t ws2812b_xy(uint16_t x, uint16_t y) {
+    ws2812b_t *ws = strip_enter();
+    uint16_t pixel = lookup_xy(ws, x, y);
+    strip_unlock(ws);
+    return pixel;
+}
+
+/**
+ * @brief Set the color of a pixel of a strip by its coordinates. The lock must be held.
+ * @param ws Strip
+ * @param x Column, from the left
+ * @param y Row, from the top
+ * @param grb 24-bit GRB color value
+ */
+static void strip_put_xy(ws2812b_t *ws, uint16_t x, uint16_t y, uGRB32_t grb) {
+    uint16_t pixel = lookup_xy(ws, x, y);
+    if(pixel != WS2812B_NO_PIXEL) strip_put(ws, pixel, grb);
+}
+
+/**
+ * @brief Set the color of a pixel by its coordinates
+ * @param x Column, from the left
+ * @param y Row, from the top
+ * @param grb 24-bit GRB color value
+ */
+void ws2812b_put_xy(uint16_t x, uint16_t y, uGRB32_t grb) {
+    ws2812b_t *ws = strip_enter();
+    strip_put_xy(ws, x, y, grb);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Fill a range of pixels in the buffer of a strip. The lock must be held.
+ * @param ws Strip
+ * @param from Start pixel index
+ * @param to End pixel index
+ * @param grb 24-bit GRB color value
+ */
+static void strip_fill(ws2812b_t *ws, uint32_t from, uint32_t to, uGRB32_t grb) {
+    if(from > to) {
+        uint32_t temp = from;
+        from = to;
+        to = temp;
+    }
+    if(from >= ws->config.num_pixels) return;
+    if(to >= ws->config.num_pixels) to = ws->config.num_pixels - 1;
+    fill_words(&ws->ws2812b_buffer[from], grb, to - from + 1);
+    mark_dirty(ws, from, to);
+}
+
+/**
+ * @brief Fill a range of pixels in the WS2812B buffer
+ * @param from Start pixel index
+ * @param to End pixel index
+ * @param grb 24-bit GRB color value
+ */
+void ws2812b_fill(uint32_t from, uint32_t to, uGRB32_t grb) {
+    ws2812b_t *ws = strip_enter();
+    strip_fill(ws, from, to, grb);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Fill the entire WS2812B buffer with a single color
+ * @param grb 24-bit GRB color value
+ */
+void ws2812b_fill_all(uGRB32_t grb) {
+    ws2812b_t *ws = strip_enter();
+    strip_fill(ws, 0, ws->config.num_pixels - 1, grb);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Fill a rectangle of the display
+ * The rectangle is clipped to the display.
+ * @param x Left column
+ * @param y Top row
+ * @param w Width
+ * @param h Height
+ * @param grb 24-bit GRB color value
+ */
+void ws2812b_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uGRB32_t grb) {
+    ws2812b_t *ws = strip_enter();
+    uint16_t x_end = (x + w < ws->config.width) ? x + w : ws->config.width;
+    uint16_t y_end = (y + h < ws->config.height) ? y + h : ws->config.height;
+    uint32_t from = UINT32_MAX;
+    uint32_t to = 0;
+    for(uint16_t row = y; row < y_end; row++) {
+        const uint16_t *lut = &ws->config.xy_lut[row * ws->config.width];
+        for(uint16_t col = x; col < x_end; col++) {
+            uint16_t pixel = lut[col];
+            if(pixel == WS2812B_NO_PIXEL) continue;
+            ws->ws2812b_buffer[pixel] = grb;
+            if(pixel < from) from = pixel;
+            if(pixel > to) to = pixel;
+        }
+    }
+    if(from <= to) mark_dirty(ws, from, to);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set a list of pixels to the same color
+ * @param pixels Array of pixel indices, indices outside of the strip are skipped
+ * @param count Number of pixels
+ * @param grb 24-bit GRB color value
+ */
+void ws2812b_put_indexed(const uint16_t *pixels, uint16_t count, uGRB32_t grb) {
+    ws2812b_t *ws = strip_enter();
+    uint32_t from = UINT32_MAX;
+    uint32_t to = 0;
+    for(uint16_t i = 0; i < count; i++) {
+        uint16_t pixel = pixels[i];
+        if(pixel >= ws->config.num_pixels) continue;
+        ws->ws2812b_buffer[pixel] = grb;
+        if(pixel < from) from = pixel;
+        if(pixel > to) to = pixel;
+    }
+    if(from <= to) mark_dirty(ws, from, to);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set a list of pixels by their coordinates, each with its own color
+ * @param points Array of points, points outside of the display are skipped
+ * @param count Number of points
+ */
+void ws2812b_put_points(const ws2812b_point_t *points, uint16_t count) {
+    ws2812b_t *ws = strip_enter();
+    uint32_t from = UINT32_MAX;
+    uint32_t to = 0;
+    for(uint16_t i = 0; i < count; i++) {
+        uint16_t pixel = lookup_xy(ws, points[i].x, points[i].y);
+        if(pixel == WS2812B_NO_PIXEL) continue;
+        ws->ws2812b_buffer[pixel] = points[i].grb;
+        if(pixel < from) from = pixel;
+        if(pixel > to) to = pixel;
+    }
+    if(from <= to) mark_dirty(ws, from, to);
+    strip_unlock(ws);
+}
+
+/* Setters */
+
+/**
+ * @brief Convert a frame rate to a step time
+ * @param fps Frames per second, 0 is taken as 1
+ * @return Step time in milliseconds, at least 1 so that steps can be timed
+ */
+static uint32_t fps_to_step_ms(uint16_t fps) {
+    uint32_t step_ms = 1000 / (fps ? fps : 1);
+    return (step_ms ? step_ms : 1); // Above 1000 fps, the fastest step
+}
+
+/**
+ * @brief Set the animation frame rate
+ * @param fps Frames per second, see fps_to_step_ms
+ */
+void ws2812b_config_set_fps(uint16_t fps) {
+    ws2812b_t *ws = strip_enter();
+    ws->config.animation_step_ms = fps_to_step_ms(fps);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set the frame rate for a specific effect
+ * @param FX Effect descriptor
+ * @param fps Frames per second, see fps_to_step_ms
+ */
+void ws2812b_set_fps(FX_t *FX, uint16_t fps) {
+    ws2812b_t *ws = strip_lock(FX->strip);
+    FX->step_ms = fps_to_step_ms(fps);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set the color inversion mode
+ * @param inverted True to invert colors, false otherwise
+ */
+void ws2812b_set_inverted(bool inverted) {
+    ws2812b_t *ws = strip_enter();
+    ws->config.inverted = inverted;
+    mark_dirty(ws, 0, ws->config.num_pixels - 1);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set the background color for an effect
+ * @param FX Effect descriptor
+ * @param grb 24-bit GRB color value
+ */
+void ws2812b_set_background(FX_t *FX, uGRB32_t grb) {
+    ws2812b_t *ws = strip_lock(FX->strip);
+    FX->colors[1] = grb;
+    if(FX->layer_len) mark_dirty(ws, FX->layer_from, FX->layer_from + FX->layer_len - 1);
+    strip_render(ws);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set the callback function for an effect
+ * @param FX Effect descriptor
+ * @param callback Function to call at the end of the effect
+ */
+void ws2812b_set_callback(FX_t *FX, void (*callback)(void *user_data)) {
+    ws2812b_t *ws = strip_lock(FX->strip);
+    FX->callback = callback;
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set the compositing order of an effect
+ * @param FX Effect descriptor
+ * @param z Layers with a higher z are drawn on top
+ */
+void ws2812b_set_z(FX_t *FX, uint8_t z) {
+    ws2812b_t *ws = strip_lock(FX->strip);
+    FX->z = z;
+    ws->draw_order_dirty = true;
+    if(FX->layer_len) mark_dirty(ws, FX->layer_from, FX->layer_from + FX->layer_len - 1);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set how an effect is blended with the layers below it
+ * @param FX Effect descriptor
+ * @param blend Blend mode
+ * @param alpha Opacity for FX_BLEND_ALPHA (0-255)
+ */
+void ws2812b_set_blend(FX_t *FX, FX_blend_t blend, uint8_t alpha) {
+    ws2812b_t *ws = strip_lock(FX->strip);
+    FX->blend = blend;
+    FX->alpha = alpha;
+    if(FX->layer_len) mark_dirty(ws, FX->layer_from, FX->layer_from + FX->layer_len - 1);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set the easing curve of an animation effect
+ * @param FX Effect descriptor
+ * @param ease Easing curve, applied to the time within each loop
+ */
+void ws2812b_set_easing(FX_t *FX, FX_ease_t ease) {
+    ws2812b_t *ws = strip_lock(FX->strip);
+    FX->ease = ease;
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Replace the gradient palette of a palette-based effect
+ * @param FX Effect descriptor
+ * @param palette 256-entry palette, copied
+ * @return True on success, false if out of memory
+ */
+bool ws2812b_set_palette(FX_t *FX, const uGRB32_t palette[256]) {
+    // Allocated without the lock, in case the effect has no palette yet
+    uGRB32_t *copy = FX->palette ? NULL : malloc(256 * sizeof(uGRB32_t));
+
+    // The effect may be drawing from the scheduler
+    ws2812b_t *ws = strip_lock(FX->strip);
+    if(!FX->palette) {
+        FX->palette = copy;
+        copy = NULL;
+    }
+    if(FX->palette) memcpy(FX->palette, palette, 256 * sizeof(uGRB32_t));
+    bool ok = FX->palette != NULL;
+    strip_unlock(ws);
+    free(copy); // Not needed, the other core allocated one first
+    return ok;
+}
+
+/**
+ * @brief Set the global dimming level
+ * @param dim Dimming level (0-7)
+ */
+void ws2812b_set_global_dimming(uint8_t dim) {
+    if(dim > 7) dim = 7;
+    ws2812b_t *ws = strip_enter();
+    ws->config.global_dimming = dim;
+    mark_dirty(ws, 0, ws->config.num_pixels - 1);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Set a custom mask for the WS2812B buffer
+ * @param mask Array of mask values
+ */
+void ws2812b_set_mask(const uint8_t *mask) {
+    ws2812b_t *ws = strip_enter();
+    ws->config.global_mask = (uint8_t*)mask;
+    mark_dirty(ws, 0, ws->config.num_pixels - 1);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Clear the mask of a strip and use the default one. The lock must be held.
+ * @param ws Strip
+ */
+static void strip_clear_mask(ws2812b_t *ws) {
+    ws->config.global_mask = ws->no_mask;
+    mark_dirty(ws, 0, ws->config.num_pixels - 1);
+}
+
+/**
+ * @brief Clear the mask and use the default one
+ */
+void ws2812b_clear_mask() {
+    ws2812b_t *ws = strip_enter();
+    strip_clear_mask(ws);
+    strip_unlock(ws);
+}
+
+/* Text functions */
+
+/**
+ * @brief Get the CP0_EU glyph index for a given Unicode code point
+ * @param codepoint Unicode code point
+ * @return Glyph index
+ */
+static uint16_t get_CP0_EU_index(uint32_t codepoint) {
+    uint16_t index = CP0_EU_MISSING;
+    uint32_t page = codepoint >> CP0_EU_BLOCK_BITS;
+    if(page < CP0_EU_PAGES && CP0_EU_PAGE_TABLE[page] != CP0_EU_EMPTY_PAGE) {
+        index = CP0_EU_BLOCKS[CP0_EU_PAGE_TABLE[page]][codepoint & ((1 << CP0_EU_BLOCK_BITS) - 1)];
+    }
+    if(index == CP0_EU_MISSING) index = 215; // CHARMAP_CP0_EU[215] is a bullet glyph.
+                                             // Use 0 for a blank one.
+    return index;
+}
+
+/**
+ * @brief Get the CP0_EU bitmap for a given Unicode code point
+ * @param codepoint Unicode code point
+ * @return Pointer to the bitmap data
+ */
+static char* get_CP0_EU(uint32_t codepoint) {
+    return (char *)CP0_EU_8x8[get_CP0_EU_index(codepoint)];
+}
+
+/**
+ * @brief Rasterize a string into columns, using the proportional width of each glyph
+ * @param str UTF-8 string
+ * @param columns Destination, one byte per column, or NULL to only count the columns
+ * @return Number of columns
+ */
+static uint32_t rasterize_text(const char *str, uint8_t *columns) {
+    utf8_iter iter;
+    uint32_t len = 0;
+    utf8_init(&iter, str);
+    while(utf8_next(&iter)) {
+        uint16_t index = get_CP0_EU_index(iter.codepoint);
+        uint8_t first = CP0_EU_8x8_offsets[index * 2];     // Leftmost column of the glyph
+        uint8_t last = CP0_EU_8x8_offsets[index * 2 + 1];  // Rightmost column of the glyph
+        for(uint8_t x = first; x <= last + 1; x++, len++) { // One more column to space glyphs
+            if(!columns) continue;
+            uint8_t column = 0;
+            for(uint8_t y = 0; y < 8 && x <= last; y++) {
+                if(CP0_EU_8x8[index][y] & (0x80 >> x)) column |= 1 << y;
+            }
+            columns[len] = column;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Type a character on the WS2812B strip
+ * @param FX Effect descriptor
+ * @return Time until the next call in microseconds, 0 when done
+ */
+static int64_t type_character(FX_t *FX) {
+    ws2812b_t *ws = FX->strip;
+    if(ws->is_gap && !FX->ending) {
+        fx_fill_block(FX, FX->colors[1]);
+        strip_render(ws);
+        ws->is_gap = false;
+        return FX->gap_ms*1000;
+    }
+    if(utf8_next(&ws->ITER)) {
+        ws->Character = utf8_getchar(&ws->ITER);
+        // Lookahead
+        if(!utf8_next(&ws->ITER)) { FX->ending = true; }
+        utf8_previous(&ws->ITER); // Revert the lookahead step
+
+        const char *bitmap = get_CP0_EU(ws->ITER.codepoint);
+        uint8_t set;
+        for (uint8_t x=0; x<8; x++) {
+            for (uint8_t y=0; y<8; y++) {
+                set = bitmap[x] & 1 << y;
+                fx_put_xy(FX, 7 - y, x, (set ? FX->colors[0] : FX->colors[1]));
+            }
+        }
+        strip_render(ws);
+    } else { // str == 0x00, end of string
+        ws->is_gap = false;
+        FX->ending = false;
+        if(FX->clear_on_end) {
+            fx_fill_block(FX, FX->colors[1]);
+        }
+        fx_detach(FX, true);
+        strip_render(ws);
+        FX->pending_callback = FX->callback;
+        return 0;
+    }
+    ws->is_gap = true; // Set flag for the next call
+    
+    return FX->step_ms*1000;
+}
+
+/**
+ * @brief Scroll a string of text on the WS2812B strip
+ * @param FX Effect descriptor
+ * @return Time until the next call in microseconds, 0 when done
+ */
+static int64_t scroll_text(FX_t *FX) {
+    ws2812b_t *ws = FX->strip;
+    // The text enters from the right edge and leaves from the left one
+    uint16_t width = ws->config.width;
+    if(FX->cursor >= ws->text_columns_len + width) {
+        fx_detach(FX, true);
+        strip_render(ws);
+        FX->pending_callback = FX->callback;
+        return 0;
+    }
+
+    // Blit the window of columns currently on display
+    for(uint16_t x = 0; x < width; x++) {
+        int32_t src = (int32_t)FX->cursor + x - width;
+        uint8_t column = ((src >= 0 && src < (int32_t)ws->text_columns_len) ? ws->text_columns[src] : 0);
+        for(uint8_t y = 0; y < 8; y++) {
+            fx_put_xy(FX, x, y, ((column >> y) & 1) ? FX->colors[0] : FX->colors[1]);
+        }
+    }
+    strip_render(ws);
+
+    FX->cursor++;
+    return FX->step_ms*1000;
+}
+
+/**
+ * @brief Start a text typing effect on the WS2812B strip
+ * @param str String to type
+ * @param grb 24-bit GRB color value for the text
+ * @param delay Delay between characters in milliseconds
+ * @return Pointer to the effect descriptor
+ */
+FX_t* ws2812b_text_type(char *str, uGRB32_t grb, uint16_t delay) {
+    fx_spare_t spare;
+    ws2812b_t *ws = strip_enter_reserved(&(fx_needs_t){ .width = 8, .height = 8 }, &spare);
+    ws->FX_text.callback = noop;
+    ws->FX_text.str = str;
+    ws->FX_text.colors[0] = grb;
+    ws->FX_text.colors[1] = 0x0;
+    ws->FX_text.step_ms = delay;
+    ws->FX_text.ending = false;
+    ws->FX_text.gap_ms = 50;
+    ws->FX_text.clear_on_end = true;
+    utf8_init(&ws->ITER, str);
+    fx_attach_block(&ws->FX_text, 8, 8, &spare);
+    fx_schedule(&ws->FX_text, type_character, delay);
+    strip_unlock(ws);
+    fx_spare_free(&spare);
+    return &ws->FX_text;
+}
+
+/**
+ * @brief Start a scrolling text effect on the WS2812B strip
+ * @param str String to scroll
+ * @param grb 24-bit GRB color value for the text
+ * @param delay Delay between frames in milliseconds
+ * @return Pointer to the effect descriptor
+ */
+FX_t* ws2812b_text_scroll(char *str, uGRB32_t grb, uint16_t delay) {
+    // Rasterize the whole string once, each step is then a plain blit
+    uint32_t len = rasterize_text(str, NULL);
+    uint8_t *columns = malloc(len ? len : 1);
+    if(!columns) return NULL;
+    rasterize_text(str, columns);
+
+    fx_spare_t spare;
+    ws2812b_t *ws = strip_enter_reserved(&(fx_needs_t){ .width = UINT16_MAX, .height = 8 }, &spare);
+    ws->FX_text.running = false; // Stop a previous text effect before swapping its columns
+    uint8_t *old_columns = ws->text_columns;
+    ws->text_columns = columns;
+    ws->text_columns_len = len;
+
+    ws->FX_text.callback = noop;
+    ws->FX_text.str = str;
+    ws->FX_text.cursor = 0;
+    ws->FX_text.colors[0] = grb;
+    ws->FX_text.colors[1] = 0x0;
+    ws->FX_text.step_ms = delay;
+    ws->FX_text.ending = false;
+    ws->FX_text.clear_on_end = true; // Not in use for this type of effect
+    fx_attach_block(&ws->FX_text, UINT16_MAX, 8, &spare); // Full width
+    fx_schedule(&ws->FX_text, scroll_text, delay);
+    strip_unlock(ws);
+    free(old_columns);
+    fx_spare_free(&spare);
+    return &ws->FX_text;
+}
+
+/* Sprite functions */
+
+/**
+ * @brief Copy a sprite into the buffer of a strip. The lock must be held.
+ * The sprite is clipped to the display, one table read per visible pixel.
+ * @param ws Strip
+ * @param sprite Pointer to the sprite data, w * h pixels row by row
+ * @param x Column of the left edge of the sprite, may be negative
+ * @param y Row of the top edge of the sprite, may be negative
+ * @param w Width of the sprite
+ * @param h Height of the sprite
+ * @param tinted True to draw the non-black pixels of the sprite in grb
+ * @param grb 24-bit GRB color value for the tint
+ * @param mode Blit mode
+ */
+static void strip_blit(ws2812b_t *ws, const uGRB32_t *sprite, int16_t x, int16_t y, uint16_t w, uint16_t h,
+                       bool tinted, uGRB32_t grb, ws2812b_blit_t mode) {
+    int32_t col_from = (x < 0) ? -x : 0;
+    int32_t row_from = (y < 0) ? -y : 0;
+    int32_t col_to = ((int32_t)ws->config.width - x < w) ? (int32_t)ws->config.width - x : w;
+    int32_t row_to = ((int32_t)ws->config.height - y < h) ? (int32_t)ws->config.height - y : h;
+    uint32_t from = UINT32_MAX;
+    uint32_t to = 0;
+    for(int32_t row = row_from; row < row_to; row++) {
+        int32_t base = (y + row) * (int32_t)ws->config.width + x;
+        const uGRB32_t *src = &sprite[row * w];
+        for(int32_t col = col_from; col < col_to; col++) {
+            uGRB32_t p = src[col];
+            if(!p && mode == WS2812B_BLIT_MASKED) continue;
+            uint16_t pixel = ws->config.xy_lut[base + col];
+            if(pixel == WS2812B_NO_PIXEL) continue;
+            ws->ws2812b_buffer[pixel] = ((tinted && p) ? grb : p);
+            if(pixel < from) from = pixel;
+            if(pixel > to) to = pixel;
+        }
+    }
+    if(from <= to) mark_dirty(ws, from, to);
+}
+
+/**
+ * @brief Copy a sprite of any size to the display
+ * @param sprite Pointer to the sprite data, w * h pixels row by row
+ * @param x Column of the left edge of the sprite, may be negative
+ * @param y Row of the top edge of the sprite, may be negative
+ * @param w Width of the sprite
+ * @param h Height of the sprite
+ * @param mode WS2812B_BLIT_MASKED to leave the pixels under black ones untouched
+ */
+void ws2812b_blit(const uGRB32_t *sprite, int16_t x, int16_t y, uint16_t w, uint16_t h, ws2812b_blit_t mode) {
+    ws2812b_t *ws = strip_enter();
+    strip_blit(ws, sprite, x, y, w, h, false, 0, mode);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Copy a sprite of any size to the display, recoloring its non-black pixels
+ * @param sprite Pointer to the sprite data, w * h pixels row by row
+ * @param x Column of the left edge of the sprite, may be negative
+ * @param y Row of the top edge of the sprite, may be negative
+ * @param w Width of the sprite
+ * @param h Height of the sprite
+ * @param grb 24-bit GRB color value for the tint
+ * @param mode WS2812B_BLIT_MASKED to leave the pixels under black ones untouched
+ */
+void ws2812b_blit_tint(const uGRB32_t *sprite, int16_t x, int16_t y, uint16_t w, uint16_t h,
+                       uGRB32_t grb, ws2812b_blit_t mode) {
+    ws2812b_t *ws = strip_enter();
+    strip_blit(ws, sprite, x, y, w, h, true, grb, mode);
+    strip_unlock(ws);
+}
+
+/**
+ * @brief Display a sprite on the WS2812B strip
+ * @param sprite Pointer to the sprite data
+ */
+void ws2812b_sprite(const uGRB32_t *sprite) {
+    ws2812b_blit(sprite, 0, 0, 8, 8, WS2812B_BLIT_OPAQUE);
+}
+
+/**
+ * @brief Display a tinted sprite on the WS2812B strip
+ * @param sprite Pointer to the sprite data
+ * @param grb 24-bit GRB color value for the tint
+ */
+void ws2812b_sprite_tint(const uGRB32_t *sprite, uGRB32_t grb) {
+    ws2812b_blit_tint(sprite, 0, 0, 8, 8, grb, WS2812B_BLIT_OPAQUE);
+}
+
+/**
+ * @brief Copy a sprite into the layer of an effect
+ * @param FX Effect descriptor
+ * @param sprite Pointer to the sprite data
+ */
+static void fx_sprite(FX_t *FX, const uGRB32_t *sprite) {
+    for (uint8_t i=0; i<64; i++) {
+        fx_put_xy(FX, i % 8, i / 8, sprite[i]);
+    }
+}
+
+/**
+ * @brief Decode a packed frame into the layer of an effect
+ * Delta frames only write the pixels that differ from the previous frame,
+ * which must be the one in the layer.
+ * @param FX Effect descriptor
+ * @param palette Palette of up to 16 colors
+ * @param data Encoded frame, see FX_sheet_t
+ * @param pixels Number of pixels in the frame
+ * @param width Width of the frame, mapped through the geometry; 0 for frames in strip order
+ */
+static void fx_decode_frame(FX_t *FX, const uGRB32_t *palette, const uint8_t *data,
+                            uint16_t pixels, uint16_t width) {
+    uint8_t type = *data++;
+    uint32_t i = 0;
+
+    if(type == 2) { // Raw
+        for(; i < pixels; i += 2, data++) {
+            for(uint8_t n = 0; n < 2 && i + n < pixels; n++) {
+                uGRB32_t grb = palette[(n ? *data : *data >> 4) & 0x0f];
+                if(width) fx_put_xy(FX, (i + n) % width, (i + n) / width, grb);
+                else fx_put(FX, i + n, grb);
+            }
+        }
+        return;
+    }
+    while(i < pixels) {
+        if(type == 1) { // Delta, skip the unchanged pixels
+            i += *data++;
+            if(i >= pixels) break;
+        }
+        uint32_t run = (*data >> 4) + 1;
+        uGRB32_t grb = palette[*data++ & 0x0f];
+        if(run > pixels - i) run = pixels - i;
+        if(width) {
+            for(uint32_t n = i; n < i + run; n++) fx_put_xy(FX, n % width, n / width, grb);
+        } else {
+            fx_fill(FX, i, i + run - 1, grb);
+        }
+        i += run;
+    }
+}
+
+/**
+ * @brief Display a frame from a spritesheet on the WS2812B strip
+ * @param FX Effect descriptor
+ * @return Time until the next call in microseconds, 0 when done
+ */
+static int64_t spritesheet_frame(FX_t *FX) {
+    if(FX->canceled) {
+        fx_detach(FX, true);
+        strip_render(FX->strip);
+        return 0;
+    }
+    if(FX->ending) {
+        FX->ending = false;
+        fx_detach(FX, true);
+        strip_render(FX->strip);
+        FX->pending_callback = FX->callback;
+        return 0;
+    }
+    if(FX->sheet) {
+        fx_decode_frame(FX, FX->sheet->palette, FX->sheet->data + FX->sheet->offsets[FX->cursor], 64, 8);
+    } else {
+        fx_sprite(FX, FX->spritesheet[FX->cursor]);
+    }
+    strip_render(FX->strip);
+    if(++FX->cursor >= FX->frames) {
+        FX->cursor = 0;
+        if(++FX->loop_counter >= FX->loops && FX->loops > 0) {
+            FX->ending = true;
+        }
+    }
+
+    return FX->step_ms*1000;
+}
+
+/**
+ * @brief Start a spritesheet animation, from either frame format
+ * @param ws Strip
+ * @param spritesheet Pointer to the array of sprite frames, not used if sheet is set
+ * @param sheet Pointer to the packed spritesheet, or NULL
+ * @param frames Number of frames in the spritesheet
+ * @param delay Delay between frames in milliseconds
+ * @param loops Number of loops (0 for infinite)
+ * @param spare Memory reserved by strip_reserve
+ * @return Pointer to the effect descriptor
+ */
+static FX_t* start_spritesheet(ws2812b_t *ws, const uGRB32_t **spritesheet, const FX_sheet_t *sheet,
+                               uint8_t frames, uint16_t delay, uint32_t loops, fx_spare_t *spare) {
+    ws->FX_text.callback = noop;
+    ws->FX_text.spritesheet = spritesheet;
+    ws->FX_text.sheet = sheet;
+    ws->FX_text.cursor = 0;
+    ws->FX_text.frames = frames;
+    ws->FX_text.step_ms = delay;
+    ws->FX_text.loops = loops;
+    ws->FX_text.loop_counter = 0;
+    ws->FX_text.ending = false;
+    ws->FX_text.canceled = false;
+    fx_attach_block(&ws->FX_text, 8, 8, spare);
+    fx_schedule(&ws->FX_text, spritesheet_frame, delay);
+    return &ws->FX_text;
+}
+
+/**
+ * @brief Start a spritesheet animation on the WS2812B strip
+ * @param spritesheet Pointer to the array of sprite frames
+ * @param frames Number of frames in the spritesheet
+ * @param delay Delay between frames in milliseconds
+ * @param loops Number of loops (0 for infinite)
+ * @return Pointer to the effect descriptor
+ */
+FX_t* ws2812b_spritesheet(const uGRB32_t **spritesheet, uint8_t frames,
+                          uint16_t delay, uint32_t loops) {
+    fx_spare_t spare;
+    ws2812b_t *ws = strip_enter_reserved(&(fx_needs_t){ .width = 8, .height = 8 }, &spare);
+    FX_t *FX = start_spritesheet(ws, spritesheet, NULL, frames, delay, loops, &spare);
+    strip_unlock(ws);
+    fx_spare_free(&spare);
+    return FX;
+}
+
+/**
+ * @brief Start a packed spritesheet animation on the WS2812B strip
+ * @param sheet Pointer to the packed spritesheet
+ * @param delay Delay between frames in milliseconds
+ * @param loops Number of loops (0 for infinite)
+ * @return Pointer to the effect descriptor
+ */
+FX_t* ws2812b_spritesheet_packed(const FX_sheet_t *sheet, uint16_t delay, uint32_t loops) {
+    fx_spare_t spare;
+    ws2812b_t *ws = strip_enter_reserved(&(fx_needs_t){ .width = 8, .height = 8 }, &spare);
+    FX_t *FX = start_spritesheet(ws, NULL, sheet, sheet->frames, delay, loops, &spare);
+    strip_unlock(ws);
+    fx_spare_free(&spare);
+    return FX;
+}
+
+/* Streaming functions */
+
+/**
+ * @struct FX_stream_t
+ * @brief State of a streamed animation. RAM use only depends on the largest frame.
+ */
+typedef struct FX_stream_t {
+    FX_reader_t *reader;
+    uGRB32_t palette[16];
+    uint32_t frames;
+    uint16_t width;      // Frame size, mapped through the geometry
+    uint16_t height;
+    uint16_t largest;    // Size of the largest record
+    uint32_t first;      // Offset of the first record
+    uint16_t first_len;  // Size of the first frame
+    uint32_t offset;     // Offset of the record in buffer
+    uint16_t len;        // Size of the frame in buffer
+    uint8_t *buffer;     // One record: encoded frame, size of the next frame
+} FX_stream_t;
 
-    add_repeating_timer_ms(5, render, NULL, &rendering_timer); // A 5ms timer caps framerate to 200fps
+/**
+ * @brief Read from a stream and wait for the data
+ * @param reader Stream reader
+ * @param offset Offset in the stream
+ * @param dst Destination buffer
+ * @param len Number of bytes
+ * @return true if the read succeeded
+ */
+static bool stream_read_blocking(FX_reader_t *reader, uint32_t offset, void *dst, uint32_t len) {
+    if(!reader->read(reader, offset, dst, len)) return false;
+    return (!reader->wait || reader->wait(reader));
 }
 
 /**
- * @brief Request a render of the current buffer state
+ * @brief Free the state of a stream, once its reader is done with the buffer
+ * @param stream State of a streamed animation
  */
-void ws2812b_render() {
-    request_render = true;
+static void stream_free(FX_stream_t *stream) {
+    if(stream->reader->wait) stream->reader->wait(stream->reader); // Don't free a buffer being written to
+    free(stream->buffer);
+    free(stream);
 }
 
 /**
- * @brief Clear the WS2812B buffer and request a render
+ * @brief Release the state of a streamed animation
+ * @param FX Effect descriptor
  */
-void ws2812b_clear() {
-    for(uint32_t i=0; i<config.num_pixels; i++) {
-        ws2812b_buffer[i] = 0;
-    }
-    ws2812b_render();
+static void stream_close(FX_t *FX) {
+    FX_stream_t *stream = FX->stream;
+    if(!stream) return;
+    FX->stream = NULL;
+    stream_free(stream);
 }
 
 /**
- * @brief Set a single pixel in the WS2812B buffer
- * @param pixel Pixel index
- * @param grb 24-bit GRB color value
+ * @brief Read the header of a stream and start reading its first frame.
+ * Container layout, little endian: "WSA1", frames (u32), width (u16), height (u16),
+ * largest record (u16), size of the first frame (u16), colors (u8), 3 reserved bytes,
+ * palette (u32 each), then one record per frame: encoded frame, size of the next frame (u16).
+ * @param reader Stream reader
+ * @return State of the stream, NULL if the stream is not valid or out of memory
  */
-void ws2812b_put(uint16_t pixel, uGRB32_t grb) {
-    ws2812b_buffer[pixel] = grb;
+static FX_stream_t* stream_open(FX_reader_t *reader) {
+    uint8_t header[20 + 16 * 4];
+    if(!stream_read_blocking(reader, 0, header, 20)) return NULL;
+    if(memcmp(header, "WSA1", 4) != 0 || header[16] > 16) return NULL;
+    uint8_t colors = header[16];
+    if(!stream_read_blocking(reader, 20, header + 20, colors * 4)) return NULL;
+
+    FX_stream_t *stream = calloc(1, sizeof(FX_stream_t));
+    if(!stream) return NULL;
+    stream->reader = reader;
+    stream->frames = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+    stream->width = header[8] | (header[9] << 8);
+    stream->height = header[10] | (header[11] << 8);
+    stream->largest = header[12] | (header[13] << 8);
+    stream->first_len = header[14] | (header[15] << 8);
+    for(uint8_t i = 0; i < colors; i++) {
+        const uint8_t *c = header + 20 + i * 4;
+        stream->palette[i] = c[0] | (c[1] << 8) | (c[2] << 16);
+    }
+    stream->first = 20 + colors * 4;
+    stream->offset = stream->first;
+    stream->len = stream->first_len;
+    stream->buffer = malloc(stream->largest);
+    if(!stream->buffer || !stream->frames || !stream->width || !stream->height ||
+       (uint32_t)stream->width * stream->height > UINT16_MAX ||
+       stream->first_len + 2 > stream->largest ||
+       !reader->read(reader, stream->offset, stream->buffer, stream->len + 2)) {
+        stream_free(stream);
+        return NULL;
+    }
+    return stream;
 }
 
 /**
- * @brief Fill a range of pixels in the WS2812B buffer
- * @param from Start pixel index
- * @param to End pixel index
- * @param grb 24-bit GRB color value
+ * @brief Display a frame of a streamed animation and prefetch the next one
+ * @param FX Effect descriptor
+ * @return Time until the next call in microseconds, 0 when done
  */
-void ws2812b_fill(uint32_t from, uint32_t to, uGRB32_t grb) {
-    if(from > to) {
-        uint32_t temp = from;
-        from = to;
-        to = temp;
+static int64_t stream_frame(FX_t *FX) {
+    FX_stream_t *stream = FX->stream;
+    bool ok = !FX->canceled && !FX->ending;
+    if(ok && stream->reader->wait) ok = stream->reader->wait(stream->reader);
+    if(!ok) {
+        bool ended = FX->ending;
+        FX->ending = false;
+        stream_close(FX);
+        fx_detach(FX, true);
+        strip_render(FX->strip);
+        if(ended) FX->pending_callback = FX->callback;
+        return 0;
     }
-    for(uint32_t i = from; i <= to; i++) {
-        ws2812b_buffer[i] = grb;
+
+    fx_decode_frame(FX, stream->palette, stream->buffer, stream->width * stream->height, stream->width);
+    strip_render(FX->strip);
+
+    uint16_t next_len = stream->buffer[stream->len] | (stream->buffer[stream->len + 1] << 8);
+    if(++FX->cursor >= stream->frames) {
+        FX->cursor = 0;
+        stream->offset = stream->first;
+        next_len = stream->first_len;
+        if(++FX->loop_counter >= FX->loops && FX->loops > 0) {
+            FX->ending = true;
+            return FX->step_ms*1000;
+        }
+    } else {
+        stream->offset += stream->len + 2;
+    }
+    stream->len = next_len;
+    if(next_len + 2 > stream->largest ||
+       !stream->reader->read(stream->reader, stream->offset, stream->buffer, next_len + 2)) {
+        FX->canceled = true; // Corrupted stream or read error
     }
+
+    return FX->step_ms*1000;
 }
 
 /**
- * @brief Fill the entire WS2812B buffer with a single color
- * @param grb 24-bit GRB color value
+ * @brief Play an opened stream on a strip. The lock must be held.
+ * @param ws Strip
+ * @param stream State of the stream, owned by the effect on success
+ * @param delay Delay between frames in milliseconds
+ * @param loops Number of loops (0 for infinite)
+ * @param spare Memory reserved by strip_reserve
+ * @return Pointer to the effect descriptor, NULL if out of memory
  */
-void ws2812b_fill_all(uGRB32_t grb) {
-    ws2812b_fill(0, config.num_pixels, grb);
+static FX_t* strip_stream(ws2812b_t *ws, FX_stream_t *stream, uint16_t delay, uint32_t loops, fx_spare_t *spare) {
+    FX_t *FX = get_available_segment(ws, spare);
+    if(!FX || !fx_attach_block(FX, stream->width, stream->height, spare)) return NULL;
+
+    FX->stream = stream;
+    FX->from = FX->layer_from;
+    FX->to = FX->layer_from + FX->layer_len - 1;
+    FX->cursor = 0;
+    FX->step_ms = delay;
+    FX->loops = loops;
+    FX->loop_counter = 0;
+    FX->callback = noop;
+    FX->ending = false;
+    FX->canceled = false;
+    FX->z = 0;
+    FX->blend = FX_BLEND_REPLACE;
+    FX->alpha = 255;
+    fx_schedule(FX, stream_frame, delay);
+    return FX;
 }
 
-/* Setters */
-
 /**
- * @brief Set the animation frame rate
- * @param fps Frames per second
+ * @brief Play an animation from a stream, one frame at a time
+ * Only the frame on display is kept in RAM, the next one is read while it is shown.
+ * Frames are drawn from the top left corner through the geometry, like packed spritesheets.
+ * Streams are created with tools/img2grb.py --stream.
+ * @param reader Stream reader, must stay valid until the animation ends
+ * @param delay Delay between frames in milliseconds
+ * @param loops Number of loops (0 for infinite)
+ * @return Pointer to the effect descriptor, NULL if the stream is not valid or out of memory
  */
-void ws2812b_config_set_fps(uint16_t fps) {
-    config.animation_step_ms = 1000 / fps;
+FX_t* ws2812b_stream(FX_reader_t *reader, uint16_t delay, uint32_t loops) {
+    // The header is read and the buffers allocated without the lock, like the segment and its layer
+    FX_stream_t *stream = stream_open(reader);
+    if(!stream) return NULL;
+
+    fx_spare_t spare;
+    ws2812b_t *ws = strip_enter_reserved(&(fx_needs_t){
+        .segment = true, .width = stream->width, .height = stream->height
+    }, &spare);
+    FX_t *FX = strip_stream(ws, stream, delay, loops, &spare);
+    strip_unlock(ws);
+    fx_spare_free(&spare);
+    if(!FX) stream_free(stream);
+    return FX;
 }
 
+/* Stream readers */
+
 /**
- * @brief Set the frame rate for a specific effect
- * @param FX Effect descriptor
- * @param fps Frames per second
+ * @brief Read from a stream in memory
+ * @param reader Stream reader
+ * @param offset Offset in the stream
+ * @param dst Destination buffer
+ * @param len Number of bytes
+ * @return true
  */
-void ws2812b_set_fps(FX_t *FX, uint16_t fps) {
-    FX->step_ms = 1000 / fps;
+static bool memory_read(FX_reader_t *reader, uint32_t offset, void *dst, uint32_t len) {
+    memcpy(dst, (const uint8_t *)reader->source + offset, len);
+    return true;
 }
 
 /**
- * @brief Set the color inversion mode
- * @param inverted True to invert colors, false otherwise
+ * @brief Set up a reader for a stream in memory, e.g. an array compiled into the image
+ * @param reader Stream reader
+ * @param data Start of the stream
  */
-void ws2812b_set_inverted(bool inverted) {
-    config.inverted = inverted;
+void ws2812b_reader_memory(FX_reader_t *reader, const void *data) {
+    reader->read = memory_read;
+    reader->wait = NULL;
+    reader->source = (void *)data;
 }
 
+#if PICO_ON_DEVICE
 /**
- * @brief Set the background color for an effect
- * @param FX Effect descriptor
- * @param grb 24-bit GRB color value
+ * @brief Start a DMA transfer from flash, through the uncached XIP window
+ * @param reader Stream reader
+ * @param offset Offset in the stream
+ * @param dst Destination buffer
+ * @param len Number of bytes
+ * @return true
  */
-void ws2812b_set_background(FX_t *FX, uGRB32_t grb) {
-    FX->colors[1] = grb;
+static bool flash_read(FX_reader_t *reader, uint32_t offset, void *dst, uint32_t len) {
+    dma_channel_config c = dma_channel_get_default_config(reader->dma_channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    dma_channel_configure(reader->dma_channel, &c, dst,
+                          (const void *)(uintptr_t)(XIP_NOCACHE_NOALLOC_BASE + reader->base + offset), len, true);
+    return true;
 }
 
 /**
- * @brief Set the callback function for an effect
- * @param FX Effect descriptor
- * @param callback Function to call at the end of the effect
+ * @brief Wait for the DMA transfer from flash to complete
+ * @param reader Stream reader
+ * @return true
  */
-void ws2812b_set_callback(FX_t *FX, void (*callback)(void *user_data)) {
-    FX->callback = callback;
+static bool flash_wait(FX_reader_t *reader) {
+    dma_channel_wait_for_finish_blocking(reader->dma_channel);
+    return true;
 }
 
 /**
- * @brief Set the global dimming level
- * @param dim Dimming level (0-7)
+ * @brief Set up a reader for a stream stored in flash
+ * Frames are copied by DMA in the background, so the next frame is read while the current one is shown.
+ * @param reader Stream reader
+ * @param flash_offset Offset of the stream from the start of the flash
+ * @return true on success, false if no DMA channel is available
  */
-void ws2812b_set_global_dimming(uint8_t dim) {
-    if(dim > 7) dim = 7;
-    config.global_dimming = dim;
+bool ws2812b_reader_flash(FX_reader_t *reader, uint32_t flash_offset) {
+    int channel = dma_claim_unused_channel(false);
+    if(channel < 0) return false;
+    reader->read = flash_read;
+    reader->wait = flash_wait;
+    reader->base = flash_offset;
+    reader->dma_channel = channel;
+    return true;
 }
 
 /**
- * @brief Set a custom mask for the WS2812B buffer
- * @param mask Array of mask values
+ * @brief Release the resources of a stream reader
+ * @param reader Stream reader, must not be in use by an animation
  */
-void ws2812b_set_mask(const uint8_t *mask) {
-    config.global_mask = (uint8_t*)mask;
+void ws2812b_reader_close(FX_reader_t *reader) {
+    if(reader->read == flash_read) dma_channel_unclaim(reader->dma_channel);
 }
-
+#else
 /**
- * @brief Clear the mask and use the default one
+ * @brief Read from a stream in a file
+ * @param reader Stream reader
+ * @param offset Offset in the stream
+ * @param dst Destination buffer
+ * @param len Number of bytes
+ * @return true if all bytes were read
  */
-void ws2812b_clear_mask() {
-    config.global_mask = no_mask;
+static bool file_read(FX_reader_t *reader, uint32_t offset, void *dst, uint32_t len) {
+    if(fseek((FILE *)reader->source, offset, SEEK_SET) != 0) return false;
+    return fread(dst, 1, len, (FILE *)reader->source) == len;
 }
 
-/* Text functions */
-
 /**
- * @brief Get the CP0_EU bitmap for a given Unicode code point
- * @param codepoint Unicode code point
- * @return Pointer to the bitmap data
+ * @brief Set up a reader for a stream in a file, for host builds
+ * @param reader Stream reader
+ * @param path Path of the file
+ * @return true on success, false if the file can't be opened
  */
-static char* get_CP0_EU(uint32_t codepoint) {
-    uint16_t index = 0;
-    while (index < 256 && CHARMAP_CP0_EU[index] != codepoint) ++index;
-    if(index < 0 || index > 255) index = 215; // CHARMAP_CP0_EU[215] is a bullet glyph.
-                                              // Use 0 for a blank one.
-    return (char *)CP0_EU_8x8[index];
+bool ws2812b_reader_file(FX_reader_t *reader, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if(!file) return false;
+    reader->read = file_read;
+    reader->wait = NULL;
+    reader->source = file;
+    return true;
 }
 
 /**
- * @brief Type a character on the WS2812B strip
- * @param id Alarm ID
- * @param user_data Effect descriptor
- * @return Time until the next call in microseconds
- */
-static int64_t type_character(alarm_id_t id, void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
-    static bool is_gap; // Used to 'blink' between characters
-    if(is_gap && !FX->ending) {
-        ws2812b_fill_all(FX->colors[1]);
-        ws2812b_render();
-        is_gap = false;
-        return FX->gap_ms*1000;
-    }
-    if(utf8_next(&ITER)) {
-        Character = utf8_getchar(&ITER);
-        // Lookahead
-        if(!utf8_next(&ITER)) { FX->ending = true; }
-        utf8_previous(&ITER); // Revert the lookahead step
+ * @brief Release the resources of a stream reader
+ * @param reader Stream reader, must not be in use by an animation
+ */
+void ws2812b_reader_close(FX_reader_t *reader) {
+    if(reader->read == file_read) fclose((FILE *)reader->source);
+}
+#endif
 
-        const char *bitmap = get_CP0_EU(ITER.codepoint);
-        uint8_t set;
-        for (uint8_t x=0; x<8; x++) {
-            for (uint8_t y=0; y<8; y++) {
-                set = bitmap[x] & 1 << y;
-                ws2812b_buffer[x * 8 + (7 - y)] =
-                            (set ? FX->colors[0] : FX->colors[1]);
-            }
-        }
-        ws2812b_render();
-    } else { // str == 0x00, end of string
-        is_gap = false;
-        FX->running = false;
-        FX->ending = false;
-        if(FX->clear_on_end) {
-            ws2812b_fill_all(FX->colors[1]);
-            ws2812b_render();
-        }
-        FX->callback(FX);
-        return false;
+/* Spectrum analyzer */
+
+/**
+ * @brief Build the gradient palette of an effect from its colors
+ * @param FX Effect descriptor, must not be running
+ * @param colors Array of 8 24-bit GRB color values, unused positions at the end are ignored
+ * @param spare Memory reserved by strip_reserve
+ * @return True on success, false if out of memory
+ */
+static bool fx_gradient(FX_t *FX, const uGRB32_t colors[8], fx_spare_t *spare) {
+    if(!FX->palette) {
+        if(!spare->palette) return false;
+        FX->palette = spare->palette; // Kept for the next palette-based effect
+        spare->palette = NULL;
     }
-    is_gap = true; // Set flag for the next call
-    
-    return FX->step_ms*1000;
+    uint8_t stops = 8;
+    while(stops > 2 && !colors[stops - 1]) stops--;
+    ws2812b_palette(FX->palette, colors, stops);
+    return true;
 }
 
 /**
- * @brief Scroll a string of text on the WS2812B strip
- * @param id Alarm ID
- * @param user_data Effect descriptor
- * @return Time until the next call in microseconds
- */
-static int64_t scroll_text(alarm_id_t id, void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
-    uint8_t set;
-    static uint8_t pad_end;
-
-    if (FX->cursor % 8 == 0) {
-        if(utf8_next(&ITER)) {
-            Character = utf8_getchar(&ITER);
-            // Lookahead
-            if(!utf8_next(&ITER)) {
-                FX->ending = true;
-                pad_end = 2; // Padding the end of the string with two empty buffer pages
-            }
-            utf8_previous(&ITER); // Revert the lookahead step
-
-            // For each character, copy the bitmap to one of the two double_buffer pages.
-            const char *bitmap = get_CP0_EU(ITER.codepoint);
-            uint8_t buf_index = FX->buf_crs < 8 ? 0 : 1;
-            for (uint8_t y=0; y<8; y++) {
-                for (uint8_t x=0; x<8; x++) {
-                    set = bitmap[y] & 1 << x;
-                    double_buffer[y][(8 * buf_index) + x] = set;
-                }
-            }
-        } else { // str == 0x00, end of string
-            uint8_t buf_index = FX->buf_crs < 8 ? 0 : 1;
-            for (uint8_t y=0; y<8; y++) {
-                for (uint8_t x=0; x<8; x++) {
-                    double_buffer[y][(8 * buf_index) + x] = 0x0;
-                }
-            }
-            pad_end--;
-            if(pad_end == 0) {
-                FX->running = false;
-                FX->callback(FX);
-                return false;
-            }
-        }
+ * @brief Draw the current levels as vertical bars
+ * The levels are read once per frame, whoever writes them (another core,
+ * an interrupt) only has to keep each byte consistent.
+ * @param FX Effect descriptor
+ * @return Time until the next call in microseconds, 0 when done
+ */
+static int64_t spectrum_frame(FX_t *FX) {
+    ws2812b_t *ws = FX->strip;
+    if(FX->canceled) {
+        fx_detach(FX, true);
+        strip_render(ws);
+        FX->pending_callback = FX->callback;
+        return 0;
     }
 
-    // On each call, copy 8x8 bits from double_buffer, starting at FX->buf_crs,
-    // which is incremented after each call and wrapped at sizeof(double_buffer).
-    for (uint8_t y = 0; y < 8; y++) {
-        uint8_t count = 0;
-        for (uint8_t x = FX->buf_crs; count < 8; x = (x + 1) % 16) {
-            set = double_buffer[y][15-x];
-            ws2812b_buffer[y*8+count] = (set ? FX->colors[0] : FX->colors[1]);
-            count++;
+    uint16_t width = ws->config.width;
+    uint16_t height = ws->config.height;
+    for(uint16_t x = 0; x < width; x++) {
+        uint8_t level = FX->levels[(uint32_t)x * FX->bands / width];
+        uint16_t lit = ((uint32_t)level * height + 127u) / 255u; // Rows lit from the bottom
+        for(uint16_t row = 0; row < height; row++) {
+            uGRB32_t grb = 0x0;
+            if(row < lit) grb = FX->palette[(height > 1) ? (row * 255u) / (height - 1u) : 255u];
+            fx_put_xy(FX, x, height - 1 - row, grb);
         }
     }
-    FX->buf_crs++;
-    FX->buf_crs = FX->buf_crs % 16;
-    ws2812b_render();
-
-    FX->cursor++;
-    return FX->step_ms*1000;
-}
-
-/**
- * @brief Start a text typing effect on the WS2812B strip
- * @param str String to type
- * @param grb 24-bit GRB color value for the text
- * @param delay Delay between characters in milliseconds
- * @return Pointer to the effect descriptor
- */
-FX_t* ws2812b_text_type(char *str, uGRB32_t grb, uint16_t delay) {
-    FX_text.callback = noop;
-    FX_text.str = str;
-    FX_text.colors[0] = grb;
-    FX_text.colors[1] = 0x0;
-    FX_text.step_ms = delay;
-    FX_text.running = true;
-    FX_text.ending = false;
-    FX_text.gap_ms = 50;
-    FX_text.clear_on_end = true;
-    utf8_init(&ITER, str);
-    if (frame_by_frame_timer) cancel_alarm(frame_by_frame_timer);
-    frame_by_frame_timer = add_alarm_in_ms(delay, type_character, &FX_text, false);
-    return &FX_text;
+    strip_render(ws);
+    return FX->step_ms * 1000;
 }
 
 /**
- * @brief Start a scrolling text effect on the WS2812B strip
- * @param str String to scroll
- * @param grb 24-bit GRB color value for the text
- * @param delay Delay between frames in milliseconds
- * @return Pointer to the effect descriptor
+ * @brief Show levels as a spectrum analyzer on a strip. The lock must be held.
+ * @param ws Strip
+ * @param levels Array of levels (0-255), read on every frame
+ * @param bands Number of levels, spread over the width of the display
+ * @param colors Array of 8 24-bit GRB color values, a gradient from the bottom to the top row
+ * @param spare Memory reserved by strip_reserve
+ * @return Pointer to the effect descriptor, NULL if out of memory
  */
-FX_t* ws2812b_text_scroll(char *str, uGRB32_t grb, uint16_t delay) {
-    FX_text.callback = noop;
-    FX_text.str = str;
-    FX_text.cursor = 0;
-    FX_text.buf_crs = 0;
-    FX_text.colors[0] = grb;
-    FX_text.colors[1] = 0x0;
-    FX_text.step_ms = delay;
-    FX_text.running = true;
-    FX_text.ending = false;
-    FX_text.clear_on_end = true; // Not in use for this type of effect
-    utf8_init(&ITER, str);
-    if (frame_by_frame_timer) cancel_alarm(frame_by_frame_timer);
-    frame_by_frame_timer = add_alarm_in_ms(delay, scroll_text, &FX_text, false);
-    return &FX_text;
+static FX_t* strip_spectrum(ws2812b_t *ws, const volatile uint8_t *levels, uint16_t bands, const uGRB32_t colors[8],
+                            fx_spare_t *spare) {
+    if(!bands) return NULL;
+    FX_t *FX = get_available_segment(ws, spare);
+    if(!FX) return NULL;
+    if(!fx_gradient(FX, colors, spare)) return NULL;
+    if(!fx_attach_block(FX, UINT16_MAX, UINT16_MAX, spare)) return NULL; // Whole display
+    FX->levels = levels;
+    FX->bands = bands;
+    FX->step_ms = ws->config.animation_step_ms;
+    FX->callback = noop;
+    FX->ending = false;
+    FX->canceled = false;
+    FX->z = 0;
+    FX->blend = FX_BLEND_REPLACE;
+    FX->alpha = 255;
+    fx_schedule(FX, spectrum_frame, FX->step_ms);
+    return FX;
 }
 
-/* Sprite functions */
-
 /**
- * @brief Display a sprite on the WS2812B strip
- * @param sprite Pointer to the sprite data
+ * @brief Show levels as a spectrum analyzer, one bar per column, until canceled
+ * @param levels Array of levels (0-255), read on every frame
+ * @param bands Number of levels, spread over the width of the display
+ * @param colors Array of 8 24-bit GRB color values, a gradient from the bottom to the top row
+ * @return Pointer to the effect descriptor, NULL if out of memory
  */
-void ws2812b_sprite(const uGRB32_t *sprite) {
-    for (uint8_t x=0; x<8; x++) {
-        for (uint8_t y=0; y<8; y++) {
-            ws2812b_buffer[x*8+y] = sprite[x*8+y];
-        }
-    }
+FX_t* ws2812b_spectrum(const volatile uint8_t *levels, uint16_t bands, const uGRB32_t colors[8]) {
+    fx_spare_t spare;
+    ws2812b_t *ws = strip_enter_reserved(&(fx_needs_t){
+        .segment = true, .width = UINT16_MAX, .height = UINT16_MAX, .palette = true
+    }, &spare);
+    FX_t *FX = strip_spectrum(ws, levels, bands, colors, &spare);
+    strip_unlock(ws);
+    fx_spare_free(&spare);
+    return FX;
 }
 
-/**
- * @brief Display a tinted sprite on the WS2812B strip
- * @param sprite Pointer to the sprite data
- * @param grb 24-bit GRB color value for the tint
- */
-void ws2812b_sprite_tint(const uGRB32_t *sprite, uGRB32_t grb) {
-    for (uint8_t x=0; x<8; x++) {
-        for (uint8_t y=0; y<8; y++) {
-            bool set = sprite[x*8+y];
-            ws2812b_buffer[x*8+y] = (set ? grb : 0x0);
-        }
-    }
-}
+/* Procedural effects */
 
 /**
- * @brief Display a frame from a spritesheet on the WS2812B strip
- * @param id Alarm ID
- * @param user_data Effect descriptor
- * @return Time until the next call in microseconds
+ * @brief Apply an easing curve to a normalized time
+ * @param ease Easing curve
+ * @param t Normalized time (0-65535)
+ * @return Eased normalized time (0-65535)
  */
-static int64_t spritesheet_frame(alarm_id_t id, void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
-    if(FX->canceled) {
-        FX->running = false;
-        return 0;
-    }
-    if(FX->ending) {
-        FX->running = false;
-        FX->ending = false;
-        FX->callback(FX);
-        return 0;
-    }
-    ws2812b_sprite(FX->spritesheet[FX->cursor]);
-    ws2812b_render();
-    if(++FX->cursor >= FX->frames) {
-        FX->cursor = 0;
-        if(++FX->loop_counter >= FX->loops && FX->loops > 0) {
-            FX->ending = true;
-        }
+static uint16_t fx_ease(FX_ease_t ease, uint16_t t) {
+    uint32_t u = t;
+    uint32_t v = 0xffffu - t;
+    switch(ease) {
+        case FX_EASE_IN_QUAD:
+            return (u * u) >> 16;
+        case FX_EASE_OUT_QUAD:
+            return 0xffffu - ((v * v) >> 16);
+        case FX_EASE_IN_OUT_QUAD:
+            if(u < 0x8000u) return (u * u) >> 15;
+            return 0xffffu - ((v * v) >> 15);
+        case FX_EASE_IN_OUT_CUBIC:
+            if(u < 0x8000u) return ((uint64_t)u * u * u) >> 30;
+            return 0xffffu - (((uint64_t)v * v * v) >> 30);
+        default:
+            return t;
     }
-
-    return FX->step_ms*1000;
 }
 
 /**
- * @brief Start a spritesheet animation on the WS2812B strip
- * @param spritesheet Pointer to the array of sprite frames
- * @param frames Number of frames in the spritesheet
- * @param delay Delay between frames in milliseconds
- * @param loops Number of loops (0 for infinite)
- * @return Pointer to the effect descriptor
+ * @brief Get the cursor position at a given point of a loop
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
+ * @return Cursor position, between FX->start and FX->end
  */
-FX_t* ws2812b_spritesheet(const uGRB32_t **spritesheet, uint8_t frames,
-                          uint16_t delay, uint32_t loops) {
-    FX_text.callback = noop;
-    FX_text.spritesheet = spritesheet;
-    FX_text.cursor = 0;
-    FX_text.frames = frames;
-    FX_text.step_ms = delay;
-    FX_text.loops = loops;
-    FX_text.loop_counter = 0;
-    FX_text.running = true;
-    FX_text.ending = false;
-    if (frame_by_frame_timer) cancel_alarm(frame_by_frame_timer);
-    frame_by_frame_timer = add_alarm_in_ms(delay, spritesheet_frame, &FX_text, false);
-    return &FX_text;
+static uint32_t fx_cursor_at(FX_t *FX, uint16_t t) {
+    uint32_t pos = ((uint64_t)t * (FX->end - FX->start + 1)) >> 16;
+    return ((FX->dir == 1) ? FX->start + pos : FX->end - pos);
 }
 
-/* Procedural effects */
+/* Procedural effects
+Effect functions draw the state of the effect at FX->cursor during loop
+FX->loop_counter, both derived from the elapsed time by animation_step.
+They don't depend on the previous frame, so frames can be skipped.
+*/
 
 /* FX_SCAN
 Draws a running pixel.
 colors[0]: effect
 colors[1]: background, drawn only after the cursor has left a position
-param: eases the movement if true
+param: eases the movement if true (same as FX_EASE_IN_OUT_QUAD)
 */
 /**
  * @brief Scan effect, draws a running pixel
- * @param user_data Effect descriptor
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
  */
-static void fx_scan(void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
-    static uint16_t last_p = 0xffff;
-
-    uint16_t p = FX->cursor;
-    if(FX->param) { // Quadratic easing
-        uint32_t t = FX->cursor * 0xff / FX->end;
-        uint8_t e = t;
-        if (e & 0x80) { e = 0xff - e; }
-        uint8_t ee2 = ((e * e) / 0x100) << 1;
-        if (t & 0x80) { ee2 = 0xff - ee2; }
-        uint32_t f = ee2;
-        p = f * FX->end / 0xff;
+static void fx_scan(FX_t *FX, uint16_t t) {
+    if(FX->loop_counter) { // The whole range was scanned already
+        fx_fill(FX, FX->start, FX->end, FX->colors[1]);
+    } else if(FX->cursor != ((FX->dir == 1) ? FX->start : FX->end)) {
+        fx_fill(FX, ((FX->dir == 1) ? FX->start : FX->end),
+                FX->cursor - FX->dir, FX->colors[1]);
     }
-    ws2812b_buffer[p] = FX->colors[0];
-    if(last_p <0xffff) ws2812b_buffer[last_p] = FX->colors[1];
-    if(FX->ending) last_p = 0xffff;
-    last_p = p;
+    fx_put(FX, FX->cursor, FX->colors[0]);
 }
 
 /* FX_WIPE
@@ -656,12 +2754,12 @@ param: not used
 */
 /**
  * @brief Wipe effect function
- * @param user_data Effect descriptor
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
  */
-static void fx_wipe(void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
-    ws2812b_fill(((FX->dir == 1) ? FX->start : FX->end),
-                 FX->cursor, FX->colors[0]);
+static void fx_wipe(FX_t *FX, uint16_t t) {
+    fx_fill(FX, ((FX->dir == 1) ? FX->start : FX->end),
+            FX->cursor, FX->colors[0]);
 }
 
 /* FX_RANDOM
@@ -671,13 +2769,13 @@ param: specifies the number of colors to use (2 to 8, default 8)
 */
 /**
  * @brief Random effect function
- * @param user_data Effect descriptor
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
  */
-static void fx_random(void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
+static void fx_random(FX_t *FX, uint16_t t) {
     for(uint32_t i = FX->from; i <= FX->to; i++) {
-        uint8_t c = rand() % 8;
-        ws2812b_put(i, FX->colors[c]);
+        uint8_t c = strip_random(FX->strip) >> 29; // Top 3 bits, 0-7
+        fx_put(FX, i, FX->colors[c]);
         // It's hallWS2812Bgenic!
     }
 }
@@ -689,12 +2787,12 @@ param: duration of the effect in steps
 */
 /**
  * @brief Blink effect function
- * @param user_data Effect descriptor
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
  */
-static void fx_blink(void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
+static void fx_blink(FX_t *FX, uint16_t t) {
     bool is_odd = (FX->cursor) % 2;
-    ws2812b_fill(FX->from, FX->to, FX->colors[is_odd]);
+    fx_fill(FX, FX->from, FX->to, FX->colors[is_odd]);
 }
 
 /* FX_CHASER
@@ -704,15 +2802,15 @@ param: specifies the number of colors to use (2 to 8, default 2)
 */
 /**
  * @brief Chaser effect function
- * @param user_data Effect descriptor
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
  */
-static void fx_chaser(void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
+static void fx_chaser(FX_t *FX, uint16_t t) {
     uint8_t wrap = 2;
     if (FX->param > 2 && FX->param <= 8) { wrap = FX->param;}
     for(uint32_t i = FX->start; i <= FX->end; i++) {
         uint8_t c = (FX->cursor + i) % wrap;
-        ws2812b_put(i, FX->colors[c]);
+        fx_put(FX, i, FX->colors[c]);
     }
 }
 
@@ -724,135 +2822,284 @@ Note: the effect won't work with global dimming set to high values
 */
 /**
  * @brief Fade effect function
- * @param user_data Effect descriptor
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
+ */
+static void fx_fade(FX_t *FX, uint16_t t) {
+    uint8_t brightness = FX->cursor; // 0-100
+    fx_fill(FX, FX->from, FX->to, ws2812b_scale(FX->colors[0], brightness * 255u / 100u));
+}
+
+/**
+ * @brief Integer sine wave.
+ * A parabola per half period, close enough to a sine for color waves.
+ * @param angle Angle (0-255 is a full turn)
+ * @return Sine (0-255, 128 at 0)
+ */
+static inline uint32_t sin8(uint32_t angle) {
+    uint32_t a = angle & 0x7fu;
+    uint32_t half = (a * (128u - a)) >> 5; // 0-128
+    if(half > 127) half = 127;
+    return (angle & 0x80u) ? 128u - half : 128u + half;
+}
+
+/**
+ * @brief Number of steps elapsed since a palette-based effect started.
+ * @param FX Effect descriptor
+ * @return Elapsed steps
+ */
+static inline uint32_t fx_elapsed_steps(FX_t *FX) {
+    return FX->loop_counter * (FX->end - FX->start + 1) + (FX->cursor - FX->start);
+}
+
+/* FX_FIRE
+Rising flames over a matrix, from value noise fading towards the top row
+colors[0-7]: gradient from the coldest to the hottest color (e.g. colors_fire)
+param: duration of one loop in steps (default 256)
+Cost per frame: one 3D noise sample per pixel
+*/
+/**
+ * @brief Fire effect function
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
+ */
+static void fx_fire(FX_t *FX, uint16_t t) {
+    ws2812b_t *ws = FX->strip;
+    uint32_t steps = fx_elapsed_steps(FX);
+    uint16_t height = ws->config.height;
+    for(uint16_t y = 0; y < height; y++) {
+        uint32_t weight = (y + 1u) * 383u / height; // Hotter towards the bottom row
+        for(uint16_t x = 0; x < ws->config.width; x++) {
+            uint16_t pixel = lookup_xy(ws, x, y);
+            if(pixel - FX->layer_from >= FX->layer_len) continue; // Outside of the range
+            // Sampling further down the noise as time passes makes the flames rise
+            uint32_t heat = ws2812b_noise(x * 96u, y * 64u + steps * 24u, steps * 6u);
+            heat = (heat * weight) >> 8;
+            fx_put(FX, pixel, FX->palette[heat > 255 ? 255 : heat]);
+        }
+    }
+}
+
+/* FX_PLASMA
+Interfering color waves over a matrix
+colors[0-7]: gradient, wrapped around by the waves
+param: duration of one loop in steps (default 256)
+Cost per frame: three sine approximations per pixel, no division
+*/
+/**
+ * @brief Plasma effect function
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
  */
-static void fx_fade(void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
-    if(FX->ending) return;
-    uint8_t g = (FX->colors[0] >> 16u) & 0xffu;
-    uint8_t r = (FX->colors[0] >> 8u) & 0xffu;
-    uint8_t b = FX->colors[0] & 0xffu;
-    uint8_t brightness = (FX->dir ? FX->cursor : 100 - FX->cursor);
+static void fx_plasma(FX_t *FX, uint16_t t) {
+    ws2812b_t *ws = FX->strip;
+    uint32_t steps = fx_elapsed_steps(FX);
+    for(uint16_t y = 0; y < ws->config.height; y++) {
+        uint32_t wave_y = sin8(y * 24u + steps * 2u);
+        for(uint16_t x = 0; x < ws->config.width; x++) {
+            uint16_t pixel = lookup_xy(ws, x, y);
+            if(pixel - FX->layer_from >= FX->layer_len) continue; // Outside of the range
+            uint32_t value = sin8(x * 32u + steps * 3u) + wave_y + sin8((x + y) * 16u + steps * 5u);
+            fx_put(FX, pixel, FX->palette[(value * 85u) >> 8]); // Average of three waves
+        }
+    }
+}
 
-    r = r * brightness / 100;
-    g = g * brightness / 100;
-    b = b * brightness / 100;
-    ws2812b_fill(FX->from, FX->to, ws2812b_rgb((uint8_t)r, (uint8_t)g, (uint8_t)b));
+/* FX_NOISE
+Slowly drifting clouds of colors over a matrix
+colors[0-7]: gradient
+param: duration of one loop in steps (default 256)
+Cost per frame: one 3D noise sample per pixel
+*/
+/**
+ * @brief Noise effect function
+ * @param FX Effect descriptor
+ * @param t Eased normalized time (0-65535)
+ */
+static void fx_noise(FX_t *FX, uint16_t t) {
+    ws2812b_t *ws = FX->strip;
+    uint32_t steps = fx_elapsed_steps(FX);
+    for(uint16_t y = 0; y < ws->config.height; y++) {
+        for(uint16_t x = 0; x < ws->config.width; x++) {
+            uint16_t pixel = lookup_xy(ws, x, y);
+            if(pixel - FX->layer_from >= FX->layer_len) continue; // Outside of the range
+            int32_t value = ws2812b_noise(x * 48u, y * 48u, steps * 8u);
+            value = 128 + (value - 128) * 3 / 2; // Value noise stays around the middle, stretch it
+            fx_put(FX, pixel, FX->palette[value < 0 ? 0 : value > 255 ? 255 : value]);
+        }
+    }
 }
 
 /**
  * @brief Step function for animations
- * @param id Alarm ID
- * @param user_data Effect descriptor
- * @return Time until the next call in microseconds
+ * The effect is evaluated at the current time rather than advanced by one
+ * step, so a late step skips frames instead of slowing the animation down.
+ * @param FX Effect descriptor
+ * @return Time until the next call in microseconds, 0 when done
  */
-static int64_t animation_step(alarm_id_t id, void *user_data) {
-    FX_t* FX = (FX_t*)user_data;
+static int64_t animation_step(FX_t *FX) {
+    ws2812b_t *ws = FX->strip;
 
     if(FX->canceled) {
-        FX->running = false;
+        fx_detach(FX, true);
+        strip_render(ws);
         return 0;
     }
 
     if(FX->ending) {
         if(FX->clear_on_end) { // Cleanup
-            ws2812b_fill(FX->from, FX->to, 0x0);
-            ws2812b_render();
+            strip_fill(ws, FX->from, FX->to, 0x0);
         }
-        FX->callback(FX);
-        FX->running = false;
         FX->ending = false;
+        fx_detach(FX, !FX->clear_on_end);
+        strip_render(ws);
+        FX->pending_callback = FX->callback;
         return 0; // Stop the animation
     }
 
-    // Call the actual effect function 
-    FX->fx_function(user_data);
-    ws2812b_render();
+    // Split the elapsed time into a loop count and a normalized time
+    // Neither can be 0: step_ms may have been written directly, and the range may span all of uint32_t
+    uint64_t step_us = (FX->step_ms ? FX->step_ms : 1) * 1000ull;
+    uint64_t duration_us = step_us * ((uint64_t)(FX->end - FX->start) + 1);
+    uint64_t elapsed_us = (ws->tick_us > FX->start_us) ? ws->tick_us - FX->start_us : 0;
+    uint64_t loop = elapsed_us / duration_us;
+    uint16_t t = ((elapsed_us % duration_us) << 16) / duration_us;
+    if(loop >= FX->loops && FX->loops > 0) {
+        loop = FX->loops - 1; // Hold the last position for one step
+        t = 0xffff;
+        FX->ending = true;
+    }
 
-    FX->cursor += FX->dir; // Update the cursor position for the next step
-    
-    // Reaching the end of a segment
-    if((FX->cursor > FX->end || FX->cursor < FX->start)) {
-        FX->cursor = ((FX->dir == 1) ? FX->start : FX->end);
-        if(++FX->loop_counter >= FX->loops && FX->loops > 0) {
-            FX->ending = true;
-        }
+    // Redraw only when the visible state has changed
+    t = fx_ease(FX->ease, t);
+    uint32_t cursor = fx_cursor_at(FX, t);
+    if(!FX->drawn || cursor != FX->cursor || loop != FX->loop_counter) {
+        FX->cursor = cursor;
+        FX->loop_counter = loop;
+        FX->drawn = true;
+        FX->fx_function(FX, t); // Call the actual effect function
+        strip_render(ws);
     }
 
-    return FX->step_ms*1000;
+    // Wake up on the next step boundary, skipping the missed ones
+    uint64_t late_us = (ws->tick_us > FX->due_us) ? ws->tick_us - FX->due_us : 0;
+    return late_us - late_us % step_us + step_us;
 }
 
 /**
- * @brief Animate pixels between the selected range using an effect preset
+ * @brief Animate pixels of a strip using an effect preset. The lock must be held.
+ * @param ws Strip
  * @param from Start pixel index
  * @param to End pixel index (invert to-from values to change direction)
  * @param mode Effect mode (see README for a complete list of presets)
  * @param colors Array of 8 24-bit GRB color values
  * @param loops Number of loops (0 for infinite)
  * @param param Function-specific parameter
- * @return Pointer to the effect descriptor
+ * @param spare Memory reserved by strip_reserve
+ * @return Pointer to the effect descriptor, NULL if out of memory
  */
-FX_t* ws2812b_animate(uint32_t from, uint32_t to, FX_mode_t mode,
-                    const uGRB32_t colors[8], uint32_t loops, uint32_t param) {
-    uint8_t seg_id = get_available_segment();
-    fxs[seg_id].from = from;
-    fxs[seg_id].to = to;
-    fxs[seg_id].cursor = from;
-    fxs[seg_id].start  = ((from <= to) ? from : to);
-    fxs[seg_id].end    = ((from >  to) ? from : to);
-    fxs[seg_id].dir    = ((from <= to) ? 1    : -1);
-    fxs[seg_id].mode = mode;
+static FX_t* strip_animate(ws2812b_t *ws, uint32_t from, uint32_t to, FX_mode_t mode,
+                           const uGRB32_t colors[8], uint32_t loops, uint32_t param, fx_spare_t *spare) {
+    FX_t *FX = get_available_segment(ws, spare);
+    if(!FX) return NULL;
+    if(!fx_attach_layer(FX, from, to, spare)) return NULL;
+    FX->from = from;
+    FX->to = to;
+    FX->cursor = from;
+    FX->start  = ((from <= to) ? from : to);
+    FX->end    = ((from >  to) ? from : to);
+    FX->dir    = ((from <= to) ? 1    : -1);
+    FX->mode = mode;
     for(uint16_t i=0; i<8; i++) {
-        fxs[seg_id].colors[i] = colors[i];
-    }
-    fxs[seg_id].param = param;
-    fxs[seg_id].loops = loops;
-    fxs[seg_id].loop_counter = 0;
-    fxs[seg_id].step_ms = config.animation_step_ms;
-    fxs[seg_id].callback = noop;
-    fxs[seg_id].running = true;
-    fxs[seg_id].ending = false;
-    fxs[seg_id].canceled = false;
-    fxs[seg_id].clear_on_end = true;
+        FX->colors[i] = colors[i];
+    }
+    FX->param = param;
+    FX->loops = loops;
+    FX->loop_counter = 0;
+    FX->step_ms = ws->config.animation_step_ms;
+    FX->ease = ((mode == FX_SCAN && param) ? FX_EASE_IN_OUT_QUAD : FX_EASE_LINEAR);
+    FX->drawn = false;
+    FX->callback = noop;
+    FX->ending = false;
+    FX->canceled = false;
+    FX->clear_on_end = true;
+    FX->z = 0;
+    FX->blend = FX_BLEND_REPLACE;
+    FX->alpha = 255;
 
     switch(mode) {
         case FX_SCAN:
-            fxs[seg_id].fx_function = fx_scan;
+            FX->fx_function = fx_scan;
             break;
         case FX_WIPE:
-            fxs[seg_id].fx_function = fx_wipe;
-            fxs[seg_id].clear_on_end = false;
+            FX->fx_function = fx_wipe;
+            FX->clear_on_end = false;
             break;
         case FX_CHASER:
-            fxs[seg_id].fx_function = fx_chaser;
+            FX->fx_function = fx_chaser;
             break;
         case FX_BLINK:
-            fxs[seg_id].start = 0;
-            fxs[seg_id].end = (param ? param - 1 : 3); // 0 to 3 is 4 blinks as a default value
-            fxs[seg_id].dir = 1; // Override
-            fxs[seg_id].cursor = 0; // Override
-            fxs[seg_id].fx_function = fx_blink;
+            FX->start = 0;
+            FX->end = (param ? param - 1 : 3); // 0 to 3 is 4 blinks as a default value
+            FX->dir = 1; // Override
+            FX->cursor = 0; // Override
+            FX->fx_function = fx_blink;
             break;
         case FX_RANDOM:
-            init_random();
-            fxs[seg_id].start = 0;
-            fxs[seg_id].end = (param ? param - 1 : 3); // 0 to 3 is 4 blinks as a default value
-            fxs[seg_id].dir = 1; // Override
-            fxs[seg_id].cursor = 0; // Override
-            fxs[seg_id].fx_function = fx_random;
-            fxs[seg_id].clear_on_end = false;
+            init_random(ws);
+            FX->start = 0;
+            FX->end = (param ? param - 1 : 3); // 0 to 3 is 4 blinks as a default value
+            FX->dir = 1; // Override
+            FX->cursor = 0; // Override
+            FX->fx_function = fx_random;
+            FX->clear_on_end = false;
             break;
         case FX_FADE:
-            fxs[seg_id].start = 0;
-            fxs[seg_id].end = 100;
-            fxs[seg_id].cursor = ((from <= to) ? 0 : 100);
-            fxs[seg_id].fx_function = fx_fade;
-            fxs[seg_id].clear_on_end = false;
+            FX->start = 0;
+            FX->end = 100;
+            FX->cursor = ((from <= to) ? 0 : 100);
+            FX->fx_function = fx_fade;
+            FX->clear_on_end = false;
             break;
+        case FX_FIRE:
+        case FX_PLASMA:
+        case FX_NOISE: {
+            if(!fx_gradient(FX, colors, spare)) return NULL;
+            // Pixels are drawn by coordinates, start and end only time the loop
+            FX->start = 0;
+            FX->end = (param ? param - 1 : 255);
+            FX->dir = 1; // Override
+            FX->cursor = 0; // Override
+            FX->fx_function = ((mode == FX_FIRE) ? fx_fire : (mode == FX_PLASMA) ? fx_plasma : fx_noise);
+            break;
+        }
     }
-    if(animation_timers[seg_id]) cancel_alarm(animation_timers[seg_id]);
-    animation_timers[seg_id] = add_alarm_in_ms(config.animation_step_ms, animation_step, &fxs[seg_id], false);
-    return &fxs[seg_id];
+    FX->start_us = time_us_64() + FX->step_ms * 1000ull;
+    fx_schedule(FX, animation_step, FX->step_ms);
+    return FX;
+}
+
+/**
+ * @brief Animate pixels between the selected range using an effect preset
+ * @param from Start pixel index
+ * @param to End pixel index (invert to-from values to change direction)
+ * @param mode Effect mode (see README for a complete list of presets)
+ * @param colors Array of 8 24-bit GRB color values
+ * @param loops Number of loops (0 for infinite)
+ * @param param Function-specific parameter
+ * @return Pointer to the effect descriptor, NULL if out of memory
+ */
+FX_t* ws2812b_animate(uint32_t from, uint32_t to, FX_mode_t mode,
+                    const uGRB32_t colors[8], uint32_t loops, uint32_t param) {
+    fx_spare_t spare;
+    ws2812b_t *ws = strip_enter_reserved(&(fx_needs_t){
+        .segment = true, .from = from, .to = to,
+        .palette = (mode == FX_FIRE || mode == FX_PLASMA || mode == FX_NOISE)
+    }, &spare);
+    FX_t *FX = strip_animate(ws, from, to, mode, colors, loops, param, &spare);
+    strip_unlock(ws);
+    fx_spare_free(&spare);
+    return FX;
 }
 
 /**
@@ -863,34 +3110,6 @@ void ws2812b_cancel(FX_t* FX){
     FX->canceled = true;
 }
 
-void invert_matrix_vertical(uint8_t* matrix, int rows, int cols) {
-    for (int i = 0; i < rows / 2; i++) {
-        for (int j = 0; j < cols; j++) {
-            uint8_t temp = matrix[i * cols + j];
-            matrix[i * cols + j] = matrix[(rows - i - 1) * cols + j];
-            matrix[(rows - i - 1) * cols + j] = temp;
-        }
-    }
-}
-
-// Função para inverter apenas as linhas pares da matriz horizontalmente 
-void invert_matrix_horizontal_even_rows(uint8_t* matrix, int rows, int cols) { 
-    for (int i = 0; i < rows; i += 2) {
-         // Incrementa de 2 em 2 para pegar apenas as linhas pares (0, 2, 4, ...)
-        for (int j = 0; j < cols / 2; j++) {
-            uint8_t temp = matrix[i * cols + j];
-            matrix[i * cols + j] = matrix[i * cols + (cols - j - 1)];
-            matrix[i * cols + (cols - j - 1)] = temp; 
-        }
-    } 
-}
-
-// Função para os desenhos funcionar normalmente, e placa ficar corretamente ajustada conforme as imagens da documentação
-void fixingBitDogLab(uint8_t* matrix, int rows, int cols){
-    invert_matrix_vertical(matrix, rows, cols);
-    invert_matrix_horizontal_even_rows(matrix, rows, cols);
-}
-
 // Define the ws2812b_set_pixel function to set a specific pixel in the LED matrix
 void ws2812b_set_pixel(uint16_t pixel, uGRB32_t grb) {
     ws2812b_put(pixel, grb);
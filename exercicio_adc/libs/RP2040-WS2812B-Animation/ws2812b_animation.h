@@ -7,6 +7,7 @@
 #ifndef WS2812B_H
 #define WS2812B_H
 
+#include "pico/time.h"
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
 #include "ws2812.pio.h"
@@ -34,10 +35,23 @@ extern "C" {
 #define WS2812B_DELAY_US 300
 
 /**
- * @def MAX_EFFECTS
- * @brief Maximum number of simultaneous sections with independent effects.
+ * @def WS2812B_FRAME_US
+ * @brief Minimum time between two transmissions, caps the framerate to 200fps.
  */
-#define MAX_EFFECTS 4
+#define WS2812B_FRAME_US 5000
+
+/**
+ * @def WS2812B_MAX_CATCHUP_STEPS
+ * @brief Maximum number of late steps an effect runs in a single frame before dropping the rest.
+ */
+#define WS2812B_MAX_CATCHUP_STEPS 4
+
+/**
+ * @def WS2812B_DIRTY_RANGES
+ * @brief Number of separate ranges of modified pixels tracked between two frames.
+ * Effects drawing far apart are composited apart, beyond that the closest ranges are merged.
+ */
+#define WS2812B_DIRTY_RANGES 4
 
 /**
  * @typedef uGRB32_t
@@ -45,6 +59,12 @@ extern "C" {
  */
 typedef uint32_t uGRB32_t;
 
+/**
+ * @def WS2812B_OPAQUE
+ * @brief Coverage flag stored in the unused top byte of layer pixels. Pixels without it are transparent.
+ */
+#define WS2812B_OPAQUE 0xff000000u
+
 /**
  * @enum FX_mode_t
  * @brief Enumerated type for different animation modes.
@@ -56,8 +76,103 @@ typedef enum {
     FX_RANDOM       = 3,
     FX_BLINK        = 4,
     FX_FADE         = 5,
+    FX_FIRE         = 6,
+    FX_PLASMA       = 7,
+    FX_NOISE        = 8,
 } FX_mode_t;
 
+/**
+ * @enum FX_blend_t
+ * @brief Enumerated type for the ways an effect layer is blended with the layers below it.
+ */
+typedef enum {
+    FX_BLEND_REPLACE = 0,
+    FX_BLEND_ADD     = 1,
+    FX_BLEND_ALPHA   = 2,
+} FX_blend_t;
+
+/**
+ * @enum FX_ease_t
+ * @brief Enumerated type for the easing curves applied to the time within a loop of an effect.
+ */
+typedef enum {
+    FX_EASE_LINEAR       = 0,
+    FX_EASE_IN_QUAD      = 1,
+    FX_EASE_OUT_QUAD     = 2,
+    FX_EASE_IN_OUT_QUAD  = 3,
+    FX_EASE_IN_OUT_CUBIC = 4,
+} FX_ease_t;
+
+/**
+ * @struct FX_sheet_t
+ * @brief Packed spritesheet of 8x8 frames, generated by tools/img2grb.py --sheet.
+ * @details Pixels are 4-bit indices into the palette. Each frame starts with its type:
+ *          0, RLE: tokens rrrrcccc, a run of r+1 pixels of color c, up to 64 pixels;
+ *          1, delta: a count of pixels kept from the previous frame, followed by a
+ *             token as above, repeated up to 64 pixels;
+ *          2, raw: 32 bytes of two indices each, high nibble first.
+ */
+typedef struct {
+    /**
+     * @brief Up to 16 colors used by the frames.
+     */
+    const uGRB32_t *palette;
+
+    /**
+     * @brief Offset of each frame in data.
+     */
+    const uint16_t *offsets;
+
+    /**
+     * @brief Encoded frames.
+     */
+    const uint8_t *data;
+
+    /**
+     * @brief Number of frames.
+     */
+    uint8_t frames;
+} FX_sheet_t;
+
+/**
+ * @struct FX_reader_t
+ * @brief Source of a streamed animation, see ws2812b_stream.
+ * @details read may return before the data is available, in which case wait
+ *          blocks until it is. Synchronous readers leave wait NULL.
+ */
+typedef struct FX_reader_t {
+    /**
+     * @brief Read len bytes at offset into dst. Returns false on error.
+     */
+    bool (*read)(struct FX_reader_t *reader, uint32_t offset, void *dst, uint32_t len);
+
+    /**
+     * @brief Wait for the last read to complete, or NULL. Returns false on error.
+     */
+    bool (*wait)(struct FX_reader_t *reader);
+
+    /**
+     * @brief Reader-specific source: memory address, file handle.
+     */
+    void *source;
+
+    /**
+     * @brief Offset of the stream in flash (flash reader).
+     */
+    uint32_t base;
+
+    /**
+     * @brief DMA channel (flash reader).
+     */
+    int dma_channel;
+} FX_reader_t;
+
+/**
+ * @typedef ws2812b_t
+ * @brief Handle of a strip, see ws2812b_create.
+ */
+typedef struct ws2812b ws2812b_t;
+
 /**
  * @struct FX_t
  * @brief Structure representing an animation effect.
@@ -68,10 +183,15 @@ typedef struct FX_t {
      */
     void (*callback)(void *user_data);
 
+    /**
+     * @brief Callback of the effect once it has ended, run by the scheduler after releasing the lock.
+     */
+    void (*pending_callback)(void *user_data);
+
     /**
      * @brief Function pointer to the animation effect function.
      */
-    void (*fx_function)(void *user_data);
+    void (*fx_function)(struct FX_t *FX, uint16_t t);
 
     /**
      * @brief Cursor position for the animation effect.
@@ -133,6 +253,21 @@ typedef struct FX_t {
      */
     uint32_t step_ms;
 
+    /**
+     * @brief Time of the first step in microseconds, loops are timed from here.
+     */
+    uint64_t start_us;
+
+    /**
+     * @brief Easing curve for the animation effect.
+     */
+    FX_ease_t ease;
+
+    /**
+     * @brief Flag indicating whether the animation effect has drawn its first frame.
+     */
+    bool drawn;
+
     /**
      * @brief Flag indicating whether the animation effect is running.
      */
@@ -164,21 +299,169 @@ typedef struct FX_t {
     uint32_t gap_ms;
 
     /**
-     * @brief Buffer cursor for the animation effect (only applicable for text-based effects).
+     * @brief Spritesheet for the animation effect (only applicable for sequence-based effects).
      */
-    uint8_t buf_crs;
+    const uGRB32_t **spritesheet;
 
     /**
-     * @brief Spritesheet for the animation effect (only applicable for sequence-based effects).
+     * @brief Packed spritesheet for the animation effect, used instead of spritesheet when set.
      */
-    const uGRB32_t **spritesheet;
+    const FX_sheet_t *sheet;
+
+    /**
+     * @brief State of a streamed animation (only applicable for ws2812b_stream).
+     */
+    struct FX_stream_t *stream;
 
     /**
      * @brief Number of frames for the animation effect (only applicable for sequence-based effects).
      */
     uint8_t frames;
+
+    /**
+     * @brief Pixels drawn by the effect, composited on top of the shared buffer.
+     */
+    uGRB32_t *layer;
+
+    /**
+     * @brief Index of the first pixel covered by the layer.
+     */
+    uint32_t layer_from;
+
+    /**
+     * @brief Number of pixels covered by the layer.
+     */
+    uint32_t layer_len;
+
+    /**
+     * @brief 256-entry gradient palette (only applicable for palette-based effects).
+     */
+    uGRB32_t *palette;
+
+    /**
+     * @brief Levels shown as bars (only applicable for ws2812b_spectrum).
+     */
+    const volatile uint8_t *levels;
+
+    /**
+     * @brief Number of levels (only applicable for ws2812b_spectrum).
+     */
+    uint16_t bands;
+
+    /**
+     * @brief Compositing order, layers with a higher z are drawn on top.
+     */
+    uint8_t z;
+
+    /**
+     * @brief Blend mode of the layer.
+     */
+    FX_blend_t blend;
+
+    /**
+     * @brief Opacity of the layer for FX_BLEND_ALPHA (0-255).
+     */
+    uint8_t alpha;
+
+    /**
+     * @brief Step function, returns the time until the next step in microseconds or 0 when done.
+     */
+    int64_t (*step)(struct FX_t *FX);
+
+    /**
+     * @brief Time of the next step in microseconds.
+     */
+    uint64_t due_us;
+
+    /**
+     * @brief Strip the effect draws on.
+     */
+    ws2812b_t *strip;
 } FX_t;
 
+/**
+ * @def WS2812B_NO_PIXEL
+ * @brief Returned by ws2812b_xy for coordinates without a pixel.
+ */
+#define WS2812B_NO_PIXEL 0xffff
+
+/**
+ * @enum ws2812b_blit_t
+ * @brief Enumerated type for how the pixels of a sprite are copied, see ws2812b_blit.
+ */
+typedef enum {
+    WS2812B_BLIT_OPAQUE = 0, // Every pixel is copied, black ones too
+    WS2812B_BLIT_MASKED = 1, // Black pixels are transparent
+} ws2812b_blit_t;
+
+/**
+ * @struct ws2812b_point_t
+ * @brief A pixel of a batch drawn by ws2812b_put_points.
+ */
+typedef struct {
+    /**
+     * @brief Column, from the left.
+     */
+    uint16_t x;
+
+    /**
+     * @brief Row, from the top.
+     */
+    uint16_t y;
+
+    /**
+     * @brief 24-bit color value.
+     */
+    uGRB32_t grb;
+} ws2812b_point_t;
+
+/**
+ * @enum ws2812b_wiring_t
+ * @brief Enumerated type for the order in which the rows of a matrix are wired.
+ */
+typedef enum {
+    WS2812B_WIRING_PROGRESSIVE = 0, // Every row runs left to right
+    WS2812B_WIRING_SERPENTINE  = 1, // Odd rows run right to left
+} ws2812b_wiring_t;
+
+/**
+ * @struct ws2812b_geometry
+ * @brief Layout of the pixels of a matrix, or of several identical matrix panels.
+ * @details Panels are chained in rows, left to right then top to bottom.
+ *          The default geometry is a single progressive panel, 8 pixels wide.
+ */
+struct ws2812b_geometry {
+    /**
+     * @brief Pixels per row of a panel, as wired.
+     */
+    uint16_t width;
+
+    /**
+     * @brief Rows of a panel, as wired.
+     */
+    uint16_t height;
+
+    /**
+     * @brief Wiring order of the rows of a panel.
+     */
+    ws2812b_wiring_t wiring;
+
+    /**
+     * @brief Rotation of the image on each panel, in clockwise quarter turns (0-3).
+     */
+    uint8_t rotation;
+
+    /**
+     * @brief Number of panels per row, 0 is the same as 1.
+     */
+    uint8_t tiles_x;
+
+    /**
+     * @brief Number of rows of panels, 0 is the same as 1.
+     */
+    uint8_t tiles_y;
+};
+
 /**
  * @struct ws2812b_config
  * @brief Configuration structure for WS2812B LED strip.
@@ -209,6 +492,11 @@ struct ws2812b_config {
      */
     bool random_seeded;
 
+    /**
+     * @brief State of the xorshift random number generator.
+     */
+    uint32_t random_state;
+
     /**
      * @brief Flag indicating whether the LED strip is inverted.
      */
@@ -223,6 +511,21 @@ struct ws2812b_config {
      * @brief Global dimming value for the LED strip.
      */
     uint8_t global_dimming;
+
+    /**
+     * @brief Width of the display in pixels, according to the geometry.
+     */
+    uint16_t width;
+
+    /**
+     * @brief Height of the display in pixels, according to the geometry.
+     */
+    uint16_t height;
+
+    /**
+     * @brief Strip index of each pixel, row by row, WS2812B_NO_PIXEL where there is none.
+     */
+    uint16_t *xy_lut;
 };
 
 /**
@@ -250,6 +553,64 @@ uGRB32_t ws2812b_hex(uint32_t hex);
  */
 uGRB32_t ws2812b_hsv(float _h, float _s, float _v);
 
+/**
+ * @brief Create a 24-bit color from integer HSV values, without floating point math.
+ * @param h Hue in degrees (0-359, larger values wrap around).
+ * @param s Saturation (0-100).
+ * @param v Value (0-100).
+ * @return 24-bit color value.
+ */
+uGRB32_t ws2812b_hsv_int(uint16_t h, uint8_t s, uint8_t v);
+
+/**
+ * @brief Convert a 24-bit color to integer HSV values.
+ * @param grb 24-bit color value.
+ * @param h Hue in degrees (0-359), 0 for grays.
+ * @param s Saturation (0-100).
+ * @param v Value (0-100).
+ */
+void ws2812b_to_hsv(uGRB32_t grb, uint16_t *h, uint8_t *s, uint8_t *v);
+
+/**
+ * @brief Interpolate between two colors.
+ * @param a 24-bit color value at t = 0.
+ * @param b 24-bit color value at t = 255.
+ * @param t Position between the two colors (0-255).
+ * @return 24-bit color value.
+ */
+uGRB32_t ws2812b_lerp(uGRB32_t a, uGRB32_t b, uint8_t t);
+
+/**
+ * @brief Scale the brightness of a color.
+ * @param grb 24-bit color value.
+ * @param scale Brightness (0-255, 255 leaves the color unchanged).
+ * @return 24-bit color value.
+ */
+uGRB32_t ws2812b_scale(uGRB32_t grb, uint8_t scale);
+
+/**
+ * @brief Build a 256-entry gradient palette from evenly spaced color stops.
+ * @param palette Destination palette.
+ * @param stops Array of 24-bit color values.
+ * @param count Number of stops (at least 2).
+ */
+void ws2812b_palette(uGRB32_t palette[256], const uGRB32_t *stops, uint8_t count);
+
+/**
+ * @brief Sample 3D value noise, in fixed point.
+ * @param x Horizontal coordinate, 8.8 fixed point (256 is one noise cell).
+ * @param y Vertical coordinate, 8.8 fixed point.
+ * @param z Depth or time coordinate, 8.8 fixed point. Keep it a multiple of 256 for 2D noise.
+ * @return Smooth noise value (0-255).
+ */
+uint8_t ws2812b_noise(uint32_t x, uint32_t y, uint32_t z);
+
+/**
+ * @brief Get a pseudo-random number from the library's xorshift generator.
+ * @return 32-bit pseudo-random number.
+ */
+uint32_t ws2812b_random();
+
 /**
  * @brief Create a random 24-bit color.
  * @param value Value (0.0-100.0).
@@ -265,11 +626,77 @@ uGRB32_t ws2812b_random_color(float value);
  */
 void ws2812b_init(PIO _pio, uint8_t gpio, uint16_t num_pixels);
 
+/**
+ * @brief Create an additional strip, with its own buffers, effects and scheduler.
+ * @param _pio PIO instance.
+ * @param gpio GPIO pin.
+ * @param num_pixels Number of pixels in the LED strip.
+ * @return Strip, NULL if out of memory.
+ */
+ws2812b_t* ws2812b_create(PIO _pio, uint8_t gpio, uint16_t num_pixels);
+
+/**
+ * @brief Select the strip used by the functions called from this core.
+ * @param strip Strip returned by ws2812b_create, NULL for the one set up by ws2812b_init.
+ * @return Previously selected strip.
+ */
+ws2812b_t* ws2812b_select(ws2812b_t *strip);
+
+/**
+ * @brief Drive the selected strip from ws2812b_tick instead of the scheduler alarm.
+ * @param manual True to call ws2812b_tick from the application, false to go back to the alarm.
+ */
+void ws2812b_set_manual_tick(bool manual);
+
 /**
  * @brief Render the LED strip.
  */
 void ws2812b_render();
 
+/**
+ * @brief Advance all running effects to a given time and render once.
+ * Called from the library scheduler alarm, or by the application after
+ * ws2812b_set_manual_tick, e.g. from a loop on the second core.
+ * @param now_us Current time in microseconds.
+ * @return Time of the next frame in microseconds, 0 if nothing is animating.
+ */
+uint64_t ws2812b_tick(uint64_t now_us);
+
+/**
+ * @brief Set the layout of the pixels, used by all drawing functions with 2D coordinates.
+ * @param geometry Matrix geometry.
+ * @return true on success, false if out of memory.
+ */
+bool ws2812b_set_geometry(const struct ws2812b_geometry *geometry);
+
+/**
+ * @brief Get the width of the display.
+ * @return Width in pixels.
+ */
+uint16_t ws2812b_width();
+
+/**
+ * @brief Get the height of the display.
+ * @return Height in pixels.
+ */
+uint16_t ws2812b_height();
+
+/**
+ * @brief Get the strip index of a pixel.
+ * @param x Column, from the left.
+ * @param y Row, from the top.
+ * @return Pixel index, WS2812B_NO_PIXEL if outside of the display.
+ */
+uint16_t ws2812b_xy(uint16_t x, uint16_t y);
+
+/**
+ * @brief Set the color of a pixel by its coordinates.
+ * @param x Column, from the left.
+ * @param y Row, from the top.
+ * @param grb 24-bit color value.
+ */
+void ws2812b_put_xy(uint16_t x, uint16_t y, uGRB32_t grb);
+
 /**
  * @brief Clear the LED strip.
  */
@@ -296,16 +723,41 @@ void ws2812b_fill(uint32_t from, uint32_t to, uGRB32_t grb);
  */
 void ws2812b_fill_all(uGRB32_t grb);
 
+/**
+ * @brief Fill a rectangle of the display, clipped to the display.
+ * @param x Left column.
+ * @param y Top row.
+ * @param w Width.
+ * @param h Height.
+ * @param grb 24-bit color value.
+ */
+void ws2812b_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uGRB32_t grb);
+
+/**
+ * @brief Set a list of pixels to the same color.
+ * @param pixels Array of pixel indices.
+ * @param count Number of pixels.
+ * @param grb 24-bit color value.
+ */
+void ws2812b_put_indexed(const uint16_t *pixels, uint16_t count, uGRB32_t grb);
+
+/**
+ * @brief Set a list of pixels by their coordinates, each with its own color.
+ * @param points Array of points.
+ * @param count Number of points.
+ */
+void ws2812b_put_points(const ws2812b_point_t *points, uint16_t count);
+
 /**
  * @brief Set the animation step time in milliseconds.
- * @param fps Frames per second.
+ * @param fps Frames per second, 0 is taken as 1. The step is at least 1 ms.
  */
 void ws2812b_config_set_fps(uint16_t fps);
 
 /**
  * @brief Set the animation step time in milliseconds for a specific effect.
  * @param FX Effect structure.
- * @param fps Frames per second.
+ * @param fps Frames per second, 0 is taken as 1. The step is at least 1 ms.
  */
 void ws2812b_set_fps(FX_t *FX, uint16_t fps);
 
@@ -329,6 +781,36 @@ void ws2812b_set_background(FX_t *FX, uGRB32_t grb);
  */
 void ws2812b_set_callback(FX_t* FX, void (*callback)(void *user_data));
 
+/**
+ * @brief Set the compositing order for a specific effect.
+ * @param FX Effect structure.
+ * @param z Layers with a higher z are drawn on top (default 0).
+ */
+void ws2812b_set_z(FX_t *FX, uint8_t z);
+
+/**
+ * @brief Set the blend mode for a specific effect.
+ * @param FX Effect structure.
+ * @param blend Blend mode (default FX_BLEND_REPLACE).
+ * @param alpha Opacity for FX_BLEND_ALPHA (0-255).
+ */
+void ws2812b_set_blend(FX_t *FX, FX_blend_t blend, uint8_t alpha);
+
+/**
+ * @brief Set the easing curve of an animation effect.
+ * @param FX Effect structure.
+ * @param ease Easing curve (default FX_EASE_LINEAR).
+ */
+void ws2812b_set_easing(FX_t *FX, FX_ease_t ease);
+
+/**
+ * @brief Replace the gradient palette of a palette-based effect.
+ * @param FX Effect structure.
+ * @param palette 256-entry palette, copied (see ws2812b_palette).
+ * @return True on success, false if out of memory.
+ */
+bool ws2812b_set_palette(FX_t *FX, const uGRB32_t palette[256]);
+
 /**
  * @brief Set the global dimming value for the LED strip.
  * @param dim Dimming value.
@@ -359,6 +841,30 @@ void ws2812b_sprite(const uGRB32_t *sprite);
  */
 void ws2812b_sprite_tint(const uGRB32_t *sprite, uGRB32_t grb);
 
+/**
+ * @brief Copy a sprite of any size to the display, clipped to the display.
+ * @param sprite Sprite data, w * h pixels row by row.
+ * @param x Column of the left edge of the sprite, may be negative.
+ * @param y Row of the top edge of the sprite, may be negative.
+ * @param w Width of the sprite.
+ * @param h Height of the sprite.
+ * @param mode Blit mode.
+ */
+void ws2812b_blit(const uGRB32_t *sprite, int16_t x, int16_t y, uint16_t w, uint16_t h, ws2812b_blit_t mode);
+
+/**
+ * @brief Copy a sprite of any size to the display, recoloring its non-black pixels.
+ * @param sprite Sprite data, w * h pixels row by row.
+ * @param x Column of the left edge of the sprite, may be negative.
+ * @param y Row of the top edge of the sprite, may be negative.
+ * @param w Width of the sprite.
+ * @param h Height of the sprite.
+ * @param grb 24-bit color value.
+ * @param mode Blit mode.
+ */
+void ws2812b_blit_tint(const uGRB32_t *sprite, int16_t x, int16_t y, uint16_t w, uint16_t h,
+                       uGRB32_t grb, ws2812b_blit_t mode);
+
 /**
  * @brief Create a spritesheet effect.
  * @param spritesheet Spritesheet data.
@@ -370,6 +876,64 @@ void ws2812b_sprite_tint(const uGRB32_t *sprite, uGRB32_t grb);
 FX_t* ws2812b_spritesheet(const uGRB32_t **spritesheet, uint8_t frames,
                     uint16_t delay, uint32_t loops);
 
+/**
+ * @brief Create a spritesheet effect from a packed spritesheet.
+ * @param sheet Packed spritesheet.
+ * @param delay Delay between frames in milliseconds.
+ * @param loops Number of loops.
+ * @return Effect structure.
+ */
+FX_t* ws2812b_spritesheet_packed(const FX_sheet_t *sheet, uint16_t delay, uint32_t loops);
+
+/**
+ * @brief Create an animation effect played from a stream, of any length and size.
+ * @param reader Stream reader.
+ * @param delay Delay between frames in milliseconds.
+ * @param loops Number of loops.
+ * @return Effect structure, NULL if the stream is not valid or out of memory.
+ */
+FX_t* ws2812b_stream(FX_reader_t *reader, uint16_t delay, uint32_t loops);
+
+/**
+ * @brief Set up a reader for a stream in memory.
+ * @param reader Stream reader.
+ * @param data Start of the stream.
+ */
+void ws2812b_reader_memory(FX_reader_t *reader, const void *data);
+
+#if PICO_ON_DEVICE
+/**
+ * @brief Set up a reader for a stream in flash, read by DMA.
+ * @param reader Stream reader.
+ * @param flash_offset Offset of the stream from the start of the flash.
+ * @return true on success, false if no DMA channel is available.
+ */
+bool ws2812b_reader_flash(FX_reader_t *reader, uint32_t flash_offset);
+#else
+/**
+ * @brief Set up a reader for a stream in a file (host builds).
+ * @param reader Stream reader.
+ * @param path Path of the file.
+ * @return true on success, false if the file can't be opened.
+ */
+bool ws2812b_reader_file(FX_reader_t *reader, const char *path);
+#endif
+
+/**
+ * @brief Release the resources of a stream reader.
+ * @param reader Stream reader.
+ */
+void ws2812b_reader_close(FX_reader_t *reader);
+
+/**
+ * @brief Show levels as a spectrum analyzer, one bar per column, until canceled.
+ * @param levels Array of levels (0-255), read on every frame.
+ * @param bands Number of levels, spread over the width of the display.
+ * @param colors Array of colors, a gradient from the bottom to the top row.
+ * @return Pointer to the effect structure.
+ */
+FX_t* ws2812b_spectrum(const volatile uint8_t *levels, uint16_t bands, const uGRB32_t colors[8]);
+
 /**
  * @brief Create an animation effect.
  * @param from Start pixel index.
@@ -378,7 +942,7 @@ FX_t* ws2812b_spritesheet(const uGRB32_t **spritesheet, uint8_t frames,
  * @param colors Array of colors.
  * @param loops Number of loops.
  * @param param Function-specific parameter.
- * @return Effect structure.
+ * @return Effect structure, NULL if out of memory.
  */
 FX_t* ws2812b_animate(uint32_t from, uint32_t to, FX_mode_t mode,
                     const uGRB32_t colors[8], uint32_t loops, uint32_t param);
@@ -441,6 +1005,10 @@ static const uGRB32_t colors_cool[8]=    {GRB_CHARTRE, GRB_SPRING, GRB_CYAN,
                                          // Colors that are not cool
 static const uGRB32_t colors_warm[8]=    {GRB_RED, GRB_ORANGE, GRB_YELLOW};
 
+                                         // Gradient for FX_FIRE
+static const uGRB32_t colors_fire[8]=    {GRB_BLACK, 0x00001000, 0x00006000, GRB_RED,
+                                          GRB_ORANGE, GRB_YELLOW, GRB_WHITE};
+
 
 #ifdef __cplusplus
 }
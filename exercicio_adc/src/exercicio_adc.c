@@ -3,14 +3,29 @@
 #include "hardware/adc.h"
 #include "ws2812b_animation.h"
 #include "utils/joystick/joystick.h"
+#include "utils/espectro/espectro.h"
+
+/*
+    Modo da matriz: 0 mostra a direção do joystick, 1 mostra o espectro do som captado pelo microfone.
+    Os dois modos usam o ADC de formas diferentes (leituras avulsas e captura contínua), por isso não rodam juntos.
+*/
+#define MODO_ESPECTRO 0
 
 int main()
 {
     stdio_init_all();
     inicializar_adc();
 
+#if MODO_ESPECTRO
+    inicializar_espectro();
+
+    while (true) {
+        tight_loop_contents(); // A captura, a FFT e o desenho rodam no DMA, no núcleo 1 e no alarme da matriz
+    }
+#else
     while (true) {
         verificar_movimento();
-        sleep_ms(100);
+        sleep_ms(1); // A matriz só é redesenhada quando a direção muda, então a leitura pode ser frequente
     }
+#endif
 }
@@ -1,105 +1,53 @@
 #include "direcao.h"
 
-void desenha_direcao_leste() {
-    ws2812b_fill(10, 10, ws2812b_random_color(100));
-    ws2812b_fill(11, 11, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(13, 13, ws2812b_random_color(100));
-    ws2812b_fill(14, 14, ws2812b_random_color(100));
-
-    ws2812b_fill(8, 8, ws2812b_random_color(100));
-    ws2812b_fill(2, 2, ws2812b_random_color(100));
-    ws2812b_fill(18, 18, ws2812b_random_color(100));
-    ws2812b_fill(22, 22, ws2812b_random_color(100));
-}
-
-void desenha_direcao_oeste() {
-    ws2812b_fill(10, 10, ws2812b_random_color(100));
-    ws2812b_fill(11, 11, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(13, 13, ws2812b_random_color(100));
-    ws2812b_fill(14, 14, ws2812b_random_color(100));
-
-    ws2812b_fill(16, 16, ws2812b_random_color(100));
-    ws2812b_fill(22, 22, ws2812b_random_color(100));
-    ws2812b_fill(6, 6, ws2812b_random_color(100));
-    ws2812b_fill(2, 2, ws2812b_random_color(100));
-}
-
-void desenha_direcao_norte() {
-    ws2812b_fill(2, 2, ws2812b_random_color(100));
-    ws2812b_fill(7, 7, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(17, 17, ws2812b_random_color(100));
-    ws2812b_fill(22, 22, ws2812b_random_color(100));
-
-    ws2812b_fill(16, 16, ws2812b_random_color(100));
-    ws2812b_fill(18, 18, ws2812b_random_color(100));
-    ws2812b_fill(10, 10, ws2812b_random_color(100));
-    ws2812b_fill(14, 14, ws2812b_random_color(100));
-}
-
-void desenha_direcao_sul() {
-    ws2812b_fill(2, 2, ws2812b_random_color(100));
-    ws2812b_fill(7, 7, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(17, 17, ws2812b_random_color(100));
-    ws2812b_fill(22, 22, ws2812b_random_color(100));
-
-    ws2812b_fill(10, 10, ws2812b_random_color(100));
-    ws2812b_fill(14, 14, ws2812b_random_color(100));
-    ws2812b_fill(6, 6, ws2812b_random_color(100));
-    ws2812b_fill(8, 8, ws2812b_random_color(100));
+#define MATRIZ_LADO 5 // A matriz da BitDogLab tem 5x5 LEDs
+
+/*
+    Setas de cada direção, na ordem de direcao_t. O bit (y * 5 + x) acende o LED da coluna x e da linha y,
+    com a origem no canto superior esquerdo da matriz. A conversão para o índice do LED é feita pela biblioteca,
+    conforme a geometria definida em inicializar_adc().
+*/
+static const uint32_t setas[] = {
+    [DIRECAO_LESTE]    = 0x0447d04, // ..#.. / ...#. / ##### / ...#. / ..#..
+    [DIRECAO_NORDESTE] = 0x011531c, // ..### / ...## / ..#.# / .#... / #....
+    [DIRECAO_NORTE]    = 0x04255c4, // ..#.. / .###. / #.#.# / ..#.. / ..#..
+    [DIRECAO_NOROESTE] = 0x1041467, // ###.. / ##... / #.#.. / ...#. / ....#
+    [DIRECAO_OESTE]    = 0x0417c44, // ..#.. / .#... / ##### / .#... / ..#..
+    [DIRECAO_SUDOESTE] = 0x0719510, // ....# / ...#. / #.#.. / ##... / ###..
+    [DIRECAO_SUL]      = 0x0475484, // ..#.. / ..#.. / #.#.# / .###. / ..#..
+    [DIRECAO_SUDESTE]  = 0x1cc5041, // #.... / .#... / ..#.# / ...## / ..###
+    [DIRECAO_CENTRO]   = 0x0000000  // Matriz apagada
+};
+
+/*
+    Função para converter o deslocamento do joystick em relação ao centro em uma das 8 direções
+    Equivale a arredondar atan2(dy, dx) para o múltiplo de 45 graus mais próximo, só com inteiros:
+    o deslocamento é horizontal se |dy| < |dx| * tan(22,5°) e vertical se |dx| < |dy| * tan(22,5°),
+    caso contrário é diagonal. tan(22,5°) é aproximada por 106/256.
+    dy positivo aponta para o norte. Dentro da zona morta (nos dois eixos) a direção é DIRECAO_CENTRO.
+*/
+direcao_t calcular_direcao(int16_t dx, int16_t dy, int16_t zona_morta) {
+    int32_t ax = (dx < 0) ? -dx : dx;
+    int32_t ay = (dy < 0) ? -dy : dy;
+
+    if (ax <= zona_morta && ay <= zona_morta) return DIRECAO_CENTRO;
+
+    if (ay * 256 < ax * 106) return (dx > 0) ? DIRECAO_LESTE : DIRECAO_OESTE;
+    if (ax * 256 < ay * 106) return (dy > 0) ? DIRECAO_NORTE : DIRECAO_SUL;
+    if (dx > 0) return (dy > 0) ? DIRECAO_NORDESTE : DIRECAO_SUDESTE;
+    return (dy > 0) ? DIRECAO_NOROESTE : DIRECAO_SUDOESTE;
 }
 
-void desenha_direcao_noroeste() {
-    ws2812b_fill(0, 0, ws2812b_random_color(100));
-    ws2812b_fill(8, 8, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(16, 16, ws2812b_random_color(100));
-    ws2812b_fill(24, 24, ws2812b_random_color(100));
-
-    ws2812b_fill(15, 15, ws2812b_random_color(100));
-    ws2812b_fill(14, 14, ws2812b_random_color(100));
-    ws2812b_fill(23, 23, ws2812b_random_color(100));
-    ws2812b_fill(22, 22, ws2812b_random_color(100));
-}
-
-void desenha_direcao_sudeste() {
-    ws2812b_fill(0, 0, ws2812b_random_color(100));
-    ws2812b_fill(8, 8, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(16, 16, ws2812b_random_color(100));
-    ws2812b_fill(24, 24, ws2812b_random_color(100));
-
-    ws2812b_fill(9, 9, ws2812b_random_color(100));
-    ws2812b_fill(10, 10, ws2812b_random_color(100));
-    ws2812b_fill(1, 1, ws2812b_random_color(100));
-    ws2812b_fill(2, 2, ws2812b_random_color(100));
+/*
+    Função para desenhar a seta de uma direção, cada ponto com uma cor aleatória
+    A matriz inteira é montada em um sprite (LEDs fora da seta ficam apagados) e enviada em uma única cópia.
+*/
+void desenha_direcao(direcao_t direcao) {
+    uGRB32_t sprite[MATRIZ_LADO * MATRIZ_LADO];
+    uint32_t seta = setas[direcao];
+
+    for (uint8_t i = 0; i < MATRIZ_LADO * MATRIZ_LADO; i++) {
+        sprite[i] = ((seta >> i) & 1) ? ws2812b_random_color(100) : GRB_BLACK;
+    }
+    ws2812b_blit(sprite, 0, 0, MATRIZ_LADO, MATRIZ_LADO, WS2812B_BLIT_OPAQUE);
 }
-
-void desenha_direcao_nordeste() {
-    ws2812b_fill(4, 4, ws2812b_random_color(100));
-    ws2812b_fill(6, 6, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(18, 18, ws2812b_random_color(100));
-    ws2812b_fill(20, 20, ws2812b_random_color(100));
-    
-    ws2812b_fill(22, 22, ws2812b_random_color(100));
-    ws2812b_fill(21, 21, ws2812b_random_color(100));
-    ws2812b_fill(19, 19, ws2812b_random_color(100));
-    ws2812b_fill(10, 10, ws2812b_random_color(100));
-}
-
-void desenha_direcao_sudoeste() {
-    ws2812b_fill(4, 4, ws2812b_random_color(100));
-    ws2812b_fill(6, 6, ws2812b_random_color(100));
-    ws2812b_fill(12, 12, ws2812b_random_color(100));
-    ws2812b_fill(18, 18, ws2812b_random_color(100));
-    ws2812b_fill(20, 20, ws2812b_random_color(100));
-
-    ws2812b_fill(2, 2, ws2812b_random_color(100));
-    ws2812b_fill(3, 3, ws2812b_random_color(100));
-    ws2812b_fill(5, 5, ws2812b_random_color(100));
-    ws2812b_fill(14, 14, ws2812b_random_color(100));
-}
\ No newline at end of file
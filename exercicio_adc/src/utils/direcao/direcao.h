@@ -1,10 +1,20 @@
 #include "ws2812b_animation.h"
 
-void desenha_direcao_leste();      // Função para desenhar uma seta para direcao leste
-void desenha_direcao_oeste();      // Função para desenhar uma seta para direcao oeste
-void desenha_direcao_norte();      // Função para desenhar uma seta para direcao norte
-void desenha_direcao_sul();        // Função para desenhar uma seta para direcao sul
-void desenha_direcao_noroeste();   // Função para desenhar uma seta para direcao noroeste
-void desenha_direcao_sudeste();    // Função para desenhar uma seta para direcao sudeste
-void desenha_direcao_nordeste();   // Função para desenhar uma seta para direcao nordeste
-void desenha_direcao_sudoeste();   // Função para desenhar uma seta para direcao sudoeste
\ No newline at end of file
+/*
+    Direções do joystick, em sentido anti-horário a partir do leste, como os octantes do plano.
+    DIRECAO_CENTRO indica o joystick solto (dentro da zona morta).
+*/
+typedef enum {
+    DIRECAO_LESTE = 0,
+    DIRECAO_NORDESTE,
+    DIRECAO_NORTE,
+    DIRECAO_NOROESTE,
+    DIRECAO_OESTE,
+    DIRECAO_SUDOESTE,
+    DIRECAO_SUL,
+    DIRECAO_SUDESTE,
+    DIRECAO_CENTRO
+} direcao_t;
+
+direcao_t calcular_direcao(int16_t dx, int16_t dy, int16_t zona_morta); // Função para converter o deslocamento do joystick em uma direção
+void desenha_direcao(direcao_t direcao);                                 // Função para desenhar a seta de uma direção na matriz
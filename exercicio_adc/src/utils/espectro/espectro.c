@@ -0,0 +1,137 @@
+#include <math.h>
+#include "espectro.h"
+
+/*
+    Analisador de espectro do microfone, em três etapas que rodam ao mesmo tempo:
+    - o DMA enche um bloco de amostras do ADC enquanto o outro bloco é processado (ping-pong);
+    - o núcleo 1 calcula a FFT do bloco cheio e atualiza os níveis das bandas;
+    - a biblioteca da matriz desenha os níveis a 60 quadros por segundo, no alarme do núcleo 0.
+    O atraso entre o som e a matriz fica limitado a um bloco (12,8 ms), mais a FFT e um quadro.
+*/
+
+static uint16_t amostras[2][ESPECTRO_AMOSTRAS]; // Blocos do ping-pong, escritos pelo DMA
+static int canais_dma[2];
+static int16_t janela[ESPECTRO_AMOSTRAS];       // Janela de Hann em Q15
+static uint8_t limites[ESPECTRO_BANDAS + 1];    // Primeiro índice da FFT de cada banda
+static volatile uint8_t niveis[ESPECTRO_BANDAS]; // Lidos pela biblioteca a cada quadro
+
+/*
+    Função para configurar os dois canais de DMA que se revezam lendo o FIFO do ADC
+    Cada canal, ao terminar o seu bloco, dispara o outro, então a captura nunca para.
+*/
+static void configurar_dma() {
+    for (int i = 0; i < 2; i++) {
+        canais_dma[i] = dma_claim_unused_channel(true);
+    }
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config config = dma_channel_get_default_config(canais_dma[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, DREQ_ADC);
+        channel_config_set_chain_to(&config, canais_dma[1 - i]);
+        dma_channel_configure(canais_dma[i], &config, amostras[i], &adc_hw->fifo, ESPECTRO_AMOSTRAS, false);
+    }
+}
+
+/*
+    Função para calcular a tabela da janela e os limites das bandas
+    As bandas são espaçadas em escala logarítmica, como o ouvido percebe, entre o índice 1
+    (78 Hz) e a metade da FFT (10 kHz). Cada banda tem pelo menos um índice.
+*/
+static void calcular_tabelas() {
+    for (int i = 0; i < ESPECTRO_AMOSTRAS; i++) {
+        janela[i] = (int16_t)lroundf(32767.0f * 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / (ESPECTRO_AMOSTRAS - 1))));
+    }
+    limites[0] = 1;
+    for (int b = 1; b <= ESPECTRO_BANDAS; b++) {
+        int limite = (int)lroundf(powf(ESPECTRO_AMOSTRAS / 2, (float)b / ESPECTRO_BANDAS));
+        if (limite <= limites[b - 1]) {
+            limite = limites[b - 1] + 1;
+        }
+        limites[b] = limite;
+    }
+}
+
+/*
+    Função para calcular o logaritmo de base 2 em 1/16 de unidade, só com inteiros
+*/
+static uint32_t log2_16(uint32_t valor) {
+    if (valor == 0) {
+        return 0;
+    }
+    uint32_t inteiro = 31 - __builtin_clz(valor);
+    uint32_t fracao = (inteiro >= 4) ? (valor >> (inteiro - 4)) & 0xf : (valor << (4 - inteiro)) & 0xf;
+    return inteiro * 16 + fracao;
+}
+
+/*
+    Função para processar um bloco de amostras: tira o nível médio, aplica a janela,
+    calcula a FFT e converte a energia de cada banda em um nível de 0 a 255
+*/
+static void processar_bloco(const uint16_t *bloco) {
+    static int16_t real[ESPECTRO_AMOSTRAS];
+    static int16_t imag[ESPECTRO_AMOSTRAS];
+
+    uint32_t soma = 0;
+    for (int i = 0; i < ESPECTRO_AMOSTRAS; i++) {
+        soma += bloco[i];
+    }
+    int32_t media = soma / ESPECTRO_AMOSTRAS;
+    for (int i = 0; i < ESPECTRO_AMOSTRAS; i++) {
+        int32_t amostra = ((int32_t)bloco[i] - media) << 3; // 12 bits com sinal para Q15
+        real[i] = (int16_t)((amostra * janela[i]) >> 15);
+        imag[i] = 0;
+    }
+
+    fft_q15(real, imag, ESPECTRO_LOG2_AMOSTRAS);
+
+    for (int b = 0; b < ESPECTRO_BANDAS; b++) {
+        uint32_t energia = 0;
+        for (int k = limites[b]; k < limites[b + 1]; k++) {
+            energia += (uint32_t)(real[k] * real[k]) + (uint32_t)(imag[k] * imag[k]);
+        }
+        int32_t nivel = ((int32_t)log2_16(energia) - ESPECTRO_PISO) * 255 / ESPECTRO_FAIXA;
+        if (nivel < 0) nivel = 0;
+        if (nivel > 255) nivel = 255;
+
+        // Sobe na hora, desce devagar
+        int32_t anterior = niveis[b] - ESPECTRO_QUEDA;
+        niveis[b] = (nivel > anterior) ? nivel : (anterior > 0 ? anterior : 0);
+    }
+}
+
+/*
+    Função executada no núcleo 1: espera cada bloco do ping-pong terminar e o processa
+    enquanto o DMA enche o outro bloco. O canal que terminou volta para o início do seu bloco
+    antes de ser disparado de novo, o que acontece só quando o outro bloco estiver cheio.
+*/
+static void nucleo1_espectro() {
+    int atual = 0;
+    while (true) {
+        dma_channel_wait_for_finish_blocking(canais_dma[atual]);
+        dma_channel_set_write_addr(canais_dma[atual], amostras[atual], false);
+        processar_bloco(amostras[atual]);
+        atual = 1 - atual;
+    }
+}
+
+void inicializar_espectro() {
+    calcular_tabelas();
+    fft_inicializar();
+
+    adc_gpio_init(ESPECTRO_MICROFONE);
+    adc_select_input(ESPECTRO_CANAL_ADC);
+    adc_fifo_setup(true, true, 1, false, false); // FIFO com pedidos de DMA a cada amostra, 12 bits
+    adc_set_clkdiv(48000000 / ESPECTRO_FREQUENCIA - 1); // O ADC roda a 48 MHz
+
+    configurar_dma();
+    dma_channel_start(canais_dma[0]);
+    adc_run(true);
+
+    multicore_launch_core1(nucleo1_espectro);
+
+    ws2812b_config_set_fps(60);
+    static const uGRB32_t cores[8] = {GRB_GREEN, GRB_YELLOW, GRB_RED}; // Do pé ao topo da coluna
+    ws2812b_spectrum(niveis, ESPECTRO_BANDAS, cores);
+}
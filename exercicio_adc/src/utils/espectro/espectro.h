@@ -0,0 +1,24 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "ws2812b_animation.h"
+#include "utils/fft/fft.h"
+
+#define ESPECTRO_MICROFONE 28        // Pino do microfone da BitDogLab
+#define ESPECTRO_CANAL_ADC 2         // Canal do ADC ligado ao pino 28
+#define ESPECTRO_FREQUENCIA 20000    // Frequência de amostragem em Hz
+#define ESPECTRO_LOG2_AMOSTRAS 8     // Tamanho da FFT: 2^8 = 256 amostras, 12,8 ms por bloco a 20 kHz
+#define ESPECTRO_AMOSTRAS (1 << ESPECTRO_LOG2_AMOSTRAS)
+#define ESPECTRO_BANDAS 5            // Uma banda por coluna da matriz
+
+/*
+    Ajuste da escala das barras, em 1/16 de oitava de energia (cerca de 3 dB por oitava):
+    energias abaixo do piso não acendem nada, e a faixa é o quanto acima do piso enche a coluna.
+*/
+#define ESPECTRO_PISO (4 * 16)
+#define ESPECTRO_FAIXA (14 * 16)
+#define ESPECTRO_QUEDA 12            // Quanto cada barra desce por bloco, para não piscar
+
+void inicializar_espectro(); // Função para iniciar a captura do microfone e o analisador de espectro
@@ -0,0 +1,60 @@
+#include <math.h>
+#include "fft.h"
+
+/*
+    Tabelas de cosseno e seno em ponto fixo Q15 (32767 = 1.0), de 0 até meia volta.
+    São calculadas uma única vez em fft_inicializar(), o cálculo da FFT em si só usa inteiros.
+*/
+static int16_t tabela_cos[FFT_TAMANHO_MAX / 2];
+static int16_t tabela_sen[FFT_TAMANHO_MAX / 2];
+
+void fft_inicializar() {
+    for (uint16_t i = 0; i < FFT_TAMANHO_MAX / 2; i++) {
+        float angulo = 2.0f * (float)M_PI * i / FFT_TAMANHO_MAX;
+        tabela_cos[i] = (int16_t)lroundf(cosf(angulo) * 32767.0f);
+        tabela_sen[i] = (int16_t)lroundf(sinf(angulo) * 32767.0f);
+    }
+}
+
+/*
+    Função para calcular a FFT radix-2 (decimação no tempo) de um vetor de amostras em ponto fixo Q15
+    O resultado substitui a entrada. Cada estágio divide o resultado por 2 para não estourar os 16 bits,
+    então a saída é a transformada dividida pelo tamanho: X[k] / N.
+    O tamanho é 2 elevado a log2_tamanho, no máximo FFT_TAMANHO_MAX.
+*/
+void fft_q15(int16_t *real, int16_t *imag, uint8_t log2_tamanho) {
+    uint16_t tamanho = 1u << log2_tamanho;
+
+    // Reordena as amostras pelo índice com os bits invertidos
+    for (uint16_t i = 1, j = 0; i < tamanho; i++) {
+        uint16_t bit = tamanho >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            int16_t temp = real[i]; real[i] = real[j]; real[j] = temp;
+            temp = imag[i]; imag[i] = imag[j]; imag[j] = temp;
+        }
+    }
+
+    // Borboletas, do bloco de 2 amostras até o vetor inteiro
+    for (uint16_t bloco = 2; bloco <= tamanho; bloco <<= 1) {
+        uint16_t metade = bloco >> 1;
+        uint16_t passo = FFT_TAMANHO_MAX / bloco; // Passo na tabela de senos
+        for (uint16_t inicio = 0; inicio < tamanho; inicio += bloco) {
+            for (uint16_t j = 0; j < metade; j++) {
+                int32_t wr = tabela_cos[j * passo];
+                int32_t wi = -tabela_sen[j * passo];
+                uint16_t a = inicio + j;
+                uint16_t b = a + metade;
+                int32_t tr = (wr * real[b] - wi * imag[b]) >> 15;
+                int32_t ti = (wr * imag[b] + wi * real[b]) >> 15;
+                real[b] = (int16_t)((real[a] - tr) >> 1);
+                imag[b] = (int16_t)((imag[a] - ti) >> 1);
+                real[a] = (int16_t)((real[a] + tr) >> 1);
+                imag[a] = (int16_t)((imag[a] + ti) >> 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,6 @@
+#include <stdint.h>
+
+#define FFT_TAMANHO_MAX 256 // Maior FFT suportada, define o tamanho das tabelas de senos
+
+void fft_inicializar();                                        // Função para calcular a tabela de senos e cossenos
+void fft_q15(int16_t *real, int16_t *imag, uint8_t log2_tamanho); // Função para calcular a FFT em ponto fixo, no próprio vetor
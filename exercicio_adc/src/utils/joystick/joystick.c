@@ -1,65 +1,46 @@
 #include "joystick.h"
 
-/*
-    Função para ler o valor do eixo X do joystick
-    A função seleciona o canal ADC correspondente ao eixo X e lê o valor, retornando-o como uma porcentagem (0 a 100).
-    O valor lido é dividido por 4095 (valor máximo do ADC) e multiplicado por 100 para obter a porcentagem.
-*/
-uint8_t leitura_joystick_x() {
-    adc_select_input(1);
-
-    return adc_read() * 100 / 4095;
-}
-/*
-    Função para ler o valor do eixo Y do joystick
-    A função seleciona o canal ADC correspondente ao eixo Y e lê o valor, retornando-o como uma porcentagem (0 a 100).
-    O valor lido é dividido por 4095 (valor máximo do ADC) e multiplicado por 100 para obter a porcentagem.
-*/
-uint8_t leitura_joystick_y() {
-    adc_select_input(0);
-
-    return adc_read() * 100 / 4095;
-}
+static joystick_t joystick; // Estado do filtro e da calibração do joystick
 
 /* 
     Função para verificar o movimento do joystick e desenhar a seta correspondente
-    A função lê os valores dos eixos X e Y do joystick e verifica se eles estão acima ou abaixo dos limites definidos.
-    Dependendo da direção do movimento, a função chama a função correspondente para desenhar a seta na tela.
+    A função lê os eixos X e Y já filtrados e calibrados (-50 a 50, 0 dentro da zona morta)
+    e converte o deslocamento em relação ao centro em uma das 8 direções.
+    A matriz só é redesenhada quando a direção muda, ou a cada JOYSTICK_REDESENHO_MS para trocar as cores da seta,
+    por isso a função pode ser chamada a cada milissegundo sem sobrecarregar a matriz.
     Se o joystick não estiver sendo pressionado, a tela é preenchida com a cor preta (apagada).
 */
 void verificar_movimento() {
-    uint8_t valor_x = leitura_joystick_x();
-    uint8_t valor_y = leitura_joystick_y();
+    static direcao_t direcao_anterior = DIRECAO_CENTRO;
+    static uint64_t ultimo_desenho_us = 0;
 
-    ws2812b_fill_all(GRB_BLACK);
+    int16_t dx, dy;
+    joystick_ler(&joystick, &dx, &dy);
+    direcao_t direcao = calcular_direcao(dx, dy, 0); // A zona morta já foi aplicada na leitura
 
-    if (valor_x > JOYSTICK_LIMITE_SUPERIOR && valor_y > JOYSTICK_LIMITE_SUPERIOR) {
-        desenha_direcao_nordeste();
-    } else if (valor_x > JOYSTICK_LIMITE_SUPERIOR && valor_y < JOYSTICK_LIMITE_INFERIOR) {
-        desenha_direcao_sudeste();
-    } else if (valor_x < JOYSTICK_LIMITE_INFERIOR && valor_y > JOYSTICK_LIMITE_SUPERIOR) {
-        desenha_direcao_noroeste();
-    } else if (valor_x < JOYSTICK_LIMITE_INFERIOR && valor_y < JOYSTICK_LIMITE_INFERIOR) {
-        desenha_direcao_sudoeste();
-    } else if (valor_x > JOYSTICK_LIMITE_SUPERIOR) {
-        desenha_direcao_leste();
-    } else if (valor_x < JOYSTICK_LIMITE_INFERIOR) {
-        desenha_direcao_oeste();
-    } else if (valor_y > JOYSTICK_LIMITE_SUPERIOR) {
-        desenha_direcao_norte();
-    } else if (valor_y < JOYSTICK_LIMITE_INFERIOR) {
-        desenha_direcao_sul();
-    } else {
-        ws2812b_fill_all(GRB_BLACK);
+    uint64_t agora_us = time_us_64();
+    if (direcao == direcao_anterior && agora_us - ultimo_desenho_us < JOYSTICK_REDESENHO_MS * 1000ull) {
+        return;
     }
+    direcao_anterior = direcao;
+    ultimo_desenho_us = agora_us;
+
+    desenha_direcao(direcao);
     ws2812b_render();
 }
 
 void inicializar_adc() {
-    adc_init();
-    adc_gpio_init(JOYSTICK_VRX);
-    adc_gpio_init(JOYSTICK_VRY);
+    joystick_config_t config = JOYSTICK_CONFIG_PADRAO;
+    config.zona_morta = JOYSTICK_ZONA_MORTA;
+    config.histerese = JOYSTICK_HISTERESE;
+    config.resolucao = 50;
+    joystick_iniciar_adc(&joystick, JOYSTICK_VRX, JOYSTICK_VRY, &config); // O joystick deve estar solto aqui
 
     ws2812b_init(pio0, 7, 25);
+    // Matriz 5x5 da BitDogLab: ligada em serpentina a partir do canto inferior direito,
+    // o que equivale a uma matriz serpentina comum girada em 180 graus
+    ws2812b_set_geometry(&(struct ws2812b_geometry){
+        .width = 5, .height = 5, .wiring = WS2812B_WIRING_SERPENTINE, .rotation = 2
+    });
     ws2812b_set_global_dimming(5);
 }
\ No newline at end of file
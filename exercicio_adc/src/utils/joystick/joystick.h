@@ -2,20 +2,19 @@
 #include "pico/stdlib.h"
 #include "hardware/adc.h"
 #include "ws2812b_animation.h"
+#include "entrada_joystick.h"
 #include "utils/direcao/direcao.h"
 
 #define JOYSTICK_VRX 27 // Valor do pino do joystick X
 #define JOYSTICK_VRY 26 // Valor do pino do joystick Y
 
 /*
-    Coloquei os valores agora como limites superior e inferior, para que utilize as leituras para todas as direções
-    e não apenas para os limites de cada direção, como estava antes.
-    Assim, o joystick pode ser utilizado para fazer movimentos diagonais, como noroeste e sudeste.
+    Raio da zona morta em torno do centro calibrado, em unidades do ADC: 30% da faixa de 4096 (60% do curso
+    de 2048 de cada lado), como os antigos limites de 20% e 80%. Fora dela, o deslocamento é convertido em uma das 8 direções pelo ângulo.
 */
-#define JOYSTICK_LIMITE_SUPERIOR 80 
-#define JOYSTICK_LIMITE_INFERIOR 20
+#define JOYSTICK_ZONA_MORTA 1228
+#define JOYSTICK_HISTERESE 100 // Margem na borda da zona morta, para a seta não piscar
+#define JOYSTICK_REDESENHO_MS 100 // Intervalo para sortear novas cores para a seta, mesmo parada
 
-uint8_t leitura_joystick_x(); 
-uint8_t leitura_joystick_y(); 
 void verificar_movimento(); 
 void inicializar_adc(); 
\ No newline at end of file
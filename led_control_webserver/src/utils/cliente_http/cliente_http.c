@@ -45,8 +45,8 @@ static err_t callback_conectado(void *arg, struct tcp_pcb *pcb, err_t err) {
     tcp_recv(pcb, callback_resposta_recebida);
 
     // Coletar dados
-    uint8_t x = ler_joystick_x();
-    uint8_t y = ler_joystick_y();
+    uint8_t x, y;
+    ler_joystick(&x, &y);
     bool botao_a = botao_a_pressionado();
     bool botao_b = botao_b_pressionado();
 
@@ -1,5 +1,22 @@
 #include "sensores.h"
 
+#define PERIODO_JOYSTICK_MS 10 // Amostragem a 100 Hz, com ou sem requisições
+
+static joystick_t joystick;            // Estado do filtro e da calibração do joystick
+static repeating_timer_t timer_joystick; // Amostra o joystick em intervalos regulares
+
+// Última leitura filtrada, X no byte alto e Y no baixo: uma só escrita de 16 bits,
+// então quem lê recebe sempre os dois eixos da mesma amostra
+static volatile uint16_t ultima_leitura = (50 << 8) | 50;
+
+// Chamada pelo timer: lê e filtra uma amostra dos dois eixos
+static bool amostrar_joystick(repeating_timer_t *timer) {
+    int16_t dx, dy;
+    joystick_ler(&joystick, &dx, &dy); // Uma leitura filtrada dos dois eixos, com a zona morta aplicada
+    ultima_leitura = ((uint16_t)(50 + dx) << 8) | (uint8_t)(50 + dy); // Escala 0-100, com 50 no centro calibrado
+    return true;                       // Continua repetindo
+}
+
 void inicializar_sensores() {
     // Configura os pinos dos botões como entrada com pull-up
     gpio_init(BUTTON_A_PIN);
@@ -10,24 +27,20 @@ void inicializar_sensores() {
     gpio_set_dir(BUTTON_B_PIN, GPIO_IN);
     gpio_pull_up(BUTTON_B_PIN);
 
-    // Inicializa o ADC
-    adc_init();
-    adc_gpio_init(JOYSTICK_X_PIN); // Inicializa o pino do eixo X do joystick
-    adc_gpio_init(JOYSTICK_Y_PIN); // Inicializa o pino do eixo Y do joystick
-}
+    // Inicializa o ADC e calibra o centro do joystick (que deve estar solto)
+    joystick_config_t config = JOYSTICK_CONFIG_PADRAO;
+    config.resolucao = 50; // Saída de -50 a 50, somada ao centro 50 para manter a escala 0-100
+    joystick_iniciar_adc(&joystick, JOYSTICK_X_PIN, JOYSTICK_Y_PIN, &config);
 
-uint8_t ler_joystick_x() {
-    adc_select_input(1);                             // Canal ADC 1 é o GPIO 27
-    uint16_t raw_value = adc_read();                 // Lê o valor bruto do ADC
-    uint8_t scaled_value = (raw_value * 100) / 4095; // Escala para 0-100
-    return scaled_value;
+    // O filtro depende de amostras regulares, e não do ritmo das requisições HTTP
+    amostrar_joystick(&timer_joystick);
+    add_repeating_timer_ms(PERIODO_JOYSTICK_MS, amostrar_joystick, NULL, &timer_joystick);
 }
 
-uint8_t ler_joystick_y() {
-    adc_select_input(0);                             // Canal ADC 0 é o GPIO 26
-    uint16_t raw_value = adc_read();                 // Lê o valor bruto do ADC
-    uint8_t scaled_value = (raw_value * 100) / 4095; // Escala para 0-100
-    return scaled_value;
+void ler_joystick(uint8_t *x, uint8_t *y) {
+    uint16_t leitura = ultima_leitura; // Última amostra filtrada pelo timer
+    *x = leitura >> 8;
+    *y = leitura & 0xFF;
 }
 
 bool botao_a_pressionado() {
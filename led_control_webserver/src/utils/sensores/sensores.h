@@ -3,6 +3,7 @@
 
 #include "pico/stdlib.h"
 #include "hardware/adc.h"
+#include "entrada_joystick.h"
 
 // --- Definições de Pinos ---
 #define BUTTON_A_PIN 5    // Pino GPIO 5 será o Botão A
@@ -12,8 +13,7 @@
 
 // --- Funções para inicializar e ler sensores ---
 void inicializar_sensores();
-uint8_t ler_joystick_x();
-uint8_t ler_joystick_y();
+void ler_joystick(uint8_t *x, uint8_t *y); // Última amostra do timer, os dois eixos de 0 a 100
 bool botao_a_pressionado();
 bool botao_b_pressionado();
 
@@ -308,6 +308,8 @@ err_t dados_recebidos_cliente(void *arg_estado_conexao, struct tcp_pcb *cliente_
     else if (strstr(requisicao, "GET /joystick") != NULL)
     {
         printf("Rota /joystick\n");
+        uint8_t x, y;
+        ler_joystick(&x, &y);
         char resposta[256];
         snprintf(resposta, sizeof(resposta),
                  "HTTP/1.1 200 OK\r\n"
@@ -315,7 +317,7 @@ err_t dados_recebidos_cliente(void *arg_estado_conexao, struct tcp_pcb *cliente_
                  "Connection: close\r\n"
                  "\r\n"
                  "{\"joystick_x\": %u, \"joystick_y\": %u}",
-                 ler_joystick_x(), ler_joystick_y());
+                 x, y);
 
         cyw43_arch_lwip_begin();
         err_t erro_entrega_resposta = tcp_write(cliente_pcb, resposta, strlen(resposta), TCP_WRITE_FLAG_COPY);
@@ -0,0 +1,128 @@
+#include "entrada_joystick.h"
+
+#define ALFA_UM 65536                // 1,0 em Q16, escala dos coeficientes do filtro
+#define DOIS_PI_Q16_POR_BILHAO 411775 // 2π * 65536, para frequências em mHz e períodos em µs (10^9 no total)
+#define CORTE_DERIVADA_MHZ 1000      // Corte fixo do filtro da velocidade, 1 Hz como no artigo do one-euro
+#define PERIODO_MAX_US 1000000       // Amostras mais espaçadas que isso não são filtradas
+
+/*
+    Função para calcular o coeficiente de um filtro passa-baixa de primeira ordem (Q16)
+    alfa = w / (1 + w), com w = 2π * corte * periodo. Períodos longos levam alfa para perto de 1 (sem filtro).
+*/
+static uint32_t calcular_alfa(uint32_t corte_mhz, uint32_t periodo_us) {
+    uint64_t w = (uint64_t)corte_mhz * periodo_us * DOIS_PI_Q16_POR_BILHAO / 1000000000u;
+    return (uint32_t)((w << 16) / (ALFA_UM + w));
+}
+
+/*
+    Função para filtrar a amostra de um eixo com o filtro one-euro, em ponto fixo
+    A velocidade é estimada a partir do valor filtrado anterior e suavizada com corte fixo;
+    quanto maior a velocidade, maior o corte do filtro do valor, então o joystick parado fica estável
+    e um movimento rápido chega sem atraso perceptível.
+    Retorna o valor filtrado em unidades do ADC.
+*/
+static int32_t filtrar(joystick_filtro_t *filtro, const joystick_config_t *config,
+                       uint16_t bruto, uint32_t periodo_us, bool primeira) {
+    int32_t entrada = (int32_t)bruto << 8;
+
+    if (primeira || !config->corte_min_mhz || periodo_us >= PERIODO_MAX_US) {
+        filtro->valor = entrada;
+        filtro->derivada = 0;
+        return bruto;
+    }
+
+    int32_t velocidade = (int32_t)((int64_t)(entrada - filtro->valor) * 1000000 / ((int64_t)periodo_us << 8));
+    filtro->derivada += (int32_t)(((int64_t)(velocidade - filtro->derivada) *
+                                   calcular_alfa(CORTE_DERIVADA_MHZ, periodo_us)) >> 16);
+
+    uint32_t rapidez = (filtro->derivada < 0) ? -filtro->derivada : filtro->derivada;
+    uint32_t corte_mhz = config->corte_min_mhz + (uint32_t)((uint64_t)config->beta_uhz * rapidez / 1000u);
+    filtro->valor += (int32_t)(((int64_t)(entrada - filtro->valor) * calcular_alfa(corte_mhz, periodo_us)) >> 16);
+
+    return (filtro->valor + 128) >> 8;
+}
+
+/*
+    Função para calcular a raiz quadrada inteira (arredondada para baixo), bit a bit
+*/
+static uint32_t raiz_inteira(uint32_t n) {
+    uint32_t raiz = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > n) bit >>= 2;
+    while (bit) {
+        if (n >= raiz + bit) {
+            n -= raiz + bit;
+            raiz = (raiz >> 1) + bit;
+        } else {
+            raiz >>= 1;
+        }
+        bit >>= 2;
+    }
+    return raiz;
+}
+
+/*
+    Função para levar o deslocamento de um eixo para a resolução de saída
+    O curso é a distância do centro até o fim do eixo nesse sentido, então um centro fora do meio
+    ainda chega ao valor máximo nos dois sentidos.
+*/
+static int16_t escalar(int32_t deslocamento, int32_t curso, const joystick_config_t *config) {
+    int32_t util = curso - config->zona_morta;
+    if (util < 1) util = 1;
+
+    int32_t saida = deslocamento * config->resolucao / util;
+    if (saida > config->resolucao) saida = config->resolucao;
+    if (saida < -config->resolucao) saida = -config->resolucao;
+    return (int16_t)saida;
+}
+
+void joystick_configurar(joystick_t *js, const joystick_config_t *config) {
+    js->config = *config;
+    js->centro_x = JOYSTICK_ADC_MAX / 2;
+    js->centro_y = JOYSTICK_ADC_MAX / 2;
+    js->iniciado = false;
+    js->ativo = false;
+}
+
+void joystick_calibrar(joystick_t *js, uint16_t centro_x, uint16_t centro_y) {
+    js->centro_x = centro_x;
+    js->centro_y = centro_y;
+    js->iniciado = false; // O filtro recomeça da próxima amostra
+    js->ativo = false;
+}
+
+/*
+    Função para processar uma amostra bruta do ADC
+    A zona morta é radial (um círculo em torno do centro), então as diagonais não têm uma zona maior
+    que os eixos. Para sair dela o joystick precisa passar de zona_morta + histerese, e para voltar,
+    ficar abaixo de zona_morta - histerese. Fora dela, a saída começa em 0 na borda da zona morta.
+*/
+void joystick_processar(joystick_t *js, uint16_t bruto_x, uint16_t bruto_y, uint64_t agora_us,
+                        int16_t *x, int16_t *y) {
+    const joystick_config_t *config = &js->config;
+    bool primeira = !js->iniciado;
+    uint64_t periodo_us = primeira ? 0 : agora_us - js->ultimo_us;
+    if (periodo_us > PERIODO_MAX_US) periodo_us = PERIODO_MAX_US;
+    if (periodo_us < 1) periodo_us = 1;
+    js->ultimo_us = agora_us;
+    js->iniciado = true;
+
+    int32_t dx = filtrar(&js->filtro_x, config, bruto_x, (uint32_t)periodo_us, primeira) - js->centro_x;
+    int32_t dy = filtrar(&js->filtro_y, config, bruto_y, (uint32_t)periodo_us, primeira) - js->centro_y;
+    int32_t raio = (int32_t)raiz_inteira((uint32_t)(dx * dx + dy * dy));
+
+    int32_t limite = config->zona_morta + (js->ativo ? -config->histerese : config->histerese);
+    js->ativo = (raio > limite);
+    if (!js->ativo || raio <= config->zona_morta) {
+        *x = 0;
+        *y = 0;
+        return;
+    }
+
+    // Remove a zona morta ao longo do raio, mantendo a direção
+    dx = dx * (raio - config->zona_morta) / raio;
+    dy = dy * (raio - config->zona_morta) / raio;
+    *x = escalar(dx, (dx > 0) ? JOYSTICK_ADC_MAX - js->centro_x : js->centro_x, config);
+    *y = escalar(dy, (dy > 0) ? JOYSTICK_ADC_MAX - js->centro_y : js->centro_y, config);
+}
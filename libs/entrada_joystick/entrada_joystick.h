@@ -0,0 +1,61 @@
+#ifndef ENTRADA_JOYSTICK_H
+#define ENTRADA_JOYSTICK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Processamento da leitura de um joystick analógico, independente do hardware:
+    filtro one-euro em ponto fixo -> centro calibrado -> zona morta radial com histerese -> escala de saída.
+    entrada_joystick.c só faz contas, por isso pode ser compilado e testado no computador.
+    As funções que leem o ADC do RP2040 ficam em entrada_joystick_adc.c.
+*/
+
+#define JOYSTICK_ADC_MAX 4095 // Leitura máxima do ADC de 12 bits
+
+/*
+    Configuração do processamento. Distâncias em unidades do ADC (0 a 4095).
+    O filtro one-euro deixa passar até corte_min_mhz com o joystick parado, eliminando o ruído,
+    e aumenta o corte com a velocidade (beta_uhz por unidade/s), para não atrasar movimentos rápidos.
+*/
+typedef struct {
+    uint16_t zona_morta;    // Raio da zona morta em torno do centro
+    uint16_t histerese;     // Margem em torno da borda da zona morta, evita que a saída pisque na borda
+    uint32_t corte_min_mhz; // Frequência de corte do filtro com o joystick parado, em mHz (0 desliga o filtro)
+    uint32_t beta_uhz;      // Aumento da frequência de corte, em µHz por unidade/s de velocidade
+    int16_t resolucao;      // A saída de cada eixo vai de -resolucao a +resolucao
+} joystick_config_t;
+
+// Configuração padrão: zona morta de ~7% do curso, corte de 1 Hz parado, saída de -100 a 100
+#define JOYSTICK_CONFIG_PADRAO { .zona_morta = 150, .histerese = 40, .corte_min_mhz = 1000, \
+                                 .beta_uhz = 1000, .resolucao = 100 }
+
+// Estado do filtro de um eixo
+typedef struct {
+    int32_t valor;    // Valor filtrado, em unidades do ADC com 8 bits de fração
+    int32_t derivada; // Velocidade filtrada, em unidades do ADC por segundo
+} joystick_filtro_t;
+
+// Estado de um joystick
+typedef struct {
+    joystick_config_t config;
+    uint16_t centro_x, centro_y; // Leitura com o joystick solto
+    joystick_filtro_t filtro_x, filtro_y;
+    uint64_t ultimo_us;          // Momento da última amostra
+    bool iniciado;               // Já recebeu a primeira amostra
+    bool ativo;                  // Fora da zona morta
+    uint8_t canal_x, canal_y;    // Canais do ADC (entrada_joystick_adc.c)
+} joystick_t;
+
+// --- Processamento (entrada_joystick.c) ---
+void joystick_configurar(joystick_t *js, const joystick_config_t *config);               // Define a configuração e reinicia o estado
+void joystick_calibrar(joystick_t *js, uint16_t centro_x, uint16_t centro_y);          // Define o centro a partir de leituras com o joystick solto
+void joystick_processar(joystick_t *js, uint16_t bruto_x, uint16_t bruto_y, uint64_t agora_us,
+                        int16_t *x, int16_t *y);                                       // Processa uma amostra bruta
+
+// --- Leitura do ADC do RP2040 (entrada_joystick_adc.c) ---
+void joystick_iniciar_adc(joystick_t *js, uint8_t pino_x, uint8_t pino_y,
+                          const joystick_config_t *config);                            // Configura o ADC e calibra o centro (joystick solto)
+void joystick_ler(joystick_t *js, int16_t *x, int16_t *y);                             // Lê e processa uma amostra
+
+#endif
@@ -0,0 +1,48 @@
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "entrada_joystick.h"
+
+#define AMOSTRAS_CALIBRACAO 64 // Leituras somadas para achar o centro
+
+/*
+    Função para ler o valor bruto de um canal do ADC (0 a 4095)
+*/
+static uint16_t ler_canal(uint8_t canal) {
+    adc_select_input(canal);
+    return adc_read();
+}
+
+/*
+    Função para configurar o ADC para o joystick e calibrar o centro
+    O joystick deve estar solto durante a inicialização: a média de AMOSTRAS_CALIBRACAO leituras de cada eixo
+    vira o centro, o que compensa a folga mecânica e a tolerância dos potenciômetros.
+    Os pinos são os do ADC do RP2040 (GPIO 26 a 29, canais 0 a 3).
+*/
+void joystick_iniciar_adc(joystick_t *js, uint8_t pino_x, uint8_t pino_y, const joystick_config_t *config) {
+    adc_init();
+    adc_gpio_init(pino_x);
+    adc_gpio_init(pino_y);
+
+    joystick_configurar(js, config);
+    js->canal_x = pino_x - 26;
+    js->canal_y = pino_y - 26;
+
+    uint32_t soma_x = 0;
+    uint32_t soma_y = 0;
+    for (uint8_t i = 0; i < AMOSTRAS_CALIBRACAO; i++) {
+        soma_x += ler_canal(js->canal_x);
+        soma_y += ler_canal(js->canal_y);
+        sleep_us(100);
+    }
+    joystick_calibrar(js, soma_x / AMOSTRAS_CALIBRACAO, soma_y / AMOSTRAS_CALIBRACAO);
+}
+
+/*
+    Função para ler os dois eixos e processar a amostra
+    A saída de cada eixo vai de -resolucao a +resolucao, com 0 no centro (ou dentro da zona morta).
+*/
+void joystick_ler(joystick_t *js, int16_t *x, int16_t *y) {
+    uint16_t bruto_x = ler_canal(js->canal_x);
+    uint16_t bruto_y = ler_canal(js->canal_y);
+    joystick_processar(js, bruto_x, bruto_y, time_us_64(), x, y);
+}
@@ -0,0 +1,15 @@
+#ifndef ENTRADA_JOYSTICK_HOST_ADC_H
+#define ENTRADA_JOYSTICK_HOST_ADC_H
+
+#include <stdint.h>
+
+/*
+    Substitui o ADC no computador: as leituras vêm do traço reproduzido por teste_joystick.c
+*/
+
+void adc_init(void);
+void adc_gpio_init(uint32_t pino);
+void adc_select_input(uint32_t canal);
+uint16_t adc_read(void);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef ENTRADA_JOYSTICK_HOST_STDLIB_H
+#define ENTRADA_JOYSTICK_HOST_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Substitui o SDK no computador: o tempo vem do traço reproduzido por teste_joystick.c
+*/
+
+uint64_t time_us_64(void);
+void sleep_us(uint64_t us);
+
+#endif
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "entrada_joystick.h"
+
+/*
+    Teste da entrada do joystick no computador: reproduz os traços do ADC da pasta tracos através de
+    joystick_iniciar_adc e joystick_ler, com o ADC e o relógio substituídos pelas amostras do traço.
+    Cada linha do traço tem o momento em µs e as leituras dos eixos X e Y; as 64 primeiras são as
+    lidas pela calibração. Para cada traço são conferidos o centro calibrado, a zona morta e a histerese.
+*/
+
+#define PINO_X 26 // Canal 0
+#define PINO_Y 27 // Canal 1
+#define AMOSTRAS_MAX 2048
+
+typedef struct {
+    uint64_t tempo_us;
+    uint16_t x, y;
+} amostra_t;
+
+static amostra_t traco[AMOSTRAS_MAX];
+static uint32_t tamanho, atual;
+static uint32_t canal;
+
+// --- ADC e relógio reproduzindo o traço ---
+void adc_init(void) {}
+void adc_gpio_init(uint32_t pino) { (void)pino; }
+void adc_select_input(uint32_t entrada) { canal = entrada; }
+void sleep_us(uint64_t us) { (void)us; } // O tempo avança com o traço
+
+uint64_t time_us_64(void) {
+    return traco[atual < tamanho ? atual : tamanho - 1].tempo_us;
+}
+
+// A leitura do eixo Y fecha a amostra, como em joystick_ler, que lê X e depois Y
+uint16_t adc_read(void) {
+    const amostra_t *amostra = &traco[atual < tamanho ? atual : tamanho - 1];
+    if (canal == PINO_Y - 26) {
+        atual++;
+        return amostra->y;
+    }
+    return amostra->x;
+}
+
+// Função para carregar um traço, ignorando as linhas de comentário; retorna 1 se conseguiu
+static int carregar(const char *caminho) {
+    FILE *arquivo = fopen(caminho, "r");
+    if (!arquivo) {
+        printf("Não foi possível ler %s\n", caminho);
+        return 0;
+    }
+    char linha[256];
+    tamanho = atual = 0;
+    while (fgets(linha, sizeof(linha), arquivo) && tamanho < AMOSTRAS_MAX) {
+        unsigned long long tempo_us;
+        unsigned x, y;
+        if (linha[0] == '#' || sscanf(linha, "%llu,%u,%u", &tempo_us, &x, &y) != 3) continue;
+        traco[tamanho++] = (amostra_t){ tempo_us, (uint16_t)x, (uint16_t)y };
+    }
+    fclose(arquivo);
+    return tamanho > 64;
+}
+
+// Saída do joystick para cada amostra do traço depois da calibração
+typedef struct {
+    int16_t x[AMOSTRAS_MAX], y[AMOSTRAS_MAX];
+    uint32_t quantidade;
+    uint32_t transicoes;    // Entradas e saídas da zona morta
+    uint32_t transicao[2];  // Amostras das duas primeiras
+} saida_t;
+
+static saida_t saida;
+static joystick_t joystick;
+
+static int reproduzir(const char *pasta, const char *nome) {
+    char caminho[512];
+    snprintf(caminho, sizeof(caminho), "%s/%s", pasta, nome);
+    if (!carregar(caminho)) return 0;
+
+    joystick_config_t config = JOYSTICK_CONFIG_PADRAO;
+    joystick_iniciar_adc(&joystick, PINO_X, PINO_Y, &config);
+
+    bool ativo = false;
+    saida.quantidade = saida.transicoes = 0;
+    while (atual < tamanho) {
+        uint32_t i = saida.quantidade++;
+        joystick_ler(&joystick, &saida.x[i], &saida.y[i]);
+        if (joystick.ativo != ativo && saida.transicoes++ < 2) saida.transicao[saida.transicoes - 1] = i;
+        ativo = joystick.ativo;
+    }
+    printf("%s: centro (%u, %u), %u amostras, %u transições da zona morta\n", nome,
+           joystick.centro_x, joystick.centro_y, saida.quantidade, saida.transicoes);
+    return 1;
+}
+
+static int falhas;
+
+static void conferir(int condicao, const char *nome, const char *descricao) {
+    if (!condicao) {
+        printf("%s: FALHOU: %s\n", nome, descricao);
+        falhas++;
+    }
+}
+
+// Conta as amostras de [de, ate) com a saída fora do centro
+static uint32_t fora_do_centro(uint32_t de, uint32_t ate) {
+    uint32_t n = 0;
+    for (uint32_t i = de; i < ate && i < saida.quantidade; i++) n += (saida.x[i] || saida.y[i]);
+    return n;
+}
+
+// Joystick solto: centro fora do meio encontrado, ruído e picos sempre dentro da zona morta
+static void testar_solto(const char *pasta) {
+    const char *nome = "solto.csv";
+    if (!reproduzir(pasta, nome)) { falhas++; return; }
+    conferir(abs(joystick.centro_x - 2010) <= 3 && abs(joystick.centro_y - 2095) <= 3, nome,
+             "centro calibrado longe de (2010, 2095)");
+    conferir(fora_do_centro(0, saida.quantidade) == 0, nome, "saída fora do centro com o joystick solto");
+    conferir(saida.transicoes == 0, nome, "saiu da zona morta");
+}
+
+// Borda da zona morta: a oscilação em torno da borda não ativa, e a volta para perto dela não desativa
+static void testar_borda(const char *pasta) {
+    const char *nome = "borda.csv";
+    if (!reproduzir(pasta, nome)) { falhas++; return; }
+    conferir(fora_do_centro(0, 100) == 0, nome, "oscilação em torno da borda ativou a saída");
+    conferir(fora_do_centro(150, 200) == 50, nome, "saída não ficou ativa em 260");
+    conferir(saida.transicoes == 2, nome, "a saída deve ativar e desativar uma vez só");
+    // Entre 120 e 140 a saída é 0, mas o joystick só sai do estado ativo abaixo de 110, em 60
+    conferir(saida.transicao[0] >= 100 && saida.transicao[0] < 150, nome, "não ativou ao ir para 260");
+    conferir(saida.transicao[1] >= 300, nome, "desativou antes de ir para 60");
+    conferir(fora_do_centro(350, 400) == 0, nome, "saída não voltou ao centro em 60");
+}
+
+// Movimentos rápidos: o filtro não atrasa, a zona morta radial mantém a direção e a escala chega ao fim
+static void testar_movimento(const char *pasta) {
+    const char *nome = "movimento.csv";
+    if (!reproduzir(pasta, nome)) { falhas++; return; }
+
+    // Para a direita a partir da amostra 20: 90% da saída em até 50 ms (5 amostras)
+    uint32_t resposta = 20;
+    while (resposta < 70 && saida.x[resposta] < 90) resposta++;
+    conferir(resposta <= 25, nome, "a saída demorou mais de 50 ms para chegar a 90% para a direita");
+    conferir(saida.x[60] >= 98 && abs(saida.y[60]) <= 2, nome, "todo para a direita não deu (100, 0)");
+
+    // Solto de novo: volta ao centro em até 100 ms
+    conferir(fora_do_centro(80, 120) == 0, nome, "a saída não voltou ao centro ao soltar");
+
+    // Diagonal na borda do curso: x e y iguais, cerca de 70% da escala (cos 45°)
+    int16_t x = saida.x[160], y = saida.y[160];
+    conferir(abs(x - y) <= 2 && x <= -65 && x >= -75, nome, "a diagonal não manteve a direção e a escala");
+    conferir(fora_do_centro(185, 220) == 0, nome, "a saída não voltou ao centro depois da diagonal");
+}
+
+int main(int argc, char **argv) {
+    const char *pasta = argc > 1 ? argv[1] : "tracos";
+    testar_solto(pasta);
+    testar_borda(pasta);
+    testar_movimento(pasta);
+    printf("%s\n", falhas ? "FALHOU" : "ok");
+    return falhas ? 1 : 0;
+}
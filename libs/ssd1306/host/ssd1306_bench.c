@@ -0,0 +1,412 @@
+/**
+* @file ssd1306_bench.c
+*
+* times drawing functions against the code they replaced, rebuilt here on top
+* of ssd1306_draw_pixel as it was, and checks that both draw the same pixels.
+* shows are timed through the emulator, a full frame against the dirty window
+*
+* usage: ssd1306_bench [section...] [-n iterations]
+*   -n  number of times each benchmark runs (default 1000)
+* without a section, all of them run. exits with 1 if the new code draws
+* something else than the old one
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssd1306.h"
+#include "ssd1306_emu.h"
+
+#define count_of(a) (sizeof(a)/sizeof((a)[0]))
+
+/**
+*	@brief benchmark section
+*/
+typedef struct {
+    const char *name;
+    bool (*run)(ssd1306_t *p, uint32_t iterations);
+} section_t;
+
+// keeps the compiler from dropping the benchmarked work
+static volatile uint32_t bench_sink;
+
+static uint64_t bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec*1000000000ull+ts.tv_nsec;
+}
+
+static void bench_report(const char *what, uint64_t old_ns, uint64_t new_ns, uint64_t operations) {
+    printf("  %-28s old %9.2f ns  new %9.2f ns  %6.1fx\n", what,
+           (double) old_ns/operations, (double) new_ns/operations,
+           new_ns ? (double) old_ns/new_ns : 0.0);
+}
+
+/* primitives */
+
+// ssd1306_draw_line before Bresenham: float slope, stepping x only
+static void old_draw_line(ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    int32_t t;
+
+    if(x1>x2) {
+        t=x1, x1=x2, x2=t;
+        t=y1, y1=y2, y2=t;
+    }
+    if(x1==x2) {
+        if(y1>y2)
+            t=y1, y1=y2, y2=t;
+        for(int32_t i=y1; i<=y2; ++i)
+            ssd1306_draw_pixel(p, x1, i);
+        return;
+    }
+
+    float m=(float) (y2-y1) / (float) (x2-x1);
+
+    for(int32_t i=x1; i<=x2; ++i) {
+        float y=m*(float) (i-x1)+(float) y1;
+        ssd1306_draw_pixel(p, i, (uint32_t) y);
+    }
+}
+
+// ssd1306_draw_square and ssd1306_clear_square before page-byte fills: one pixel at a time
+static void old_draw_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    for(uint32_t i=0; i<width; ++i)
+        for(uint32_t j=0; j<height; ++j)
+            ssd1306_draw_pixel(p, x+i, y+j);
+}
+
+static void old_clear_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    for(uint32_t i=0; i<width; ++i)
+        for(uint32_t j=0; j<height; ++j)
+            ssd1306_clear_pixel(p, x+i, y+j);
+}
+
+static bool pixel(const ssd1306_t *p, int32_t x, int32_t y) {
+    return (p->buffer[x+p->width*(y>>3)]>>(y&7))&1;
+}
+
+// a line is max(|dx|,|dy|)+1 pixels, each within half a pixel of the ideal line along the minor axis
+static bool line_is_exact(const ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    int32_t dx=abs(x2-x1), dy=abs(y2-y1), lit=0;
+
+    if(!pixel(p, x1, y1) || !pixel(p, x2, y2))
+        return false;
+    for(int32_t y=0; y<p->height; ++y) {
+        for(int32_t x=0; x<p->width; ++x) {
+            if(!pixel(p, x, y))
+                continue;
+            ++lit;
+            // distance along the minor axis, times the major length
+            int64_t d=dx>=dy ? (int64_t) (y-y1)*(x2-x1)-(int64_t) (x-x1)*(y2-y1)
+                      : (int64_t) (x-x1)*(y2-y1)-(int64_t) (y-y1)*(x2-x1);
+            if(2*llabs(d)>(dx>=dy ? dx : dy))
+                return false;
+        }
+    }
+    return lit==(dx>=dy ? dx : dy)+1;
+}
+
+static bool bench_primitives(ssd1306_t *p, uint32_t iterations) {
+    uint8_t expected[1024];
+    bool ok=true;
+
+    srand(1);
+    for(uint32_t i=0; i<2000; ++i) {
+        uint32_t x=rand()%140, y=rand()%70, w=rand()%80, h=rand()%70;
+
+        memset(p->buffer, 0x5A, p->bufsize);
+        old_draw_square(p, x, y, w, h);
+        old_clear_square(p, x+w/4, y+h/4, w/2, h/2);
+        memcpy(expected, p->buffer, p->bufsize);
+        memset(p->buffer, 0x5A, p->bufsize);
+        ssd1306_draw_square(p, x, y, w, h);
+        ssd1306_clear_square(p, x+w/4, y+h/4, w/2, h/2);
+        if(memcmp(expected, p->buffer, p->bufsize)) {
+            printf("  square %u,%u %ux%u differs from the per-pixel one\n", x, y, w, h);
+            ok=false;
+        }
+
+        int32_t x1=rand()%p->width, y1=rand()%p->height, x2=rand()%p->width, y2=rand()%p->height;
+        ssd1306_clear(p);
+        ssd1306_draw_line(p, x1, y1, x2, y2);
+        if(!line_is_exact(p, x1, y1, x2, y2)) {
+            printf("  line %d,%d to %d,%d has gaps or stray pixels\n", x1, y1, x2, y2);
+            ok=false;
+        }
+    }
+
+    uint64_t start=bench_ns();
+    for(uint32_t i=0; i<iterations; ++i) {
+        old_draw_square(p, 30, 17, 60, 30);
+        old_clear_square(p, 30, 17, 60, 30);
+    }
+    uint64_t old_ns=bench_ns()-start;
+    start=bench_ns();
+    for(uint32_t i=0; i<iterations; ++i) {
+        ssd1306_draw_square(p, 30, 17, 60, 30);
+        ssd1306_clear_square(p, 30, 17, 60, 30);
+    }
+    uint64_t new_ns=bench_ns()-start;
+    bench_report("60x30 square, draw+clear", old_ns, new_ns, iterations);
+
+    // lines of every slope, from the middle to the border
+    start=bench_ns();
+    for(uint32_t i=0; i<iterations; ++i)
+        old_draw_line(p, 64, 32, i%128, (i*7)%64);
+    old_ns=bench_ns()-start;
+    start=bench_ns();
+    for(uint32_t i=0; i<iterations; ++i)
+        ssd1306_draw_line(p, 64, 32, i%128, (i*7)%64);
+    new_ns=bench_ns()-start;
+    bench_report("line", old_ns, new_ns, iterations);
+
+    bench_sink=p->buffer[0];
+    return ok;
+}
+
+/* glyphs */
+
+extern const uint8_t font_8x5[];
+
+// two glyphs of two columns, 16 rows high
+static const uint8_t font_16x2[]= {16, 2, 1, 'A', 'B', 0x01, 0x80, 0xff, 0x0f, 0x55, 0xaa, 0x00, 0xf0};
+
+// ssd1306_draw_char_with_font before page bytes: one per-pixel square for each set font bit
+static void old_draw_char(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
+    if(c<font[3]||c>font[4])
+        return;
+
+    uint32_t parts_per_line=(font[0]>>3)+((font[0]&7)>0);
+    for(uint8_t w=0; w<font[1]; ++w) {
+        uint32_t pp=(c-font[3])*font[1]*parts_per_line+w*parts_per_line+5;
+        for(uint32_t lp=0; lp<parts_per_line; ++lp) {
+            uint8_t line=font[pp];
+            for(int8_t j=0; j<8; ++j, line>>=1) {
+                if(line & 1)
+                    old_draw_square(p, x+w*scale, y+((lp<<3)+j)*scale, scale, scale);
+            }
+            ++pp;
+        }
+    }
+}
+
+static void old_draw_string(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, const char *s) {
+    for(int32_t x_n=x; *s; x_n+=(font[1]+font[2])*scale)
+        old_draw_char(p, x_n, y, scale, font, *(s++));
+}
+
+// buffer and dirty columns, which tell what the next show sends
+static void snapshot(const ssd1306_t *p, uint8_t *copy) {
+    memcpy(copy, p->buffer, p->bufsize);
+    memcpy(copy+p->bufsize, p->dirty_min, sizeof(p->dirty_min));
+    memcpy(copy+p->bufsize+sizeof(p->dirty_min), p->dirty_max, sizeof(p->dirty_max));
+}
+
+static void scramble(ssd1306_t *p, uint8_t *pattern) {
+    memcpy(p->buffer, pattern, p->bufsize);
+    memset(p->dirty_min, 0xFF, sizeof(p->dirty_min));
+    memset(p->dirty_max, 0, sizeof(p->dirty_max));
+}
+
+static bool bench_glyphs(ssd1306_t *p, uint32_t iterations) {
+    uint8_t pattern[1024], expected[1024+2*SSD1306_MAX_PAGES], drawn[sizeof(expected)];
+    bool ok=true;
+
+    srand(4);
+    for(uint32_t i=0; i<20000; ++i) {
+        uint32_t x=rand()%140, y=rand()%80, scale=rand()%11;
+        const uint8_t *font=rand()%5 ? font_8x5 : font_16x2;
+        char c=font==font_8x5 ? 32+rand()%96 : 'A'+rand()%3;
+
+        for(size_t k=0; k<sizeof(pattern); ++k)
+            pattern[k]=rand()%4 ? 0 : rand();
+        scramble(p, pattern);
+        old_draw_char(p, x, y, scale, font, c);
+        snapshot(p, expected);
+        scramble(p, pattern);
+        ssd1306_draw_char_with_font(p, x, y, scale, font, c);
+        snapshot(p, drawn);
+        if(memcmp(expected, drawn, sizeof(drawn))) {
+            printf("  '%c' at %u,%u scale %u differs from the per-pixel one\n", c, x, y, scale);
+            ok=false;
+        }
+    }
+
+    // each string is drawn on a clear buffer, the time of clearing it is taken out
+    uint64_t start=bench_ns();
+    for(uint32_t i=0; i<iterations; ++i) {
+        ssd1306_clear(p);
+        bench_sink=p->buffer[i&1023];
+    }
+    uint64_t clear_ns=bench_ns()-start;
+
+    for(uint32_t scale=1; scale<=3; ++scale) {
+        char what[40];
+        start=bench_ns();
+        for(uint32_t i=0; i<iterations; ++i) {
+            ssd1306_clear(p);
+            old_draw_string(p, 3, 13, scale, font_8x5, "Count: 10");
+        }
+        uint64_t old_ns=bench_ns()-start;
+        start=bench_ns();
+        for(uint32_t i=0; i<iterations; ++i) {
+            ssd1306_clear(p);
+            ssd1306_draw_string(p, 3, 13, scale, "Count: 10");
+        }
+        uint64_t new_ns=bench_ns()-start;
+        snprintf(what, sizeof(what), "\"Count: 10\" at scale %u", (unsigned) scale);
+        bench_report(what, old_ns>clear_ns ? old_ns-clear_ns : 0, new_ns>clear_ns ? new_ns-clear_ns : 0, iterations);
+    }
+
+    bench_sink=p->buffer[0];
+    return ok;
+}
+
+/* show */
+
+static void draw_pixel(ssd1306_t *p, uint32_t i) {
+    if(i&1)
+        ssd1306_draw_pixel(p, 100, 40);
+    else
+        ssd1306_clear_pixel(p, 100, 40);
+}
+
+static void draw_counter(ssd1306_t *p, uint32_t i) {
+    char s[12];
+    snprintf(s, sizeof(s), "%u", (unsigned) (i%1000));
+    ssd1306_clear_square(p, 3, 13, 54, 16);
+    ssd1306_draw_string(p, 3, 13, 2, s);
+}
+
+static void draw_screen(ssd1306_t *p, uint32_t i) {
+    if(i&1)
+        ssd1306_draw_square(p, 0, 0, p->width, p->height);
+    else
+        ssd1306_clear(p);
+}
+
+/**
+*	@brief change drawn before each show
+*/
+static const struct {
+    const char *name;
+    void (*draw)(ssd1306_t *p, uint32_t i);
+} changes[]= {
+    {"one pixel", draw_pixel},
+    {"counter at scale 2", draw_counter},
+    {"whole screen", draw_screen},
+};
+
+// bytes of one show through the emulator, whose display RAM must then hold the buffer
+static bool measure_show(ssd1306_t *p, bool full, uint32_t *bytes, uint32_t *transfers) {
+    ssd1306_emu_t *e=p->transport_ctx;
+    if(full)
+        ssd1306_invalidate(p);
+    ssd1306_emu_reset_counters(e);
+    ssd1306_show(p);
+    *bytes=e->bytes;
+    *transfers=e->transfers;
+    return ssd1306_emu_matches(e, p);
+}
+
+// the old ssd1306_show sent the whole buffer, ssd1306_show now sends the dirty window.
+// times include decoding by the emulator; the bus time is estimated from the bytes
+static bool bench_show(ssd1306_t *p, uint32_t iterations) {
+    bool ok=true;
+
+    for(size_t c=0; c<count_of(changes); ++c) {
+        uint32_t old_bytes, old_transfers, new_bytes, new_transfers;
+
+        ssd1306_clear(p);
+        ssd1306_show(p);
+        changes[c].draw(p, 1);
+        ok&=measure_show(p, true, &old_bytes, &old_transfers);
+        changes[c].draw(p, 2);
+        ok&=measure_show(p, false, &new_bytes, &new_transfers);
+        if(!ok) {
+            printf("  %s: the display does not hold the buffer after a show\n", changes[c].name);
+            return false;
+        }
+
+        // drawing alone, taken out of both
+        uint64_t start=bench_ns();
+        for(uint32_t i=0; i<iterations; ++i)
+            changes[c].draw(p, i);
+        uint64_t draw_ns=bench_ns()-start;
+        ssd1306_show(p);
+
+        start=bench_ns();
+        for(uint32_t i=0; i<iterations; ++i) {
+            changes[c].draw(p, i);
+            ssd1306_invalidate(p);
+            ssd1306_show(p);
+        }
+        uint64_t old_ns=bench_ns()-start;
+        start=bench_ns();
+        for(uint32_t i=0; i<iterations; ++i) {
+            changes[c].draw(p, i);
+            ssd1306_show(p);
+        }
+        uint64_t new_ns=bench_ns()-start;
+        bench_report(changes[c].name, old_ns>draw_ns ? old_ns-draw_ns : 0, new_ns>draw_ns ? new_ns-draw_ns : 0, iterations);
+        // 9 clocks per byte at 400 kHz
+        printf("  %-28s old %6u bytes %2u transfers %6.0f us  new %6u bytes %2u transfers %6.0f us\n", "",
+               old_bytes, old_transfers, old_bytes*22.5, new_bytes, new_transfers, new_bytes*22.5);
+    }
+    return ok;
+}
+
+static const section_t sections[]= {
+    {"primitives", bench_primitives},
+    {"glyphs", bench_glyphs},
+    {"show", bench_show},
+};
+
+static void usage(const char *program) {
+    printf("usage: %s [section...] [-n iterations]\nsections:", program);
+    for(size_t i=0; i<count_of(sections); ++i)
+        printf(" %s", sections[i].name);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    bool selected[count_of(sections)]= {false}, any=false;
+    uint32_t iterations=1000, failed=0;
+    ssd1306_emu_t emu;
+    ssd1306_t disp= {0};
+
+    for(int i=1; i<argc; ++i) {
+        if(!strcmp(argv[i], "-n") && i+1<argc) {
+            iterations=atoi(argv[++i]);
+            continue;
+        }
+        size_t s=0;
+        while(s<count_of(sections) && strcmp(argv[i], sections[s].name))
+            ++s;
+        if(s==count_of(sections)) {
+            usage(argv[0]);
+            return 2;
+        }
+        selected[s]=any=true;
+    }
+
+    // shown only by the show section
+    ssd1306_emu_reset(&emu);
+    if(!ssd1306_init_with_transport(&disp, 128, 64, 0x3C, &ssd1306_transport_emu, &emu)) {
+        fprintf(stderr, "can't initialize the display\n");
+        return 2;
+    }
+    for(size_t s=0; s<count_of(sections); ++s) {
+        if(any && !selected[s])
+            continue;
+        printf("%s:\n", sections[s].name);
+        if(!sections[s].run(&disp, iterations)) {
+            printf("%s: the new code draws something else than the old one\n", sections[s].name);
+            ++failed;
+        }
+    }
+    ssd1306_deinit(&disp);
+    return failed ? 1 : 0;
+}
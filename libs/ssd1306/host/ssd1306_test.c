@@ -0,0 +1,216 @@
+/**
+* @file ssd1306_test.c
+*
+* draws scenarios through the emulator transport, checks each frame against
+* golden images and the bytes it took on the bus
+*
+* usage: ssd1306_test [scenario] [-w file] [-g file]
+*   -w  write the frames to a file, one PBM image after the other
+*   -g  compare the frames with the images of a file written with -w
+* exits with 1 if the display RAM differs from the buffer or the golden
+* frame, or if a frame took a different number of bytes on the bus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ssd1306.h"
+#include "ssd1306_emu.h"
+
+#define count_of(a) (sizeof(a)/sizeof((a)[0]))
+
+/**
+*	@brief scenario: frames drawn on one panel
+*/
+typedef struct {
+    const char *name;
+    uint8_t width;
+    uint8_t height;
+    void (*draw)(ssd1306_t *p, uint32_t frame);	/**< draws frame, before it is shown */
+    uint32_t frames;
+    const uint32_t *bytes;	/**< bytes on the bus for each frame */
+} scenario_t;
+
+static void draw_shapes(ssd1306_t *p, uint32_t frame) {
+    switch(frame) {
+    case 0:
+        ssd1306_draw_square(p, 2, 3, 40, 20);
+        ssd1306_draw_empty_square(p, 50, 5, 30, 30);
+        ssd1306_draw_circle(p, 100, 20, 12);
+        ssd1306_draw_empty_circle(p, 100, 48, 14);
+        ssd1306_draw_line(p, 0, 63, 60, 30);
+        ssd1306_draw_line(p, 10, 30, 14, 62);
+        ssd1306_draw_triangle(p, 20, 40, 45, 60, 60, 38);
+        ssd1306_draw_empty_triangle(p, 64, 40, 80, 62, 70, 50);
+        break;
+    case 1:	// nothing changed
+        break;
+    case 2:
+        ssd1306_draw_pixel(p, 127, 63);
+        break;
+    case 3:
+        ssd1306_clear_square(p, 90, 6, 24, 28);
+        ssd1306_draw_circle(p, 104, 22, 8);
+        break;
+    case 4:
+        ssd1306_clear_square(p, 10, 10, 20, 9);
+        ssd1306_draw_line(p, 0, 0, 127, 0);
+        break;
+    default:
+        ssd1306_clear(p);
+        break;
+    }
+}
+
+static void draw_text(ssd1306_t *p, uint32_t frame) {
+    char count[16];
+
+    switch(frame) {
+    case 0:
+        ssd1306_draw_string(p, 0, 0, 1, "SSD1306 test");
+        ssd1306_draw_string(p, 3, 13, 2, "Count:");
+        ssd1306_draw_string(p, 1, 35, 3, "ABC");
+        break;
+    default:	// only the digits change
+        snprintf(count, sizeof(count), "%u", (unsigned) frame*7);
+        ssd1306_clear_square(p, 75, 13, 50, 16);
+        ssd1306_draw_string(p, 75, 13, 2, count);
+        break;
+    }
+}
+
+static void draw_small(ssd1306_t *p, uint32_t frame) {
+    switch(frame) {
+    case 0:
+        ssd1306_draw_empty_square(p, 0, 0, 64, 32);
+        ssd1306_draw_string(p, 3, 3, 1, "64x32");
+        ssd1306_draw_circle(p, 48, 20, 8);
+        break;
+    case 1:
+        ssd1306_draw_line(p, 2, 29, 30, 14);
+        break;
+    default:
+        ssd1306_clear_square(p, 40, 12, 17, 17);
+        break;
+    }
+}
+
+static const uint32_t shapes_bytes[]= {907, 0, 15, 108, 198, 972};
+static const uint32_t text_bytes[]= {472, 48, 84, 84};
+static const uint32_t small_bytes[]= {270, 71, 69};
+
+static const scenario_t scenarios[]= {
+    {"shapes", 128, 64, draw_shapes, count_of(shapes_bytes), shapes_bytes},
+    {"text", 128, 64, draw_text, count_of(text_bytes), text_bytes},
+    {"small", 64, 32, draw_small, count_of(small_bytes), small_bytes},
+};
+
+// Compares the dump of display RAM with the next image of golden
+static bool matches_golden(const ssd1306_emu_t *e, const scenario_t *s, FILE *golden) {
+    uint8_t image[64+(SSD1306_EMU_COLUMNS/8)*8*SSD1306_MAX_PAGES], expected[sizeof(image)];
+    FILE *f=tmpfile();
+    size_t len;
+
+    if(!f)
+        return false;
+    ssd1306_emu_dump(e, f, s->width, s->height);
+    len=(size_t) ftell(f);
+    rewind(f);
+    len=fread(image, 1, len<sizeof(image) ? len : sizeof(image), f);
+    fclose(f);
+    return fread(expected, 1, len, golden)==len && !memcmp(image, expected, len);
+}
+
+static void count_callback(ssd1306_t *p, void *ctx) {
+    (void) p;
+    ++*(uint32_t *) ctx;
+}
+
+static void usage(const char *program) {
+    printf("usage: %s [scenario] [-w file] [-g file]\nscenarios:", program);
+    for(size_t i=0; i<count_of(scenarios); ++i)
+        printf(" %s", scenarios[i].name);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    const scenario_t *s=NULL;
+    FILE *out=NULL, *golden=NULL;
+    ssd1306_emu_t emu;
+    ssd1306_t disp= {0};
+    uint32_t failed=0, callbacks=0;
+
+    for(size_t i=0; argc>1 && i<count_of(scenarios); ++i) {
+        if(!strcmp(argv[1], scenarios[i].name))
+            s=&scenarios[i];
+    }
+    if(!s) {
+        usage(argv[0]);
+        return 2;
+    }
+    for(int i=2; i+1<argc; i+=2) {
+        if(!strcmp(argv[i], "-w") && !(out=fopen(argv[i+1], "wb"))) {
+            fprintf(stderr, "can't write %s\n", argv[i+1]);
+            return 2;
+        } else if(!strcmp(argv[i], "-g") && !(golden=fopen(argv[i+1], "rb"))) {
+            fprintf(stderr, "can't read %s\n", argv[i+1]);
+            return 2;
+        } else if(strcmp(argv[i], "-w") && strcmp(argv[i], "-g")) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    ssd1306_emu_reset(&emu);
+    if(!ssd1306_init_with_transport(&disp, s->width, s->height, 0x3C, &ssd1306_transport_emu, &emu)) {
+        fprintf(stderr, "can't initialize the display\n");
+        return 2;
+    }
+    ssd1306_set_callback(&disp, count_callback, &callbacks);
+    ssd1306_clear(&disp);
+    ssd1306_show(&disp);
+
+    for(uint32_t frame=0; frame<s->frames; ++frame) {
+        s->draw(&disp, frame);
+        ssd1306_emu_reset_counters(&emu);
+        callbacks=0;
+        // both paths send the same bytes, the asynchronous one calls back once, even for an empty frame
+        if(frame&1)
+            ssd1306_show_async(&disp);
+        else
+            ssd1306_show(&disp);
+        if(callbacks!=(frame&1)) {
+            printf("%s frame %u: callback called %u times\n", s->name, frame, callbacks);
+            ++failed;
+        }
+
+        printf("%s frame %u: %u bytes in %u transfers\n", s->name, frame, emu.bytes, emu.transfers);
+        if(emu.bytes!=s->bytes[frame]) {
+            printf("%s frame %u: expected %u bytes on the bus\n", s->name, frame, s->bytes[frame]);
+            ++failed;
+        }
+        if(!ssd1306_emu_matches(&emu, &disp)) {
+            printf("%s frame %u: display RAM differs from the buffer\n", s->name, frame);
+            ++failed;
+        }
+        if(out)
+            ssd1306_emu_dump(&emu, out, s->width, s->height);
+        if(golden && !matches_golden(&emu, s, golden)) {
+            printf("%s frame %u: differs from the golden frame\n", s->name, frame);
+            ++failed;
+        }
+    }
+
+    if(golden) {
+        if(fgetc(golden)!=EOF) {
+            printf("%s: the golden file has more frames than this run\n", s->name);
+            ++failed;
+        }
+        fclose(golden);
+    }
+    if(out)
+        fclose(out);
+    ssd1306_deinit(&disp);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,727 @@
+/*
+
+MIT License
+
+Copyright (c) 2021 David Schramm
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "ssd1306.h"
+#include "font.h"
+
+#ifndef MIN
+#define MIN(a, b) ((b)>(a)?(a):(b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a)>(b)?(a):(b))
+#endif
+
+inline static void swap(int32_t *a, int32_t *b) {
+    int32_t t=*a;
+    *a=*b;
+    *b=t;
+}
+
+// Sends commands in a single transfer, after one control byte with Co=0
+static void ssd1306_write_commands(ssd1306_t *p, const uint8_t *cmds, size_t len) {
+    ssd1306_wait(p);
+
+    uint8_t d[32];
+    d[0]=0x00;
+    while(len) {
+        size_t n=MIN(len, sizeof(d)-1);
+        memcpy(d+1, cmds, n);
+        p->transport->write(p, d, n+1);
+        cmds+=n;
+        len-=n;
+    }
+}
+
+inline static void ssd1306_write(ssd1306_t *p, uint8_t val) {
+    ssd1306_write_commands(p, &val, 1);
+}
+
+typedef void (*ssd1306_window_fn)(ssd1306_t *p, uint8_t first_page, uint8_t last_page, uint8_t x0, uint8_t x1);
+
+inline static void ssd1306_mark_dirty(ssd1306_t *p, uint32_t x, uint32_t page) {
+    if(x<p->dirty_min[page])
+        p->dirty_min[page]=x;
+    if(x>p->dirty_max[page])
+        p->dirty_max[page]=x;
+}
+
+inline static void ssd1306_mark_clean(ssd1306_t *p) {
+    memset(p->dirty_min, 0xff, sizeof(p->dirty_min));
+    memset(p->dirty_max, 0x00, sizeof(p->dirty_max));
+}
+
+bool ssd1306_init_with_transport(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, const ssd1306_transport_t *transport, void *ctx) {
+    p->width=width;
+    p->height=height;
+    p->pages=height/8;
+    p->address=address;
+
+    if(p->pages>SSD1306_MAX_PAGES || width>128) {
+        p->bufsize=0;
+        return false;
+    }
+
+    p->transport=transport;
+    p->transport_ctx=ctx;
+    p->transport_state=NULL;
+    p->callback=NULL;
+
+    p->bufsize=(p->pages)*(p->width);
+    if((p->buffer=malloc(p->bufsize+SSD1306_PREFIX))==NULL) {
+        p->bufsize=0;
+        return false;
+    }
+
+    p->buffer+=SSD1306_PREFIX;
+
+    // display RAM content is unknown after reset, first show sends everything
+    ssd1306_invalidate(p);
+
+    // from https://github.com/makerportal/rpi-pico-ssd1306
+    uint8_t cmds[]= {
+        SET_DISP,
+        // timing and driving scheme
+        SET_DISP_CLK_DIV,
+        0x80,
+        SET_MUX_RATIO,
+        height - 1,
+        SET_DISP_OFFSET,
+        0x00,
+        // resolution and layout
+        SET_DISP_START_LINE,
+        // charge pump
+        SET_CHARGE_PUMP,
+        p->external_vcc?0x10:0x14,
+        SET_SEG_REMAP | 0x01,           // column addr 127 mapped to SEG0
+        SET_COM_OUT_DIR | 0x08,         // scan from COM[N] to COM0
+        SET_COM_PIN_CFG,
+        width>2*height?0x02:0x12,
+        // display
+        SET_CONTRAST,
+        0xff,
+        SET_PRECHARGE,
+        p->external_vcc?0x22:0xF1,
+        SET_VCOM_DESEL,
+        0x30,                           // or 0x40?
+        SET_ENTIRE_ON,                  // output follows RAM contents
+        SET_NORM_INV,                   // not inverted
+        SET_DISP | 0x01,
+        // address setting
+        SET_MEM_ADDR,
+        0x00,  // horizontal
+    };
+
+    ssd1306_write_commands(p, cmds, sizeof(cmds));
+
+    return true;
+}
+
+void ssd1306_deinit(ssd1306_t *p) {
+    ssd1306_wait(p);
+    if(p->transport->release)
+        p->transport->release(p);
+    p->transport_state=NULL;
+    free(p->buffer-SSD1306_PREFIX);
+}
+
+inline void ssd1306_poweroff(ssd1306_t *p) {
+    ssd1306_write(p, SET_DISP|0x00);
+}
+
+inline void ssd1306_poweron(ssd1306_t *p) {
+    ssd1306_write(p, SET_DISP|0x01);
+}
+
+inline void ssd1306_contrast(ssd1306_t *p, uint8_t val) {
+    uint8_t cmds[]= {SET_CONTRAST, val};
+    ssd1306_write_commands(p, cmds, sizeof(cmds));
+}
+
+inline void ssd1306_invert(ssd1306_t *p, uint8_t inv) {
+    ssd1306_write(p, SET_NORM_INV | (inv & 1));
+}
+
+void ssd1306_clear(ssd1306_t *p) {
+    // only columns that were lit need to be sent again
+    for(uint32_t page=0; page<p->pages; ++page) {
+        uint8_t *line=p->buffer+page*p->width;
+        uint32_t first=0, last=p->width;
+        while(first<p->width && !line[first])
+            ++first;
+        if(first==p->width)
+            continue;
+        while(!line[last-1])
+            --last;
+        ssd1306_mark_dirty(p, first, page);
+        ssd1306_mark_dirty(p, last-1, page);
+        memset(line+first, 0, last-first);
+    }
+}
+
+void ssd1306_clear_pixel(ssd1306_t *p, uint32_t x, uint32_t y) {
+    if(x>=p->width || y>=p->height) return;
+
+    uint8_t *b=&p->buffer[x+p->width*(y>>3)];
+    uint8_t v=*b&~(0x1<<(y&0x07));
+    if(v!=*b) {
+        *b=v;
+        ssd1306_mark_dirty(p, x, y>>3);
+    }
+}
+
+void ssd1306_draw_pixel(ssd1306_t *p, uint32_t x, uint32_t y) {
+    if(x>=p->width || y>=p->height) return;
+
+    uint8_t *b=&p->buffer[x+p->width*(y>>3)];
+    uint8_t v=*b|(0x1<<(y&0x07)); // y>>3==y/8 && y&0x7==y%8
+    if(v!=*b) {
+        *b=v;
+        ssd1306_mark_dirty(p, x, y>>3);
+    }
+}
+
+// Sets or clears x0..x1, y0..y1 (inclusive, clipped to the display) a page
+// byte at a time, masking the rows outside the span on its first and last page
+static void ssd1306_fill(ssd1306_t *p, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool set) {
+    if(x0<0) x0=0;
+    if(y0<0) y0=0;
+    if(x1>=p->width) x1=p->width-1;
+    if(y1>=p->height) y1=p->height-1;
+    if(x0>x1 || y0>y1) return;
+
+    for(int32_t page=y0>>3; page<=y1>>3; ++page) {
+        uint8_t mask=0xff;
+        if(page==y0>>3)
+            mask&=0xff<<(y0&7);
+        if(page==y1>>3)
+            mask&=0xff>>(7-(y1&7));
+
+        uint8_t *line=p->buffer+page*p->width;
+        int32_t first=-1, last=-1;
+        for(int32_t x=x0; x<=x1; ++x) {
+            uint8_t v=set?line[x]|mask:line[x]&~mask;
+            if(v!=line[x]) {
+                line[x]=v;
+                if(first<0)
+                    first=x;
+                last=x;
+            }
+        }
+
+        if(first>=0) {
+            ssd1306_mark_dirty(p, first, page);
+            ssd1306_mark_dirty(p, last, page);
+        }
+    }
+}
+
+// Converts an unsigned square to an inclusive span, without overflowing near the end of the range
+static void ssd1306_fill_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height, bool set) {
+    if(!width || !height || x>=p->width || y>=p->height) return;
+
+    ssd1306_fill(p, x, y, x+MIN(width, p->width-x)-1, y+MIN(height, p->height-y)-1, set);
+}
+
+void ssd1306_draw_line(ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    if(x1==x2 || y1==y2) {
+        ssd1306_fill(p, MIN(x1, x2), MIN(y1, y2), MAX(x1, x2), MAX(y1, y2), true);
+        return;
+    }
+
+    // bresenham, stepping y and/or x by the sign of the accumulated error
+    int32_t dx=abs(x2-x1), dy=-abs(y2-y1);
+    int32_t sx=x1<x2?1:-1, sy=y1<y2?1:-1;
+    int32_t err=dx+dy;
+
+    for(;;) {
+        ssd1306_draw_pixel(p, x1, y1);
+        if(x1==x2 && y1==y2)
+            break;
+
+        int32_t e2=2*err;
+        if(e2>=dy) {
+            err+=dy;
+            x1+=sx;
+        }
+        if(e2<=dx) {
+            err+=dx;
+            y1+=sy;
+        }
+    }
+}
+
+void ssd1306_clear_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    ssd1306_fill_square(p, x, y, width, height, false);
+}
+
+void ssd1306_draw_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    ssd1306_fill_square(p, x, y, width, height, true);
+}
+
+void ssd1306_draw_empty_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    ssd1306_draw_line(p, x, y, x+width, y);
+    ssd1306_draw_line(p, x, y+height, x+width, y+height);
+    ssd1306_draw_line(p, x, y, x, y+height);
+    ssd1306_draw_line(p, x+width, y, x+width, y+height);
+}
+
+void ssd1306_draw_empty_circle(ssd1306_t *p, int32_t x0, int32_t y0, uint32_t r) {
+    // midpoint circle, one octant mirrored eight ways
+    int32_t x=(int32_t) r, y=0, err=1-x;
+
+    while(x>=y) {
+        ssd1306_draw_pixel(p, x0+x, y0+y);
+        ssd1306_draw_pixel(p, x0-x, y0+y);
+        ssd1306_draw_pixel(p, x0+x, y0-y);
+        ssd1306_draw_pixel(p, x0-x, y0-y);
+        ssd1306_draw_pixel(p, x0+y, y0+x);
+        ssd1306_draw_pixel(p, x0-y, y0+x);
+        ssd1306_draw_pixel(p, x0+y, y0-x);
+        ssd1306_draw_pixel(p, x0-y, y0-x);
+
+        ++y;
+        if(err<0) {
+            err+=2*y+1;
+        } else {
+            --x;
+            err+=2*(y-x)+1;
+        }
+    }
+}
+
+void ssd1306_draw_circle(ssd1306_t *p, int32_t x0, int32_t y0, uint32_t r) {
+    // same walk as the outline, filling vertical spans, which are a few page bytes each
+    int32_t x=(int32_t) r, y=0, err=1-x;
+
+    while(x>=y) {
+        ssd1306_fill(p, x0+x, y0-y, x0+x, y0+y, true);
+        ssd1306_fill(p, x0-x, y0-y, x0-x, y0+y, true);
+        ssd1306_fill(p, x0+y, y0-x, x0+y, y0+x, true);
+        ssd1306_fill(p, x0-y, y0-x, x0-y, y0+x, true);
+
+        ++y;
+        if(err<0) {
+            err+=2*y+1;
+        } else {
+            --x;
+            err+=2*(y-x)+1;
+        }
+    }
+}
+
+void ssd1306_draw_empty_triangle(ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3) {
+    ssd1306_draw_line(p, x1, y1, x2, y2);
+    ssd1306_draw_line(p, x2, y2, x3, y3);
+    ssd1306_draw_line(p, x3, y3, x1, y1);
+}
+
+void ssd1306_draw_triangle(ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3) {
+    // sort vertices by x, then fill one vertical span per column between
+    // the long edge (1 to 3) and the short edges (1 to 2, then 2 to 3)
+    if(x1>x2) {
+        swap(&x1, &x2);
+        swap(&y1, &y2);
+    }
+    if(x2>x3) {
+        swap(&x2, &x3);
+        swap(&y2, &y3);
+    }
+    if(x1>x2) {
+        swap(&x1, &x2);
+        swap(&y1, &y2);
+    }
+
+    for(int32_t x=MAX(x1, 0); x<=x3 && x<p->width; ++x) {
+        int32_t ya=x3==x1?y1:y1+(y3-y1)*(x-x1)/(x3-x1);
+        int32_t yb;
+        if(x<x2)
+            yb=y1+(y2-y1)*(x-x1)/(x2-x1);
+        else
+            yb=x3==x2?y2:y2+(y3-y2)*(x-x2)/(x3-x2);
+        ssd1306_fill(p, x, MIN(ya, yb), x, MAX(ya, yb), true);
+    }
+
+    // the spans round towards the long edge, the outline keeps the edges exact
+    ssd1306_draw_empty_triangle(p, x1, y1, x2, y2, x3, y3);
+}
+
+// Largest scale drawn a page byte at a time, above it glyph pixels are drawn as squares
+#define SSD1306_MAX_GLYPH_SCALE 8
+
+// Each bit of a nibble repeated scale times, for scales 2 to SSD1306_MAX_GLYPH_SCALE
+static const uint32_t ssd1306_expand_nibble[SSD1306_MAX_GLYPH_SCALE-1][16]= {
+    { // scale 2
+        0x00000000, 0x00000003, 0x0000000c, 0x0000000f, 0x00000030, 0x00000033, 0x0000003c, 0x0000003f,
+        0x000000c0, 0x000000c3, 0x000000cc, 0x000000cf, 0x000000f0, 0x000000f3, 0x000000fc, 0x000000ff,
+    },
+    { // scale 3
+        0x00000000, 0x00000007, 0x00000038, 0x0000003f, 0x000001c0, 0x000001c7, 0x000001f8, 0x000001ff,
+        0x00000e00, 0x00000e07, 0x00000e38, 0x00000e3f, 0x00000fc0, 0x00000fc7, 0x00000ff8, 0x00000fff,
+    },
+    { // scale 4
+        0x00000000, 0x0000000f, 0x000000f0, 0x000000ff, 0x00000f00, 0x00000f0f, 0x00000ff0, 0x00000fff,
+        0x0000f000, 0x0000f00f, 0x0000f0f0, 0x0000f0ff, 0x0000ff00, 0x0000ff0f, 0x0000fff0, 0x0000ffff,
+    },
+    { // scale 5
+        0x00000000, 0x0000001f, 0x000003e0, 0x000003ff, 0x00007c00, 0x00007c1f, 0x00007fe0, 0x00007fff,
+        0x000f8000, 0x000f801f, 0x000f83e0, 0x000f83ff, 0x000ffc00, 0x000ffc1f, 0x000fffe0, 0x000fffff,
+    },
+    { // scale 6
+        0x00000000, 0x0000003f, 0x00000fc0, 0x00000fff, 0x0003f000, 0x0003f03f, 0x0003ffc0, 0x0003ffff,
+        0x00fc0000, 0x00fc003f, 0x00fc0fc0, 0x00fc0fff, 0x00fff000, 0x00fff03f, 0x00ffffc0, 0x00ffffff,
+    },
+    { // scale 7
+        0x00000000, 0x0000007f, 0x00003f80, 0x00003fff, 0x001fc000, 0x001fc07f, 0x001fff80, 0x001fffff,
+        0x0fe00000, 0x0fe0007f, 0x0fe03f80, 0x0fe03fff, 0x0fffc000, 0x0fffc07f, 0x0fffff80, 0x0fffffff,
+    },
+    { // scale 8
+        0x00000000, 0x000000ff, 0x0000ff00, 0x0000ffff, 0x00ff0000, 0x00ff00ff, 0x00ffff00, 0x00ffffff,
+        0xff000000, 0xff0000ff, 0xff00ff00, 0xff00ffff, 0xffff0000, 0xffff00ff, 0xffffff00, 0xffffffff,
+    },
+};
+
+// Repeats each bit of a font byte scale times into scale bytes, top row first
+inline static void ssd1306_expand(uint8_t line, uint32_t scale, uint8_t *col) {
+    if(scale==1) {
+        col[0]=line;
+        return;
+    }
+
+    // the high nibble starts at bit 4*scale, kept in two 32 bit words
+    const uint32_t *t=ssd1306_expand_nibble[scale-2];
+    uint32_t lo=t[line&0x0f], hi=t[line>>4], n=4*scale;
+    uint32_t w[2]= {n<32 ? lo|(hi<<n) : lo, n<32 ? hi>>(32-n) : hi};
+
+    for(uint32_t i=0; i<scale; ++i)
+        col[i]=(uint8_t) (w[i>>2]>>(8*(i&3)));
+}
+
+// ORs a column of len bytes of pixels, top row first, from row y into count
+// columns from x: each byte is split over the two pages it crosses when y is
+// not page aligned
+static void ssd1306_or_columns(ssd1306_t *p, uint32_t x, uint32_t y, const uint8_t *col, uint32_t len, uint32_t count) {
+    if(x>=p->width)
+        return;
+    count=MIN(count, p->width-x);
+
+    uint32_t page=y>>3, shift=y&7;
+    uint8_t carry=0;
+    for(uint32_t k=0; k<=len && page<p->pages; ++k, ++page) {
+        uint16_t bits=k<len ? (uint16_t) (col[k]<<shift) : 0;
+        uint8_t v=(uint8_t) bits|carry;
+        carry=bits>>8;
+        if(!v)
+            continue;
+
+        uint8_t *b=&p->buffer[x+page*p->width];
+        for(uint32_t i=0; i<count; ++i) {
+            if((b[i]|v)!=b[i]) {
+                b[i]|=v;
+                ssd1306_mark_dirty(p, x+i, page);
+            }
+        }
+    }
+}
+
+// Scale 1: ORs the font bytes of a glyph, parts per column, straight into the
+// pages they cover, one more when y is not page aligned. each page is marked
+// dirty once, over the columns that changed
+static void ssd1306_draw_glyph(ssd1306_t *p, uint32_t x, uint32_t y, const uint8_t *glyph, uint32_t width, uint32_t parts) {
+    if(x>=p->width)
+        return;
+    width=MIN(width, p->width-x);
+
+    uint32_t shift=y&7;
+    for(uint32_t lp=0; lp<parts+(shift>0); ++lp) {
+        uint32_t page=(y>>3)+lp;
+        if(page>=p->pages)
+            break;
+
+        uint8_t *b=&p->buffer[x+page*p->width];
+        uint32_t first=width, last=0;
+        for(uint32_t w=0; w<width; ++w) {
+            const uint8_t *col=glyph+w*parts;
+            uint8_t v=lp<parts ? (uint8_t) (col[lp]<<shift) : 0;
+            if(lp && shift)
+                v|=col[lp-1]>>(8-shift);
+            if((b[w]|v)!=b[w]) {
+                b[w]|=v;
+                first=MIN(first, w);
+                last=w;
+            }
+        }
+        if(first<=last) {
+            ssd1306_mark_dirty(p, x+first, page);
+            ssd1306_mark_dirty(p, x+last, page);
+        }
+    }
+}
+
+void ssd1306_draw_char_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
+    if(c<font[3]||c>font[4]||!scale)
+        return;
+
+    uint32_t parts_per_line=(font[0]>>3)+((font[0]&7)>0);
+    if(scale==1) {
+        ssd1306_draw_glyph(p, x, y, font+(c-font[3])*font[1]*parts_per_line+5, font[1], parts_per_line);
+        return;
+    }
+    for(uint8_t w=0; w<font[1]; ++w) { // width
+        uint32_t pp=(c-font[3])*font[1]*parts_per_line+w*parts_per_line+5;
+        for(uint32_t lp=0; lp<parts_per_line; ++lp) {
+            uint8_t line=font[pp];
+
+            if(scale<=SSD1306_MAX_GLYPH_SCALE) {
+                // the column expanded to 8*scale rows, repeated over scale columns
+                uint8_t col[SSD1306_MAX_GLYPH_SCALE];
+                ssd1306_expand(line, scale, col);
+                ssd1306_or_columns(p, x+w*scale, y+(lp<<3)*scale, col, scale, scale);
+            } else {
+                for(int8_t j=0; j<8; ++j, line>>=1) {
+                    if(line & 1)
+                        ssd1306_draw_square(p, x+w*scale, y+((lp<<3)+j)*scale, scale, scale);
+                }
+            }
+
+            ++pp;
+        }
+    }
+}
+
+void ssd1306_draw_string_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, const char *s) {
+    for(int32_t x_n=x; *s; x_n+=(font[1]+font[2])*scale) {
+        ssd1306_draw_char_with_font(p, x_n, y, scale, font, *(s++));
+    }
+}
+
+void ssd1306_draw_char(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, char c) {
+    ssd1306_draw_char_with_font(p, x, y, scale, font_8x5, c);
+}
+
+void ssd1306_draw_string(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *s) {
+    ssd1306_draw_string_with_font(p, x, y, scale, font_8x5, s);
+}
+
+static inline uint32_t ssd1306_bmp_get_val(const uint8_t *data, const size_t offset, uint8_t size) {
+    switch(size) {
+    case 1:
+        return data[offset];
+    case 2:
+        return data[offset]|(data[offset+1]<<8);
+    case 4:
+        return data[offset]|(data[offset+1]<<8)|(data[offset+2]<<16)|(data[offset+3]<<24);
+    default:
+        __builtin_unreachable();
+    }
+    __builtin_unreachable();
+}
+
+void ssd1306_bmp_show_image_with_offset(ssd1306_t *p, const uint8_t *data, const long size, uint32_t x_offset, uint32_t y_offset) {
+    if(size<54) // data smaller than header
+        return;
+
+    const uint32_t bfOffBits=ssd1306_bmp_get_val(data, 10, 4);
+    const uint32_t biSize=ssd1306_bmp_get_val(data, 14, 4);
+    const uint32_t biWidth=ssd1306_bmp_get_val(data, 18, 4);
+    const int32_t biHeight=(int32_t) ssd1306_bmp_get_val(data, 22, 4);
+    const uint16_t biBitCount=(uint16_t) ssd1306_bmp_get_val(data, 28, 2);
+    const uint32_t biCompression=ssd1306_bmp_get_val(data, 30, 4);
+
+    if(biBitCount!=1) // image not monochrome
+        return;
+
+    if(biCompression!=0) // image compressed
+        return;
+
+    const int table_start=14+biSize;
+    uint8_t color_val=0;
+
+    for(uint8_t i=0; i<2; ++i) {
+        if(!((data[table_start+i*4]<<16)|(data[table_start+i*4+1]<<8)|data[table_start+i*4+2])) {
+            color_val=i;
+            break;
+        }
+    }
+
+    uint32_t bytes_per_line=(biWidth/8)+(biWidth&7?1:0);
+    if(bytes_per_line&3)
+        bytes_per_line=(bytes_per_line^(bytes_per_line&3))+4;
+
+    const uint8_t *img_data=data+bfOffBits;
+
+    int32_t step=biHeight>0?-1:1;
+    int32_t border=biHeight>0?-1:-biHeight;
+
+    for(uint32_t y=biHeight>0?biHeight-1:0; y!=(uint32_t)border; y+=step) {
+        for(uint32_t x=0; x<biWidth; ++x) {
+            if(((img_data[x>>3]>>(7-(x&7)))&1)==color_val)
+                ssd1306_draw_pixel(p, x_offset+x, y_offset+y);
+        }
+        img_data+=bytes_per_line;
+    }
+}
+
+inline void ssd1306_bmp_show_image(ssd1306_t *p, const uint8_t *data, const long size) {
+    ssd1306_bmp_show_image_with_offset(p, data, size, 0, 0);
+}
+
+// Builds the commands of a window followed by the control byte of its data,
+// so the window is opened and filled in the same transfer
+inline static void ssd1306_window_prefix(ssd1306_t *p, uint8_t *prefix, uint8_t first_page, uint8_t last_page, uint8_t x0, uint8_t x1) {
+    uint8_t offset=p->width==64?32:0;
+    uint8_t cmds[SSD1306_WINDOW_CMDS]= {SET_COL_ADDR, x0+offset, x1+offset, SET_PAGE_ADDR, first_page, last_page};
+
+    for(size_t i=0; i<SSD1306_WINDOW_CMDS; ++i) {
+        prefix[2*i]=0x80;
+        prefix[2*i+1]=cmds[i];
+    }
+    prefix[SSD1306_PREFIX-1]=0x40;
+}
+
+static void ssd1306_show_window(ssd1306_t *p, uint8_t first_page, uint8_t last_page, uint8_t x0, uint8_t x1) {
+    uint8_t prefix[SSD1306_PREFIX], saved[SSD1306_PREFIX];
+    ssd1306_window_prefix(p, prefix, first_page, last_page, x0, x1);
+
+    // full rows are contiguous in the buffer, send them at once
+    uint8_t rows=x0==0 && x1==p->width-1 ? last_page-first_page+1 : 1;
+    size_t len=(size_t) (x1-x0+1)*rows;
+
+    // the bytes before the data hold the prefix of the write: they are the
+    // reserved slots before the buffer, or the end of the previous page which
+    // is put back afterwards. only the first write needs the window commands
+    size_t n=SSD1306_PREFIX;
+    for(uint32_t page=first_page; page<=last_page; page+=rows) {
+        uint8_t *data=p->buffer+page*p->width+x0;
+        memcpy(saved, data-n, n);
+        memcpy(data-n, prefix+SSD1306_PREFIX-n, n);
+        p->transport->write(p, data-n, len+n);
+        memcpy(data-n, saved, n);
+        n=1;
+    }
+}
+
+static void ssd1306_for_each_window(ssd1306_t *p, ssd1306_window_fn fn) {
+    uint32_t page=0;
+    while(page<p->pages) {
+        if(p->dirty_min[page]>p->dirty_max[page]) {
+            ++page;
+            continue;
+        }
+
+        // extend the window down over the next dirty pages while sending their
+        // union costs less than opening another window
+        uint32_t first=page;
+        uint8_t x0=p->dirty_min[page], x1=p->dirty_max[page];
+        while(++page<p->pages && p->dirty_min[page]<=p->dirty_max[page]) {
+            uint8_t n0=MIN(x0, p->dirty_min[page]), n1=MAX(x1, p->dirty_max[page]);
+            uint32_t joined=(page-first+1)*(n1-n0+1);
+            uint32_t apart=(page-first)*(x1-x0+1)+(p->dirty_max[page]-p->dirty_min[page]+1)+SSD1306_WINDOW_COST;
+            if(joined>apart)
+                break;
+            x0=n0;
+            x1=n1;
+        }
+
+        fn(p, first, page-1, x0, x1);
+    }
+
+    ssd1306_mark_clean(p);
+}
+
+void ssd1306_show(ssd1306_t *p) {
+    ssd1306_wait(p);
+    ssd1306_for_each_window(p, ssd1306_show_window);
+}
+
+static void ssd1306_queue_window(ssd1306_t *p, uint8_t first_page, uint8_t last_page, uint8_t x0, uint8_t x1) {
+    uint8_t prefix[SSD1306_PREFIX];
+    ssd1306_window_prefix(p, prefix, first_page, last_page, x0, x1);
+
+    uint8_t rows=x0==0 && x1==p->width-1 ? last_page-first_page+1 : 1;
+    size_t n=SSD1306_PREFIX;
+    for(uint32_t page=first_page; page<=last_page; page+=rows) {
+        p->transport->queue(p, prefix+SSD1306_PREFIX-n, n, p->buffer+page*p->width+x0, (size_t) (x1-x0+1)*rows);
+        n=1;
+    }
+}
+
+bool ssd1306_show_async(ssd1306_t *p) {
+    int ready=p->transport->begin ? p->transport->begin(p) : -1;
+    if(ready<0) {
+        ssd1306_show(p);
+        return true;
+    }
+    if(!ready)
+        return false;
+
+    ssd1306_for_each_window(p, ssd1306_queue_window);
+    p->transport->start(p);
+    return true;
+}
+
+void ssd1306_set_callback(ssd1306_t *p, ssd1306_callback_t callback, void *ctx) {
+    p->callback_ctx=ctx;
+    p->callback=callback;
+}
+
+bool ssd1306_busy(ssd1306_t *p) {
+    return p->transport->busy && p->transport->busy(p);
+}
+
+void ssd1306_wait(ssd1306_t *p) {
+    while(ssd1306_busy(p))
+        ;
+}
+
+void ssd1306_invalidate(ssd1306_t *p) {
+    for(uint32_t page=0; page<p->pages; ++page) {
+        p->dirty_min[page]=0;
+        p->dirty_max[page]=p->width-1;
+    }
+}
+
+void ssd1306_write_pbm(FILE *f, const uint8_t *pages, uint32_t width, uint32_t height) {
+    fprintf(f, "P4\n%u %u\n", (unsigned) width, (unsigned) height);
+
+    // rows of pixels, 8 per byte with the leftmost in the highest bit
+    for(uint32_t y=0; y<height; ++y) {
+        for(uint32_t x=0; x<width; x+=8) {
+            uint8_t v=0;
+            for(uint32_t i=0; i<8 && x+i<width; ++i) {
+                if((pages[x+i+width*(y>>3)]>>(y&7))&1)
+                    v|=0x80>>i;
+            }
+            fputc(v, f);
+        }
+    }
+}
+
+void ssd1306_dump(ssd1306_t *p, FILE *f) {
+    ssd1306_write_pbm(f, p->buffer, p->width, p->height);
+}
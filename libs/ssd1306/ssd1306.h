@@ -26,12 +26,40 @@ SOFTWARE.
 * @file ssd1306.h
 * 
 * simple driver for ssd1306 displays
+*
+* drawing does not depend on the pico sdk, the bytes go through a transport:
+* i2c (blocking or dma) from ssd1306_i2c.h, the emulator from ssd1306_emu.h,
+* or one provided by the caller. define SSD1306_HOST to build without the sdk
 */
 
 #ifndef _inc_ssd1306
 #define _inc_ssd1306
-#include <pico/stdlib.h>
-#include <hardware/i2c.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+*	@brief maximum number of pages (8 rows each) supported by the controller
+*/
+#define SSD1306_MAX_PAGES 8
+
+/**
+*	@brief commands that open a window: column range and page range
+*/
+#define SSD1306_WINDOW_CMDS 6
+
+/**
+*	@brief bytes sent to open a window, weighed against data bytes when merging pages in ssd1306_show
+*/
+#define SSD1306_WINDOW_COST (2*SSD1306_WINDOW_CMDS)
+
+/**
+*	@brief bytes reserved before the buffer for the prefix of a window: each
+*	command after a control byte with Co=1, then the control byte of the data.
+*	a frame is at most this per page plus the buffer
+*/
+#define SSD1306_PREFIX (SSD1306_WINDOW_COST+1)
 
 /**
 *	@brief defines commands used in ssd1306
@@ -56,34 +84,63 @@ typedef enum {
     SET_CHARGE_PUMP = 0x8D
 } ssd1306_command_t;
 
+typedef struct ssd1306 ssd1306_t;
+
 /**
-*	@brief holds the configuration
+*	@brief called by the transport, from interrupt context, when an asynchronous show has been queued to the bus
+*/
+typedef void (*ssd1306_callback_t)(ssd1306_t *p, void *ctx);
+
+/**
+*	@brief moves bytes to the display, only write is required
+*
+*	every transfer starts with its control byte(s). the asynchronous functions
+*	are optional: without begin, ssd1306_show_async is a blocking show
 */
 typedef struct {
+    void (*write)(ssd1306_t *p, const uint8_t *src, size_t len);	/**< send one transfer and return when done */
+    int (*begin)(ssd1306_t *p);	/**< start an asynchronous frame: >0 ready, 0 previous frame in flight, <0 not possible */
+    void (*queue)(ssd1306_t *p, const uint8_t *prefix, size_t prefix_len, const uint8_t *src, size_t len);	/**< add one transfer, prefix then src, copying both */
+    void (*start)(ssd1306_t *p);	/**< send the queued transfers, possibly none, then p->callback runs once they are sent (right away for none) */
+    bool (*busy)(ssd1306_t *p);	/**< whether an asynchronous frame is still on the bus */
+    void (*release)(ssd1306_t *p);	/**< free transport_state, called by ssd1306_deinit */
+} ssd1306_transport_t;
+
+/**
+*	@brief holds the configuration
+*/
+struct ssd1306 {
     uint8_t width; 		/**< width of display */
     uint8_t height; 	/**< height of display */
     uint8_t pages;		/**< stores pages of display (calculated on initialization*/
     uint8_t address; 	/**< i2c address of display*/
-    i2c_inst_t *i2c_i; 	/**< i2c connection instance */
+    const ssd1306_transport_t *transport;	/**< how bytes reach the display */
+    void *transport_ctx;	/**< passed at initialization, e.g. i2c connection instance */
+    void *transport_state;	/**< owned by the transport, NULL after initialization */
     bool external_vcc; 	/**< whether display uses external vcc */ 
     uint8_t *buffer;	/**< display buffer */
     size_t bufsize;		/**< buffer size */
-} ssd1306_t;
+    uint8_t dirty_min[SSD1306_MAX_PAGES];	/**< first changed column of each page since last show */
+    uint8_t dirty_max[SSD1306_MAX_PAGES];	/**< last changed column of each page, less than dirty_min if page is clean */
+    ssd1306_callback_t callback;	/**< called when an asynchronous show is done, may be NULL */
+    void *callback_ctx;	/**< passed to callback */
+};
 
 /**
-*	@brief initialize display
+*	@brief initialize display on any transport
 *
 *	@param[in] p : pointer to instance of ssd1306_t
 *	@param[in] width : width of display
 *	@param[in] height : heigth of display
 *	@param[in] address : i2c address of display
-*	@param[in] i2c_instance : instance of i2c connection
+*	@param[in] transport : transport used to send bytes
+*	@param[in] ctx : stored in p->transport_ctx for the transport
 *	
 * 	@return bool.
 *	@retval true for Success
 *	@retval false if initialization failed
 */
-bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance);
+bool ssd1306_init_with_transport(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, const ssd1306_transport_t *transport, void *ctx);
 
 /**
 *	@brief deinitialize display
@@ -130,11 +187,76 @@ void ssd1306_invert(ssd1306_t *p, uint8_t inv);
 /**
 	@brief display buffer, should be called on change
 
+	only the columns changed on each page since the last call are sent
+
 	@param[in] p : instance of display
 
 */
 void ssd1306_show(ssd1306_t *p);
 
+/**
+	@brief mark whole buffer as changed, so next show sends all of it
+
+	needed after writing to p->buffer directly
+
+	@param[in] p : instance of display
+
+*/
+void ssd1306_invalidate(ssd1306_t *p);
+
+/**
+	@brief display buffer without waiting for the transfer
+
+	the changed regions are copied and streamed to the bus by the transport
+	(dma for i2c), so the buffer can be drawn again as soon as this returns.
+	falls back to ssd1306_show if the transport can not do it
+
+	@param[in] p : instance of display
+
+	@return bool.
+	@retval true if the frame was queued
+	@retval false if the previous frame is still in flight, nothing was done
+*/
+bool ssd1306_show_async(ssd1306_t *p);
+
+/**
+	@brief set function called from interrupt context when an asynchronous show is done
+
+	the last bytes may still be leaving the i2c fifo when it is called, but
+	the next ssd1306_show_async can be queued. it runs in interrupt context,
+	e.g. to give a FreeRTOS semaphore with xSemaphoreGiveFromISR
+
+	it is called once for every frame queued by ssd1306_show_async, also
+	when nothing changed since the last show: that empty frame is done
+	right away, so the callback runs from ssd1306_show_async itself, on
+	every transport. it is not called when show_async falls back to a
+	blocking ssd1306_show
+
+	@param[in] p : instance of display
+	@param[in] callback : function to call, NULL to disable
+	@param[in] ctx : passed to callback
+*/
+void ssd1306_set_callback(ssd1306_t *p, ssd1306_callback_t callback, void *ctx);
+
+/**
+	@brief check if an asynchronous show is still being sent
+
+	@param[in] p : instance of display
+
+	@return bool.
+	@retval true if the bus is still busy with the last frame
+*/
+bool ssd1306_busy(ssd1306_t *p);
+
+/**
+	@brief wait until an asynchronous show is finished on the bus
+
+	called by every blocking function of the driver before using the bus
+
+	@param[in] p : instance of display
+*/
+void ssd1306_wait(ssd1306_t *p);
+
 /**
 	@brief clear display buffer
 
@@ -205,6 +327,52 @@ void ssd1306_draw_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, u
 */
 void ssd1306_draw_empty_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 
+/**
+	@brief draw filled circle at given center with given radius
+
+	@param[in] p : instance of display
+	@param[in] x0 : x position of center
+	@param[in] y0 : y position of center
+	@param[in] r : radius
+*/
+void ssd1306_draw_circle(ssd1306_t *p, int32_t x0, int32_t y0, uint32_t r);
+
+/**
+	@brief draw empty circle at given center with given radius
+
+	@param[in] p : instance of display
+	@param[in] x0 : x position of center
+	@param[in] y0 : y position of center
+	@param[in] r : radius
+*/
+void ssd1306_draw_empty_circle(ssd1306_t *p, int32_t x0, int32_t y0, uint32_t r);
+
+/**
+	@brief draw filled triangle with given corners
+
+	@param[in] p : instance of display
+	@param[in] x1 : x position of first corner
+	@param[in] y1 : y position of first corner
+	@param[in] x2 : x position of second corner
+	@param[in] y2 : y position of second corner
+	@param[in] x3 : x position of third corner
+	@param[in] y3 : y position of third corner
+*/
+void ssd1306_draw_triangle(ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3);
+
+/**
+	@brief draw empty triangle with given corners
+
+	@param[in] p : instance of display
+	@param[in] x1 : x position of first corner
+	@param[in] y1 : y position of first corner
+	@param[in] x2 : x position of second corner
+	@param[in] y2 : y position of second corner
+	@param[in] x3 : x position of third corner
+	@param[in] y3 : y position of third corner
+*/
+void ssd1306_draw_empty_triangle(ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3);
+
 /**
 	@brief draw monochrome bitmap with offset
 
@@ -271,4 +439,28 @@ void ssd1306_draw_string_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_
 */
 void ssd1306_draw_string(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *s);
 
+/**
+	@brief write pixels stored in pages, as in the display buffer, as a binary pbm image
+
+	lit pixels are written as 1 (black in most viewers)
+
+	@param[in] f : file to write to
+	@param[in] pages : pixels, one byte per column of each page of 8 rows, lowest bit on top
+	@param[in] width : width of image
+	@param[in] height : height of image, a multiple of 8
+*/
+void ssd1306_write_pbm(FILE *f, const uint8_t *pages, uint32_t width, uint32_t height);
+
+/**
+	@brief write display buffer as a binary pbm image, e.g. to compare output in tests
+
+	@param[in] p : instance of display
+	@param[in] f : file to write to
+*/
+void ssd1306_dump(ssd1306_t *p, FILE *f);
+
+#ifndef SSD1306_HOST
+#include "ssd1306_i2c.h"
+#endif
+
 #endif
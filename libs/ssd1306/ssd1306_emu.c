@@ -0,0 +1,213 @@
+/*
+MIT License
+
+Copyright (c) 2021 David Schramm
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <string.h>
+
+#include "ssd1306_emu.h"
+
+// Number of argument bytes following each command, 0 for single byte commands
+static uint8_t ssd1306_emu_args(uint8_t cmd) {
+    switch(cmd) {
+    case SET_MEM_ADDR:
+    case SET_CONTRAST:
+    case SET_CHARGE_PUMP:
+    case SET_MUX_RATIO:
+    case SET_DISP_OFFSET:
+    case SET_COM_PIN_CFG:
+    case SET_DISP_CLK_DIV:
+    case SET_PRECHARGE:
+    case SET_VCOM_DESEL:
+        return 1;
+    case SET_COL_ADDR:
+    case SET_PAGE_ADDR:
+    case 0xA3:	// vertical scroll area
+        return 2;
+    case 0x29:	// vertical and horizontal scroll
+    case 0x2A:
+        return 5;
+    case 0x26:	// horizontal scroll
+    case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void ssd1306_emu_command(ssd1306_emu_t *e) {
+    uint8_t *c=e->cmd;
+
+    if(c[0]==SET_MEM_ADDR) {
+        e->mode=c[1]&0x03;
+    } else if(c[0]==SET_COL_ADDR) {
+        e->col_start=e->col=c[1]&0x7F;
+        e->col_end=c[2]&0x7F;
+    } else if(c[0]==SET_PAGE_ADDR) {
+        e->page_start=e->page=c[1]&0x07;
+        e->page_end=c[2]&0x07;
+    } else if(c[0]==SET_DISP || c[0]==(SET_DISP|0x01)) {
+        e->display_on=c[0]&0x01;
+    } else if(e->mode==2 && c[0]<=0x0F) {	// page mode, lower nibble of column
+        e->col=(e->col&0xF0)|c[0];
+    } else if(e->mode==2 && c[0]>=0x10 && c[0]<=0x17) {	// page mode, upper nibble of column
+        e->col=((c[0]&0x07)<<4)|(e->col&0x0F);
+    } else if(e->mode==2 && c[0]>=0xB0 && c[0]<=0xB7) {	// page mode, page start
+        e->page=c[0]&0x07;
+    }
+    // other commands change how RAM is shown, not what it holds
+}
+
+static void ssd1306_emu_command_byte(ssd1306_emu_t *e, uint8_t b) {
+    if(e->cmd_args) {
+        e->cmd[e->cmd_len++]=b;
+        if(--e->cmd_args)
+            return;
+    } else {
+        e->cmd[0]=b;
+        e->cmd_len=1;
+        if((e->cmd_args=ssd1306_emu_args(b)))
+            return;
+    }
+    ssd1306_emu_command(e);
+}
+
+static void ssd1306_emu_data_byte(ssd1306_emu_t *e, uint8_t b) {
+    e->gram[e->page][e->col]=b;
+    ++e->data_bytes;
+
+    switch(e->mode) {
+    case 0:	// horizontal: columns of the window, then next page
+        if(e->col==e->col_end) {
+            e->col=e->col_start;
+            e->page=e->page==e->page_end ? e->page_start : (e->page+1)&0x07;
+        } else {
+            e->col=(e->col+1)&0x7F;
+        }
+        break;
+    case 1:	// vertical: pages of the window, then next column
+        if(e->page==e->page_end) {
+            e->page=e->page_start;
+            e->col=e->col==e->col_end ? e->col_start : (e->col+1)&0x7F;
+        } else {
+            e->page=(e->page+1)&0x07;
+        }
+        break;
+    default:	// page: wraps within the page
+        e->col=(e->col+1)&0x7F;
+        break;
+    }
+}
+
+void ssd1306_emu_reset_counters(ssd1306_emu_t *e) {
+    e->bytes=0;
+    e->transfers=0;
+    e->data_bytes=0;
+}
+
+void ssd1306_emu_reset(ssd1306_emu_t *e) {
+    memset(e, 0, sizeof(*e));
+    e->mode=2;
+    e->col_end=SSD1306_EMU_COLUMNS-1;
+    e->page_end=SSD1306_MAX_PAGES-1;
+}
+
+void ssd1306_emu_write(ssd1306_emu_t *e, const uint8_t *src, size_t len) {
+    ++e->transfers;
+    e->bytes+=len+1;
+    if(!len)
+        return;
+
+    // control byte: Co (bit 7) means one byte follows, then another control byte; D/C# (bit 6) selects data
+    uint8_t control=src[0];
+    for(size_t i=1; i<len; ) {
+        if(control&0x40)
+            ssd1306_emu_data_byte(e, src[i++]);
+        else
+            ssd1306_emu_command_byte(e, src[i++]);
+
+        if((control&0x80) && i<len)
+            control=src[i++];
+    }
+}
+
+// 64 wide panels are wired to the middle columns of display RAM, as in ssd1306_window_prefix
+static uint32_t ssd1306_emu_offset(uint32_t width) {
+    return width==64 ? 32 : 0;
+}
+
+bool ssd1306_emu_matches(const ssd1306_emu_t *e, const ssd1306_t *p) {
+    uint32_t offset=ssd1306_emu_offset(p->width);
+
+    for(uint32_t page=0; page<p->pages; ++page) {
+        if(memcmp(e->gram[page]+offset, p->buffer+page*p->width, p->width))
+            return false;
+    }
+    return true;
+}
+
+void ssd1306_emu_dump(const ssd1306_emu_t *e, FILE *f, uint32_t width, uint32_t height) {
+    uint8_t pages[SSD1306_MAX_PAGES*SSD1306_EMU_COLUMNS];
+    uint32_t offset;
+
+    width=width<SSD1306_EMU_COLUMNS ? width : SSD1306_EMU_COLUMNS;
+    height=height<8*SSD1306_MAX_PAGES ? height : 8*SSD1306_MAX_PAGES;
+    offset=ssd1306_emu_offset(width);
+    for(uint32_t page=0; page<(height+7)/8; ++page)
+        memcpy(pages+page*width, e->gram[page]+offset, width);
+
+    ssd1306_write_pbm(f, pages, width, height);
+}
+
+static void ssd1306_emu_transport_write(ssd1306_t *p, const uint8_t *src, size_t len) {
+    ssd1306_emu_write(p->transport_ctx, src, len);
+}
+
+static int ssd1306_emu_begin(ssd1306_t *p) {
+    (void) p;
+    return 1;
+}
+
+// Each queued transfer is decoded right away, as if the bus were infinitely fast
+static void ssd1306_emu_queue(ssd1306_t *p, const uint8_t *prefix, size_t prefix_len, const uint8_t *src, size_t len) {
+    ssd1306_emu_t *e=p->transport_ctx;
+    uint8_t transfer[SSD1306_PREFIX+SSD1306_MAX_PAGES*SSD1306_EMU_COLUMNS];
+
+    if(prefix_len+len>sizeof(transfer))
+        return;
+    memcpy(transfer, prefix, prefix_len);
+    memcpy(transfer+prefix_len, src, len);
+    ssd1306_emu_write(e, transfer, prefix_len+len);
+}
+
+static void ssd1306_emu_start(ssd1306_t *p) {
+    if(p->callback)
+        p->callback(p, p->callback_ctx);
+}
+
+const ssd1306_transport_t ssd1306_transport_emu= {
+    .write=ssd1306_emu_transport_write,
+    .begin=ssd1306_emu_begin,
+    .queue=ssd1306_emu_queue,
+    .start=ssd1306_emu_start,
+};
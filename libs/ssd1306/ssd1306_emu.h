@@ -0,0 +1,127 @@
+/*
+MIT License
+
+Copyright (c) 2021 David Schramm
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/** 
+* @file ssd1306_emu.h
+* 
+* ssd1306 emulator, a transport that decodes the command and data stream
+* into an emulated display RAM, to check and measure output without hardware.
+*
+* builds on the host, without the sdk:
+*   cc -DSSD1306_HOST -Ilibs/ssd1306 prog.c libs/ssd1306/ssd1306.c libs/ssd1306/ssd1306_emu.c
+*/
+
+#ifndef _inc_ssd1306_emu
+#define _inc_ssd1306_emu
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ssd1306.h"
+
+/**
+*	@brief columns of the controller display RAM
+*/
+#define SSD1306_EMU_COLUMNS 128
+
+/**
+*	@brief state of the emulated controller, passed as transport_ctx
+*/
+typedef struct {
+    uint8_t gram[SSD1306_MAX_PAGES][SSD1306_EMU_COLUMNS];	/**< display RAM, one byte per column of a page */
+    uint8_t mode;		/**< memory addressing mode: 0 horizontal, 1 vertical, 2 page */
+    uint8_t col;		/**< column pointer */
+    uint8_t page;		/**< page pointer */
+    uint8_t col_start;	/**< column window, horizontal and vertical modes */
+    uint8_t col_end;
+    uint8_t page_start;	/**< page window, horizontal and vertical modes */
+    uint8_t page_end;
+    uint8_t cmd[7];		/**< command being received, with its arguments */
+    uint8_t cmd_len;	/**< bytes of cmd received */
+    uint8_t cmd_args;	/**< arguments still expected */
+    bool display_on;	/**< SET_DISP | 0x01 received */
+    uint32_t bytes;		/**< bytes on the bus, counting the address byte of each transfer */
+    uint32_t transfers;	/**< transfers, one start/stop each */
+    uint32_t data_bytes;	/**< bytes written to the display RAM */
+} ssd1306_emu_t;
+
+/**
+*	@brief decodes every transfer into the ssd1306_emu_t in transport_ctx
+*
+*	asynchronous shows are decoded when started, then the callback is called,
+*	for empty frames too
+*/
+extern const ssd1306_transport_t ssd1306_transport_emu;
+
+/**
+*	@brief put emulated controller in its reset state, display RAM cleared and counters zeroed
+*
+*	@param[in] e : emulator
+*/
+void ssd1306_emu_reset(ssd1306_emu_t *e);
+
+/**
+*	@brief zero bus counters, e.g. before measuring one frame
+*
+*	@param[in] e : emulator
+*/
+void ssd1306_emu_reset_counters(ssd1306_emu_t *e);
+
+/**
+*	@brief decode one transfer, control byte(s) included
+*
+*	@param[in] e : emulator
+*	@param[in] src : bytes of the transfer
+*	@param[in] len : length of src
+*/
+void ssd1306_emu_write(ssd1306_emu_t *e, const uint8_t *src, size_t len);
+
+/**
+*	@brief whether display RAM holds the buffer of p, i.e. everything drawn has been shown
+*
+*	64 wide panels are compared with columns 32 to 95, where the driver draws them
+*
+*	@param[in] e : emulator
+*	@param[in] p : instance of display
+*
+*	@return bool.
+*	@retval true if every page of p matches
+*/
+bool ssd1306_emu_matches(const ssd1306_emu_t *e, const ssd1306_t *p);
+
+/**
+*	@brief write width x height pixels of display RAM as a binary PBM image
+*
+*	the pixels of a panel that wide: a 64 wide image starts at column 32, like ssd1306_emu_matches
+*
+*	@param[in] e : emulator
+*	@param[in] f : file opened for binary writing
+*	@param[in] width : width of image, at most SSD1306_EMU_COLUMNS
+*	@param[in] height : height of image, at most 8*SSD1306_MAX_PAGES
+*/
+void ssd1306_emu_dump(const ssd1306_emu_t *e, FILE *f, uint32_t width, uint32_t height);
+
+#endif
@@ -0,0 +1,203 @@
+/*
+
+MIT License
+
+Copyright (c) 2021 David Schramm
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "ssd1306.h"
+
+// State of ssd1306_transport_i2c_dma, in transport_state once an asynchronous show is used
+typedef struct {
+    int dma_chan;		// dma channel feeding the i2c tx fifo
+    size_t len;			// number of words queued
+    uint16_t words[];	// i2c data/command words of the frame in flight
+} ssd1306_i2c_dma_t;
+
+// Owner of each dma channel used by an asynchronous show, for the interrupt handler
+static ssd1306_t *dma_owner[NUM_DMA_CHANNELS];
+
+inline static void fancy_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, char *name) {
+    switch(i2c_write_blocking(i2c, addr, src, len, false)) {
+    case PICO_ERROR_GENERIC:
+        printf("[%s] addr not acknowledged!\n", name);
+        break;
+    case PICO_ERROR_TIMEOUT:
+        printf("[%s] timeout!\n", name);
+        break;
+    default:
+        //printf("[%s] wrote successfully %lu bytes!\n", name, len);
+        break;
+    }
+}
+
+static void ssd1306_i2c_write(ssd1306_t *p, const uint8_t *src, size_t len) {
+    fancy_write(p->transport_ctx, p->address, src, len, "ssd1306_write");
+}
+
+static bool ssd1306_i2c_dma_busy(ssd1306_t *p) {
+    ssd1306_i2c_dma_t *s=p->transport_state;
+    if(!s)
+        return false;
+    if(dma_channel_is_busy(s->dma_chan))
+        return true;
+
+    i2c_hw_t *hw=i2c_get_hw(p->transport_ctx);
+    if(!(hw->status & I2C_IC_STATUS_TFE_BITS) || (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS))
+        return true;
+
+    // a nack flushes the fifo, the rest of the frame is dropped
+    if(hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        (void) hw->clr_tx_abrt;
+        printf("[ssd1306_show_async] addr not acknowledged!\n");
+    }
+    return false;
+}
+
+static void ssd1306_i2c_dma_irq_handler(void) {
+    for(uint ch=0; ch<NUM_DMA_CHANNELS; ++ch) {
+        ssd1306_t *p=dma_owner[ch];
+        if(p && dma_channel_get_irq0_status(ch)) {
+            dma_channel_acknowledge_irq0(ch);
+            if(p->callback)
+                p->callback(p, p->callback_ctx);
+        }
+    }
+}
+
+// Claims the dma channel and allocates the stream on first use
+static bool ssd1306_i2c_dma_setup(ssd1306_t *p) {
+    static bool irq_installed=false;
+
+    if(p->transport_state)
+        return true;
+
+    // at most one window per page, each with its commands, plus the buffer itself
+    size_t words=p->pages*SSD1306_PREFIX+p->bufsize;
+    ssd1306_i2c_dma_t *s=malloc(sizeof(ssd1306_i2c_dma_t)+words*sizeof(uint16_t));
+    if(s==NULL)
+        return false;
+
+    int ch=dma_claim_unused_channel(false);
+    if(ch<0) {
+        free(s);
+        return false;
+    }
+
+    if(!irq_installed) {
+        irq_add_shared_handler(DMA_IRQ_0, ssd1306_i2c_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        irq_installed=true;
+    }
+
+    s->dma_chan=ch;
+    s->len=0;
+    p->transport_state=s;
+    dma_owner[ch]=p;
+    dma_channel_set_irq0_enabled(ch, true);
+    return true;
+}
+
+static int ssd1306_i2c_dma_begin(ssd1306_t *p) {
+    ssd1306_i2c_dma_t *s=p->transport_state;
+    if(s && dma_channel_is_busy(s->dma_chan))
+        return 0;
+
+    if(!ssd1306_i2c_dma_setup(p))
+        return -1;
+
+    ((ssd1306_i2c_dma_t *) p->transport_state)->len=0;
+    return 1;
+}
+
+// Appends one i2c write to the stream, with a stop after the last byte
+static void ssd1306_i2c_dma_queue(ssd1306_t *p, const uint8_t *prefix, size_t prefix_len, const uint8_t *src, size_t len) {
+    ssd1306_i2c_dma_t *s=p->transport_state;
+    uint16_t *w=s->words+s->len;
+    for(size_t i=0; i<prefix_len; ++i)
+        *(w++)=prefix[i];
+    for(size_t i=0; i<len; ++i)
+        *(w++)=src[i];
+    *(w-1)|=I2C_IC_DATA_CMD_STOP_BITS;
+    s->len+=prefix_len+len;
+}
+
+static void ssd1306_i2c_dma_start(ssd1306_t *p) {
+    ssd1306_i2c_dma_t *s=p->transport_state;
+
+    // nothing changed: the frame is done already, as with the emulator
+    if(!s->len) {
+        if(p->callback)
+            p->callback(p, p->callback_ctx);
+        return;
+    }
+
+    // the last words of the previous frame may still be in the fifo
+    ssd1306_wait(p);
+
+    i2c_hw_t *hw=i2c_get_hw(p->transport_ctx);
+    hw->enable=0;
+    hw->tar=p->address;
+    hw->enable=1;
+    hw->dma_cr=I2C_IC_DMA_CR_TDMAE_BITS;
+
+    dma_channel_config c=dma_channel_get_default_config(s->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(p->transport_ctx, true));
+    dma_channel_configure(s->dma_chan, &c, &hw->data_cmd, s->words, s->len, true);
+}
+
+static void ssd1306_i2c_dma_release(ssd1306_t *p) {
+    ssd1306_i2c_dma_t *s=p->transport_state;
+    if(!s)
+        return;
+
+    dma_channel_set_irq0_enabled(s->dma_chan, false);
+    dma_owner[s->dma_chan]=NULL;
+    dma_channel_unclaim(s->dma_chan);
+    free(s);
+}
+
+const ssd1306_transport_t ssd1306_transport_i2c= {
+    .write=ssd1306_i2c_write,
+};
+
+const ssd1306_transport_t ssd1306_transport_i2c_dma= {
+    .write=ssd1306_i2c_write,
+    .begin=ssd1306_i2c_dma_begin,
+    .queue=ssd1306_i2c_dma_queue,
+    .start=ssd1306_i2c_dma_start,
+    .busy=ssd1306_i2c_dma_busy,
+    .release=ssd1306_i2c_dma_release,
+};
+
+bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance) {
+    return ssd1306_init_with_transport(p, width, height, address, &ssd1306_transport_i2c_dma, i2c_instance);
+}
@@ -0,0 +1,69 @@
+/*
+MIT License
+
+Copyright (c) 2021 David Schramm
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** 
+* @file ssd1306_i2c.h
+* 
+* i2c transports for ssd1306 displays
+*/
+
+#ifndef _inc_ssd1306_i2c
+#define _inc_ssd1306_i2c
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+
+#include "ssd1306.h"
+
+/**
+*	@brief blocking i2c, ssd1306_show_async sends the frame before returning
+*
+*	transport_ctx is the i2c_inst_t of the bus
+*/
+extern const ssd1306_transport_t ssd1306_transport_i2c;
+
+/**
+*	@brief blocking i2c, plus dma for ssd1306_show_async
+*
+*	a dma channel and a copy of the frame (about 2.2 KB for 128x64) are
+*	claimed on the first asynchronous show, and released by ssd1306_deinit.
+*	transport_ctx is the i2c_inst_t of the bus
+*/
+extern const ssd1306_transport_t ssd1306_transport_i2c_dma;
+
+/**
+*	@brief initialize display on an i2c bus, using ssd1306_transport_i2c_dma
+*
+*	@param[in] p : pointer to instance of ssd1306_t
+*	@param[in] width : width of display
+*	@param[in] height : heigth of display
+*	@param[in] address : i2c address of display
+*	@param[in] i2c_instance : instance of i2c connection
+*	
+* 	@return bool.
+*	@retval true for Success
+*	@retval false if initialization failed
+*/
+bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance);
+
+#endif
@@ -1,7 +1,7 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
-#include "ssd1306/ssd1306.h"
+#include "ssd1306.h"
 
 // Definição de pinos e canal I2C
 #define I2C_PORT i2c1